@@ -0,0 +1,425 @@
+#ifndef ARDUINO
+
+#include "PosixSerial.h"
+
+#include<errno.h>
+#include<fcntl.h>
+#include<poll.h>
+#include<stdio.h>
+#include<sys/ioctl.h>
+#include<termios.h>
+#include<time.h>
+#include<unistd.h>
+
+static uint64_t monotonicMicros(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static const uint64_t startMicros = monotonicMicros();
+
+/**
+ * @brief      Same as the arduino millis(). Counts from program start and wraps at 32 bits in the same way.
+ */
+uint32_t millis(){
+    return (uint32_t)((monotonicMicros() - startMicros) / 1000);
+}
+
+/**
+ * @brief      Same as the arduino micros(). Counts from program start and wraps at 32 bits in the same way.
+ */
+uint32_t micros(){
+    return (uint32_t)(monotonicMicros() - startMicros);
+}
+
+/**
+ * @brief      Maps a baudrate to the matching termios speed constant.
+ *
+ * @param[in]  baudrate  The baudrate
+ *
+ * @return     The speed_t constant or B0 if the rate has no standard constant.
+ */
+static speed_t toSpeed(uint32_t baudrate){
+    switch(baudrate){
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+    #ifdef B460800
+        case 460800: return B460800;
+    #endif
+    #ifdef B500000
+        case 500000: return B500000;
+    #endif
+    #ifdef B921600
+        case 921600: return B921600;
+    #endif
+    #ifdef B1000000
+        case 1000000: return B1000000;
+    #endif
+    #ifdef B2000000
+        case 2000000: return B2000000;
+    #endif
+        default: return B0;
+    }
+}
+
+/**
+ * @brief      Wraps a file descriptor that is already open, for example one end of a pty pair. The descriptor is not closed when the object is destroyed.
+ *
+ * @param[in]  fd    The file descriptor
+ */
+PosixSerial::PosixSerial(int fd){
+    this->fd = fd;
+}
+
+/**
+ * @brief      Opens a serial device such as /dev/ttyUSB0. The port is closed again when the object is destroyed. Use isOpen() to see whether it worked.
+ *
+ * @param[in]  path  The path of the device
+ */
+PosixSerial::PosixSerial(const char* path){
+    fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    ownsFd = fd >= 0;
+}
+
+/**
+ * @brief      Destroys the object and closes the port if it was opened by this class.
+ */
+PosixSerial::~PosixSerial(){
+    if(ownsFd){
+        close(fd);
+    }
+}
+
+/**
+ * @brief      Equivalent of HardwareSerial.begin(). Puts the descriptor in non-blocking mode and, if it is a tty, into raw mode at the requested baudrate. Rates without a standard termios constant (such as the default 250000) leave the line speed as it is. Pty pairs ignore the line speed anyway.
+ *
+ * @param[in]  baudrate  The baudrate
+ */
+void PosixSerial::begin(uint32_t baudrate){
+    if(fd < 0){
+        return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    struct termios tio;
+    if(tcgetattr(fd, &tio) == 0){
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        speed_t speed = toSpeed(baudrate);
+        if(speed != B0){
+            cfsetispeed(&tio, speed);
+            cfsetospeed(&tio, speed);
+        }
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    rxHead = rxTail = 0;
+    this->baudrate = baudrate;
+    txBacklog = 0;
+}
+
+/**
+ * @brief      Equivalent of HardwareSerial.end(). Waits for pending output to be sent and drops any buffered input.
+ */
+void PosixSerial::end(){
+    if(fd >= 0){
+        tcdrain(fd);
+    }
+    rxHead = rxTail = 0;
+}
+
+/**
+ * @brief      Same as HardwareSerial.flush(). Waits until everything written has been sent.
+ */
+void PosixSerial::flush(){
+    if(fd >= 0){
+        tcdrain(fd);
+    }
+}
+
+/**
+ * @brief      Determines if the file descriptor is valid.
+ *
+ * @return     True if open, False otherwise.
+ */
+bool PosixSerial::isOpen(){
+    return fd >= 0;
+}
+
+/**
+ * @brief      Gets the file descriptor so that it can be added to a poll() or epoll set.
+ *
+ * @return     The file descriptor.
+ */
+int PosixSerial::getFd(){
+    return fd;
+}
+
+/**
+ * @brief      Refills the receive buffer with one non-blocking read() once everything in it has been handed out.
+ *
+ * @return     True if there are chars in the buffer.
+ */
+bool PosixSerial::fill(){
+    if(rxHead < rxTail){
+        return true;
+    }
+    rxHead = rxTail = 0;
+    ssize_t n = ::read(fd, rxBuffer, POSIXSERIAL_RX_CHUNK);
+    if(n > 0){
+        rxTail = n;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief      Same as HardwareSerial.available(). Never blocks.
+ *
+ * @return     The number of chars that can be read straight away.
+ */
+int PosixSerial::available(){
+    fill();
+    return rxTail - rxHead;
+}
+
+/**
+ * @brief      Same as HardwareSerial.read(). Never blocks.
+ *
+ * @return     The next char or -1 if there is nothing to read.
+ */
+int PosixSerial::read(){
+    if(!fill()){
+        return -1;
+    }
+    return (uint8_t)rxBuffer[rxHead++];
+}
+
+/**
+ * @brief      Same as HardwareSerial.peek(). Never blocks.
+ *
+ * @return     The next char without removing it or -1 if there is nothing to read.
+ */
+int PosixSerial::peek(){
+    if(!fill()){
+        return -1;
+    }
+    return (uint8_t)rxBuffer[rxHead];
+}
+
+/**
+ * @brief      Sleeps in poll() until there is something to read or the timeout runs out. Returns straight away if chars are already buffered.
+ *
+ * @param[in]  timeoutMs  The timeout in ms. -1 waits forever.
+ *
+ * @return     True if there is something to read.
+ */
+bool PosixSerial::waitReadable(int timeoutMs){
+    if(rxHead < rxTail){
+        return true;
+    }
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    int n;
+    do{
+        n = poll(&pfd, 1, timeoutMs);
+    } while(n < 0 && errno == EINTR);
+    return n > 0 && (pfd.revents & POLLIN);
+}
+
+/**
+ * @brief      Equivalent of HardwareSerial.availableForWrite(): how many chars can be written before a POSIXSERIAL_TX_BUFFER sized transmit buffer is full. The chars still waiting are what the kernel says are in its output queue, or if more, what the baudrate says can't have been sent yet since the last write. The second covers ptys and USB adapters, which report nothing waiting.
+ *
+ * @return     The number of chars.
+ */
+int PosixSerial::availableForWrite(){
+    uint32_t pending = linePending();
+    int queued = 0;
+    if(fd >= 0 && ioctl(fd, TIOCOUTQ, &queued) == 0 && queued > (int)pending){
+        pending = queued;
+    }
+    return pending >= POSIXSERIAL_TX_BUFFER ? 0 : POSIXSERIAL_TX_BUFFER - pending;
+}
+
+/**
+ * @brief      Works out how many of the chars written are still being sent, at 10 bits a char.
+ */
+uint32_t PosixSerial::linePending(){
+    if(!baudrate || !txBacklog){
+        return 0;
+    }
+    uint32_t sent = (uint64_t)(micros() - txBacklogMicros) * baudrate / 10000000;
+    return sent >= txBacklog ? 0 : txBacklog - sent;
+}
+
+/**
+ * @brief      Same as HardwareSerial.write(). As with the arduino, this blocks while the output buffer is full.
+ *
+ * @param[in]  c     The char to send
+ *
+ * @return     The number of chars sent.
+ */
+size_t PosixSerial::write(uint8_t c){
+    return write((const char*)&c, 1);
+}
+
+/**
+ * @brief      Sends a buffer with as few write() calls as the kernel allows. As with the arduino, this blocks while the output buffer is full.
+ *
+ * @param      buffer  The chars to send
+ * @param[in]  len     The number of chars
+ *
+ * @return     The number of chars sent.
+ */
+size_t PosixSerial::write(const char* buffer, size_t len){
+    size_t sent = 0;
+    while(sent < len){
+        ssize_t n = ::write(fd, buffer + sent, len - sent);
+        if(n > 0){
+            sent += n;
+        }
+        else if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            poll(&pfd, 1, -1);
+        }
+        else if(n < 0 && errno == EINTR){
+            continue;
+        }
+        else{
+            break;
+        }
+    }
+    txBacklog = linePending() + sent;
+    txBacklogMicros = micros();
+    return sent;
+}
+
+void PosixSerial::printUnsigned(uint32_t n){
+    char buffer[11];
+    int len = snprintf(buffer, sizeof(buffer), "%lu", (unsigned long)n);
+    write(buffer, len);
+}
+
+void PosixSerial::printSigned(int32_t n){
+    char buffer[12];
+    int len = snprintf(buffer, sizeof(buffer), "%ld", (long)n);
+    write(buffer, len);
+}
+
+/**
+ * @brief      Prints with two decimal places, the same as the arduino Print class does by default.
+ */
+void PosixSerial::printFloat(double n){
+    char buffer[48];
+    int len = snprintf(buffer, sizeof(buffer), "%.2f", n);
+    write(buffer, len);
+}
+
+void PosixSerial::print(const char* message){
+    write(message, strlen(message));
+}
+
+void PosixSerial::print(const __FlashStringHelper* message){
+    print((const char*)message);
+}
+
+void PosixSerial::print(char c){
+    write((uint8_t)c);
+}
+
+void PosixSerial::print(uint8_t n){
+    printUnsigned(n);
+}
+
+void PosixSerial::print(uint16_t n){
+    printUnsigned(n);
+}
+
+void PosixSerial::print(uint32_t n){
+    printUnsigned(n);
+}
+
+void PosixSerial::print(int8_t n){
+    printSigned(n);
+}
+
+void PosixSerial::print(int16_t n){
+    printSigned(n);
+}
+
+void PosixSerial::print(int32_t n){
+    printSigned(n);
+}
+
+void PosixSerial::print(float n){
+    printFloat(n);
+}
+
+void PosixSerial::print(double n){
+    printFloat(n);
+}
+
+void PosixSerial::println(const char* message){
+    print(message);
+    println();
+}
+
+void PosixSerial::println(const __FlashStringHelper* message){
+    println((const char*)message);
+}
+
+void PosixSerial::println(char c){
+    print(c);
+    println();
+}
+
+void PosixSerial::println(uint8_t n){
+    print(n);
+    println();
+}
+
+void PosixSerial::println(uint16_t n){
+    print(n);
+    println();
+}
+
+void PosixSerial::println(uint32_t n){
+    print(n);
+    println();
+}
+
+void PosixSerial::println(int8_t n){
+    print(n);
+    println();
+}
+
+void PosixSerial::println(int16_t n){
+    print(n);
+    println();
+}
+
+void PosixSerial::println(int32_t n){
+    print(n);
+    println();
+}
+
+void PosixSerial::println(float n){
+    print(n);
+    println();
+}
+
+void PosixSerial::println(double n){
+    print(n);
+    println();
+}
+
+/**
+ * @brief      Sends \r\n, the same as the arduino println().
+ */
+void PosixSerial::println(){
+    write("\r\n", 2);
+}
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef POSIXSERIAL_H
+#define POSIXSERIAL_H
+
+#ifndef ARDUINO
+
+#include<stdint.h>
+#include<stddef.h>
+#include<math.h>
+#include<string.h>
+
+/**
+ * @brief      Size of the chunk read from the file descriptor in one go. Bytes are then handed to check() from this buffer so that a busy link costs one read() per chunk rather than one per char.
+ */
+#ifndef POSIXSERIAL_RX_CHUNK
+#define POSIXSERIAL_RX_CHUNK 4096
+#endif
+
+/**
+ * @brief      The size of transmit buffer that availableForWrite() reports room in, the same as an arduino's by default. Keeping it small keeps what an urgent frame has to wait behind small, see SerialChecker::enableTxQueue().
+ */
+#ifndef POSIXSERIAL_TX_BUFFER
+#define POSIXSERIAL_TX_BUFFER 64
+#endif
+
+/**
+ * @brief      Host side stand ins for the arduino timing functions so that the same code can be used on a PC. Both count from the first call. They return uint32_t, which is what an arduino's unsigned long is, so that differences such as micros() - start wrap the same way on both.
+ */
+uint32_t millis();
+uint32_t micros();
+
+/**
+ * @brief      On an arduino, F("...") and PROGMEM keep strings in flash so they do not use up RAM, and pgm_read_byte() reads them back. A PC has no separate flash, so here they are ordinary strings and the same sketches compile unchanged.
+ */
+class __FlashStringHelper;
+#ifndef F
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+#endif
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#endif
+
+/**
+ * @brief      PosixSerial lets SerialChecker run on a PC. It wraps a POSIX file descriptor, such as a termios tty (/dev/ttyUSB0, /dev/ttyACM0) or one end of a pty pair, and offers the same methods as the arduino HardwareSerial class that SerialChecker uses.
+ *              Reads are non-blocking. available() pulls in as many bytes as are waiting, up to POSIXSERIAL_RX_CHUNK, with a single read() call. waitReadable() uses poll() so the caller can sleep until data arrives rather than spinning on check().
+ */
+class PosixSerial{
+public:
+    PosixSerial(int fd);
+    PosixSerial(const char* path);
+    ~PosixSerial();
+    void begin(uint32_t baudrate);
+    void end();
+    void flush();
+    bool isOpen();
+    int getFd();
+    int available();
+    int read();
+    int peek();
+    bool waitReadable(int timeoutMs);
+    int availableForWrite();
+    size_t write(uint8_t c);
+    size_t write(const char* buffer, size_t len);
+    void print(const char* message);
+    void print(const __FlashStringHelper* message);
+    void print(char c);
+    void print(uint8_t n);
+    void print(uint16_t n);
+    void print(uint32_t n);
+    void print(int8_t n);
+    void print(int16_t n);
+    void print(int32_t n);
+    void print(float n);
+    void print(double n);
+
+    void println(const char* message);
+    void println(const __FlashStringHelper* message);
+    void println(char c);
+    void println(uint8_t n);
+    void println(uint16_t n);
+    void println(uint32_t n);
+    void println(int8_t n);
+    void println(int16_t n);
+    void println(int32_t n);
+    void println(float n);
+    void println(double n);
+    void println();
+private:
+    int fd = -1;
+    bool ownsFd = false;
+    char rxBuffer[POSIXSERIAL_RX_CHUNK];
+    uint16_t rxHead = 0; // next char to hand out
+    uint16_t rxTail = 0; // one past the last valid char
+    uint32_t baudrate = 0;
+    uint32_t txBacklog = 0; // chars still on the line after the last write, as far as the baudrate says
+    uint32_t txBacklogMicros = 0; // when the last write was
+
+    bool fill();
+    uint32_t linePending();
+    void printUnsigned(uint32_t n);
+    void printSigned(int32_t n);
+    void printFloat(double n);
+};
+
+#endif
+
+#endif
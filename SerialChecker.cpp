@@ -19,10 +19,11 @@
 //     this->serialType = serialTypes::HardWare;
 //     this->port.hardware = &Serial;
 // }
+#ifdef ARDUINO
 SerialChecker::SerialChecker(HardwareSerial& port){
     serialType = serialTypes::HardWare;
     this->port.hardware = &port;
-    rawMessage = new char[msgMaxLen];
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
     message = rawMessage;
 }
 
@@ -37,7 +38,7 @@ SerialChecker::SerialChecker(HardwareSerial& port, uint32_t baudrate){
     this->serialType = serialTypes::HardWare;
     this->port.hardware = &port;
     this->baudrate = baudrate;
-    rawMessage = new char[msgMaxLen];
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
     message = rawMessage;
     
 }
@@ -50,9 +51,66 @@ SerialChecker::SerialChecker(HardwareSerial& port, uint32_t baudrate){
  * @param[in]  baudrate   The baudrate
  */
 SerialChecker::SerialChecker(uint16_t msgMaxLen, HardwareSerial& HSerial, uint32_t baudrate){
+    this->serialType = serialTypes::HardWare;
+    this->port.hardware = &HSerial;
+    this->msgMaxLen = msgMaxLen;
+    this->baudrate = baudrate;
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
+    message = rawMessage;
+}
+#else
+/**
+ * @brief      Constructs the object for use on a PC. Dynamically creates a char array to hold message buffers. The port wraps a tty or pty file descriptor, see PosixSerial.
+ *
+ * @param      port  The PosixSerial port.
+ */
+SerialChecker::SerialChecker(PosixSerial& port){
+    serialType = serialTypes::POSIX;
+    this->port.posix = &port;
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
+    message = rawMessage;
+}
+
+/**
+ * @brief      Constructs the object. As above but lets user choose the baudrate.
+ *
+ * @param      port      The PosixSerial port.
+ * @param[in]  baudrate  The baudrate
+ */
+SerialChecker::SerialChecker(PosixSerial& port, uint32_t baudrate){
+    serialType = serialTypes::POSIX;
+    this->port.posix = &port;
+    this->baudrate = baudrate;
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
+    message = rawMessage;
+}
+
+/**
+ * @brief      Constructs the object. As above but lets user choose the message maximum length and baudrate.
+ *
+ * @param[in]  msgMaxLen  The message maximum length
+ * @param      port       The PosixSerial port.
+ * @param[in]  baudrate   The baudrate
+ */
+SerialChecker::SerialChecker(uint16_t msgMaxLen, PosixSerial& port, uint32_t baudrate){
+    serialType = serialTypes::POSIX;
+    this->port.posix = &port;
     this->msgMaxLen = msgMaxLen;
     this->baudrate = baudrate;
-    rawMessage = new char[msgMaxLen];
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
+    message = rawMessage;
+}
+#endif
+
+/**
+ * @brief      Constructs a checker that is not attached to a serial port. Chars are fed to it with checkChar() or whole messages are loaded with loadMsg() so that contains() and the number conversions can be used on them. Anything it would send, such as Naks, is dropped.
+ *
+ * @param[in]  msgMaxLen  The message maximum length
+ */
+SerialChecker::SerialChecker(uint16_t msgMaxLen){
+    serialType = serialTypes::NoPort;
+    this->msgMaxLen = msgMaxLen;
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
     message = rawMessage;
 }
 
@@ -61,17 +119,16 @@ SerialChecker::SerialChecker(uint16_t msgMaxLen, HardwareSerial& HSerial, uint32
 SerialChecker::SerialChecker(usb_serial_class& port){
     this->serialType = serialTypes::USB;
     this->port.usb = &port;
-    rawMessage = new char[msgMaxLen];
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
     message = rawMessage;
 }
 
 SerialChecker::SerialChecker(usb_serial_class& port, uint32_t baudrate) {
-    // this->msgMaxLen = msgMaxLen;
-    // this->HSerial = &HSerial;
     this->serialType = serialTypes::USB;
     this->port.usb = &port;
     this->baudrate = baudrate;
-    // message = new char[msgMaxLen];
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
+    message = rawMessage;
 }
 #endif
 
@@ -79,7 +136,7 @@ SerialChecker::SerialChecker(usb_serial_class& port, uint32_t baudrate) {
 SerialChecker::SerialChecker(Serial_& port){
     serialType = serialTypes::ATMEGAXXU4;
     this->port.atmegaXXu4 = &port;
-    rawMessage = new char[msgMaxLen];
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
     message = rawMessage;
 }
 
@@ -87,7 +144,7 @@ SerialChecker::SerialChecker(Serial_& port, uint32_t baudrate){
     this->serialType = serialTypes::ATMEGAXXU4;
     this->port.atmegaXXu4 = &port;
     this->baudrate = baudrate;
-    rawMessage = new char[msgMaxLen];
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
     message = rawMessage;
 }
 #endif
@@ -96,8 +153,20 @@ SerialChecker::SerialChecker(Serial_& port, uint32_t baudrate){
  * @brief      Destroys the object and frees the memory used by message buffer
  */
 SerialChecker::~SerialChecker(){
+    #if SERIALCHECKER_REPLY_CACHE
+    delete [] replyCache;
+    #endif
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    delete [] duplicates;
+    #endif
+    #if SERIALCHECKER_TX_QUEUES
+    delete [] txQueues;
+    #endif
     delete [] rawMessage;
     delete [] address;
+    #if SERIALCHECKER_ADDRESS_FILTER
+    clearAddresses();
+    #endif
 }
 
 /**
@@ -115,9 +184,69 @@ void SerialChecker::init(){
             port.atmegaXXu4->begin(baudrate);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->begin(baudrate);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->begin(baudrate);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief      Changes the baudrate of a port that is already running. Whatever has been written is sent at the old rate first, and any partly received message is dropped as the rest of it would arrive at the new rate. See SerialCheckerBaud.h for agreeing a new rate with the other end.
+ *
+ * @param[in]  baudrate  The new baudrate
+ */
+void SerialChecker::setBaudrate(uint32_t baudrate){
+    flush();
+    this->baudrate = baudrate;
+    msgIndex = 0;
+    init();
+}
+
+/**
+ * @brief      Gets the baudrate the port was last started at.
+ *
+ * @return     The baudrate.
+ */
+uint32_t SerialChecker::getBaudrate(){
+    return baudrate;
+}
+
+/**
+ * @brief      Same as Serial's .flush method. Waits until everything written has been sent.
+ */
+void SerialChecker::flush(){
+    switch (serialType) {
+    #ifdef USBserial_h_
+        case serialTypes::USB:
+            port.usb->flush();
+            break;
+    #endif
+    #ifdef USBCON
+        case serialTypes::ATMEGAXXU4:
+            port.atmegaXXu4->flush();
+            break;
+    #endif
+    #ifdef ARDUINO
+        case serialTypes::HardWare:
+            port.hardware->flush();
+            break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->flush();
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -234,6 +363,107 @@ bool SerialChecker::getAllowCR(){
     return allowCR;
 }
 
+/**
+ * @brief      Enables sequence numbers so that many messages can be sent without waiting for a reply to each one. Every frame then carries a two hex digit sequence number straight after the STX char (or at the start if STX is not used), before the address. The checksum covers it. sendFrame() numbers the frames it sends, check() takes the number off each received message so getMsg() and getRawMsg() are unchanged, and getSeqNum() gives it. sendAck() and sendNak() then send a frame holding the Ack or Nak char with the sequence number of the message being answered, so replies can be matched to their messages even if they come back in a different order. On the receiving side, isAck() and isNak() pick out these replies.
+ *
+ * Both ends must use sequence numbers. Remember that the message maximum length includes the two sequence number digits.
+ */
+void SerialChecker::enableSeqNum(){
+    useSeqNum = true;
+}
+
+/**
+ * @brief      Disables sequence numbers. This is the default.
+ */
+void SerialChecker::disableSeqNum(){
+    useSeqNum = false;
+}
+
+/**
+ * @brief      Gets the sequence number of the last message received, if enableSeqNum() is used.
+ *
+ * @return     The sequence number, or SERIALCHECKER_SEQ_NONE if the message was a Nak for a message that was too damaged to know its sequence number.
+ */
+uint8_t SerialChecker::getSeqNum(){
+    return seqNum;
+}
+
+/**
+ * @brief      Checks whether the last message received is an Ack, as sent by sendAck(). With enableSeqNum(), getSeqNum() says which message it is for. Batched Acks, see enableAckBatching(), are recognised too.
+ *
+ * @return     True if the message is the Ack char, on its own or followed by up to 8 hex digits.
+ */
+bool SerialChecker::isAck(){
+    if(rawMsgLen < 1 || rawMsgLen > 9 || rawMessage[0] != Ack){
+        return false;
+    }
+    for(uint8_t i = 1; i < rawMsgLen; i++){
+        if(hexDigitValue(rawMessage[i]) < 0){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief      Gets which messages the last Ack received is for, with enableSeqNum(). Bit 0 stands for the message with sequence number getSeqNum(), bit 1 for the next sequence number and so on. An Ack that is not batched only has bit 0 set.
+ *
+ * @return     The bitmap, or 0 if the last message is not an Ack.
+ */
+uint32_t SerialChecker::getAckBitmap(){
+    if(!isAck()){
+        return 0;
+    }
+    if(rawMsgLen == 1){
+        return 1;
+    }
+    uint32_t bitmap = 0;
+    for(uint8_t i = 1; i < rawMsgLen; i++){
+        bitmap = (bitmap << 4) | hexDigitValue(rawMessage[i]);
+    }
+    return bitmap;
+}
+
+/**
+ * @brief      Gets the number of messages that the last Ack received is for. This is 1 unless the sender uses enableAckBatching().
+ *
+ * @return     The number of messages Acked, or 0 if the last message is not an Ack.
+ */
+uint8_t SerialChecker::getAckCount(){
+    uint32_t value = getAckBitmap();
+    if(!useSeqNum){
+        return value; // without sequence numbers the hex is a count
+    }
+    uint8_t count = 0;
+    while(value){
+        count += value & 1;
+        value >>= 1;
+    }
+    return count;
+}
+
+/**
+ * @brief      Checks whether the last message received is a Nak, as sent by sendNak() or by check() on receiving a bad message. With enableSeqNum(), getSeqNum() says which message it is for.
+ *
+ * @return     True if the message is just the Nak char.
+ */
+bool SerialChecker::isNak(){
+    return rawMsgLen == 1 && rawMessage[0] == Nak;
+}
+
+#if SERIALCHECKER_MESSAGE_HOOK
+/**
+ * @brief      Gives check() a function to offer every message to before returning it. SerialCheckerRegisters uses this to answer get and set messages, so it doesn't normally need calling. Taking a function rather than the register table means builds that don't use registers don't link them in.
+ *
+ * @param[in]  hook     The function, or nullptr to return every message
+ * @param      context  Passed to the function
+ */
+void SerialChecker::setMessageHook(messageHook hook, void* context){
+    this->hook = hook;
+    this->hookContext = context;
+}
+#endif
+
 /**
  * @brief      Call this function as often as you like to check for new messages. Valid messages cause the function to return the length of received message. This is also available by calling getMsgLen(). If no message, or an incomplete message is received, tt transfers the partial message (any message not terminated by an ETX char) from the arduino's serial buffer to this class's message buffer and returns a 0. 
  * 
@@ -243,103 +473,82 @@ bool SerialChecker::getAllowCR(){
  * 
  * By default, the class does not use checksums but if enableChecksum() is used, the char preceding the ETX char must be a checksum char. A local checksum is calculated from the rest of the message and compared with the received checksum. If valid, the message length is returned, else a 0.
  * 
+ * If a SerialCheckerRegisters has been set up for this checker, get and set messages for its registers are answered here and never returned. See setMessageHook().
+ * 
  * If enableAckNak() is used, the check function will send back Nak chars in the event that the message received is not valid based on the above explained conditions. It is left to the user to send back Ack messages if they are needed using sendAck(). For example, a message might be received that sets a parameter. It might not make sense to send this back to the other device but sending an Ack char would notify the device that its message was received and successfully implemented. On the other hand, sendNak() can be used if the received set parameter is out of the allowed set range for example. 
  *
  * @return     A uint8_t value is returned representing the length of the message received, excluding the STX start char if used, the checksum char if used, or the ETX end char.
  */
 uint8_t SerialChecker::check(){
-    switch (serialType) {
+    return checkWith(readPort);
+}
+
+/**
+ * @brief      Does the work of check(), taking the chars from the port with the function given. Framing's check() passes one that calls its own checkChar(), so it goes through the same steps around each message as check() does.
+ *
+ * @param[in]  read  The function that feeds the chars waiting at the port to checkChar()
+ *
+ * @return     The length of the message received, or 0, as check().
+ */
+uint8_t SerialChecker::checkWith(messageReader read){
+    #if SERIALCHECKER_TX_QUEUES
+    if(txQueued){
+        serviceTx();
+    }
+    #endif
+    uint8_t len = 0;
+    do{
+        len = read(*this);
+    #if SERIALCHECKER_MESSAGE_HOOK
+        // Messages the hook deals with, such as register messages, are not returned and the next message is looked for, so the sketch only sees its own.
+    } while(len && hook && hook(hookContext));
+    #else
+    } while(false);
+    #endif
+    #if SERIALCHECKER_ACK_BATCHING
+    if(ackPendingCount){
+        // With no time limit the Acks go once all waiting chars have been read, which is when check() returns 0.
+        if(ackBatchMicros ? micros() - ackPendingSince >= ackBatchMicros : len == 0){
+            flushAcks();
+        }
+    }
+    #endif
+    return len;
+}
+
+/**
+ * @brief      The messageReader that check() uses, which feeds SerialChecker's own checkChar().
+ */
+uint8_t SerialChecker::readPort(SerialChecker& checker){
+    switch (checker.serialType) {
     #ifdef USBserial_h_
         case serialTypes::USB:
-            return checkUSBSerial();
-            break;
+            return checker.checkUSBSerial();
     #endif
     #ifdef USBCON
         case serialTypes::ATMEGAXXU4:
-            return checkATMEGAXXU4Serial();
-            break;
+            return checker.checkATMEGAXXU4Serial();
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
-            return checkHardwareSerial();
+            return checker.checkHardwareSerial();
+    #else
+        case serialTypes::POSIX:
+            return checker.checkPOSIXSerial();
+    #endif
+        case serialTypes::NoPort:
+        default:
             break;
     }
+    return 0;
 }
 
 #ifdef USBserial_h_
-uint8_t SerialChecker::checkUSBSerial()(){
+uint8_t SerialChecker::checkUSBSerial(){
     while(port.usb->available()) {
-        char in = port.usb->read();
-        // HSerial->println(in);
-        if(receiveStarted){
-            if(useSTX && in == STX){
-                msgIndex = 0;
-                // HSerial->println("STX");
-            }
-            else if(in != ETX && msgIndex < msgMaxLen){
-                //add to message
-                if((in != '\r') || allowCR){
-                    rawMessage[msgIndex] = in;
-                    msgIndex++;
-                }
-                // HSerial->println("Adding to message");
-            }
-            else if(in == ETX){
-                // message complete so calculate the checksum and compare it
-                // HSerial->println("ETX");
-                rawMessage[msgIndex] = '\0';
-                // HSerial->println(msgIndex);
-                if(msgIndex >= msgMinLen){ // make sure message is long enough
-                    // HSerial->println("Long enough");
-                    if(useChecksum){
-                        rawMsgLen = msgIndex - 1;
-                        char msgChecksum = rawMessage[rawMsgLen];
-                        rawMessage[rawMsgLen] = '\0';
-                        //HSerial->println(calcChecksum(message, rawMsgLen));
-                        if(msgChecksum == calcChecksum(rawMessage, rawMsgLen)){
-                            //parseMessage();
-                            msgIndex = 0;
-                            if(requireSTX){
-                                receiveStarted = false;
-                            }
-                            return rawMsgLen;
-                        }
-                        else if(useAckNak){
-                            port.usb->println(Nak);
-                        }
-                    }
-                    else{
-                        rawMsgLen = msgIndex;
-                        msgIndex = 0;
-                        if(requireSTX){
-                            receiveStarted = false;
-                        }
-                        return rawMsgLen;
-                    }
-                }
-                else if(useAckNak){
-                    port.usb->println(Nak);
-                }
-                // reset megIndex for next message
-                msgIndex = 0;
-            }
-            else{
-                // message too long so scrap it and start again.
-                msgIndex = 0;
-                // HSerial->println("Too long");
-                if(useAckNak){
-                    port.usb->println(Nak);
-                }
-            } 
-        }
-        else{
-            if(in == STX){
-                receiveStarted = true;
-            }
-            else if(in == '\n'){
-                if(useAckNak){
-                    port.usb->println(Nak);
-                }
-            }
+        uint8_t len = checkChar(port.usb->read());
+        if(len){
+            return len;
         }
     }
     return 0;
@@ -349,215 +558,554 @@ uint8_t SerialChecker::checkUSBSerial()(){
 #ifdef USBCON
 uint8_t SerialChecker::checkATMEGAXXU4Serial(){
     while(port.atmegaXXu4->available()) {
-        char in = port.atmegaXXu4->read();
-        // HSerial->println(in);
-        if(receiveStarted){
-            if(useSTX && in == STX){
-                msgIndex = 0;
-                // HSerial->println("STX");
-            }
-            else if(in != ETX && msgIndex < msgMaxLen){
-                //add to message
-                if((in != '\r') || allowCR){
-                    rawMessage[msgIndex] = in;
-                    msgIndex++;
-                }
-                // HSerial->println("Adding to message");
-            }
-            else if(in == ETX){
-                // message complete so calculate the checksum and compare it
-                // HSerial->println("ETX");
-                rawMessage[msgIndex] = '\0';
-                // HSerial->println(msgIndex);
-                if(msgIndex >= msgMinLen){ // make sure message is long enough
-                    // HSerial->println("Long enough");
-                    if(useChecksum){
-                        rawMsgLen = msgIndex - 1;
-                        char msgChecksum = rawMessage[rawMsgLen];
-                        rawMessage[rawMsgLen] = '\0';
-                        //HSerial->println(calcChecksum(message, rawMsgLen));
-                        if(msgChecksum == calcChecksum(rawMessage, rawMsgLen)){
-                            //parseMessage();
-                            msgIndex = 0;
-                            if(requireSTX){
-                                receiveStarted = false;
-                            }
-                            return rawMsgLen;
-                        }
-                        else if(useAckNak){
-                            port.atmegaXXu4->println(Nak);
-                        }
-                    }
-                    else{
-                        rawMsgLen = msgIndex;
-                        msgIndex = 0;
-                        if(requireSTX){
-                            receiveStarted = false;
-                        }
-                        return rawMsgLen;
-                    }
-                }
-                else if(useAckNak){
-                    port.atmegaXXu4->println(Nak);
-                }
-                // reset megIndex for next message
-                msgIndex = 0;
-            }
-            else{
-                // message too long so scrap it and start again.
-                msgIndex = 0;
-                // HSerial->println("Too long");
-                if(useAckNak){
-                    port.atmegaXXu4->println(Nak);
-                }
-            } 
-        }
-        else{
-            if(in == STX){
-                receiveStarted = true;
-            }
-            else if(in == '\n'){
-                if(useAckNak){
-                    port.atmegaXXu4->println(Nak);
-                }
-            }
+        uint8_t len = checkChar(port.atmegaXXu4->read());
+        if(len){
+            return len;
         }
     }
     return 0;
 }
 #endif
 
+#ifdef ARDUINO
 uint8_t SerialChecker::checkHardwareSerial(){
     while(port.hardware->available()) {
-        char in = port.hardware->read();
-        // HSerial->println(in);
-        if(receiveStarted){
-            if(useSTX && in == STX){
-                msgIndex = 0;
-                // HSerial->println("STX");
+        uint8_t len = checkChar(port.hardware->read());
+        if(len){
+            return len;
+        }
+    }
+    return 0;
+}
+#else
+uint8_t SerialChecker::checkPOSIXSerial(){
+    // available() refills from the file descriptor a whole chunk at a time so this loop only makes a system call once the previous chunk has been used up.
+    while(port.posix->available()) {
+        uint8_t len = checkChar(port.posix->read());
+        if(len){
+            return len;
+        }
+    }
+    return 0;
+}
+#endif
+
+/**
+ * @brief      Processes one received char. This is what check() calls for every char it takes from the serial port, so it does the STX, ETX, length and checksum checking and sends Naks if enableAckNak() is used. It can also be called directly to feed chars from somewhere other than the serial port, such as a log file.
+ *
+ * @param[in]  in    The received char
+ *
+ * @return     The length of the message if this char completed a valid message, otherwise 0. See check().
+ */
+uint8_t SerialChecker::checkChar(char in){
+    #if SERIALCHECKER_RECORDER
+    if(recBuffer){
+        record(recorderEntryEnum::ReceivedChar, in);
+    }
+    #endif
+    #if SERIALCHECKER_ADDRESS_FILTER
+    if(skipping){
+        // The message is for another address so nothing is stored until the next message starts.
+        if(in == ETX || (useSTX && in == STX)){
+            skipping = false;
+            if(in == ETX && requireSTX){
+                receiveStarted = false;
             }
-            else if(in != ETX && msgIndex < msgMaxLen){
-                //add to message
-                if((in != '\r') || allowCR){
-                    rawMessage[msgIndex] = in;
-                    msgIndex++;
+        }
+        return 0;
+    }
+    #endif
+    if(receiveStarted){
+        if(useSTX && in == STX){
+            msgIndex = 0;
+            #if SERIALCHECKER_ADDRESS_FILTER
+            addressKind = addressKindEnum::None;
+            #endif
+        }
+        else if(in != ETX && msgIndex < msgMaxLen){
+            //add to message
+            if((in != '\r') || allowCR){
+                rawMessage[msgIndex] = in;
+                msgIndex++;
+                #if SERIALCHECKER_ADDRESS_FILTER
+                if(addressCount && msgIndex == (useSeqNum ? 2 : 0) + addressLen){
+                    addressKind = lookupAddress(&rawMessage[msgIndex - addressLen]);
+                    if(addressKind == addressKindEnum::None){
+                        skipping = true;
+                        skippedCount++;
+                        msgIndex = 0;
+                    }
                 }
-                // HSerial->println("Adding to message");
+                #endif
+            }
+        }
+        else if(in == ETX){
+            #if SERIALCHECKER_ADDRESS_FILTER
+            if(msgIndex < (useSeqNum ? 2 : 0) + addressLen){
+                // It ended before its address, so the kind is still the last message's.
+                addressKind = addressKindEnum::None;
             }
-            else if(in == ETX){
-                // message complete so calculate the checksum and compare it
-                // HSerial->println("ETX");
-                rawMessage[msgIndex] = '\0';
-                // HSerial->println(msgIndex);
-                if(msgIndex >= msgMinLen){ // make sure message is long enough
-                    // HSerial->println("Long enough");
-                    if(useChecksum){
-                        rawMsgLen = msgIndex - 1;
-                        char msgChecksum = rawMessage[rawMsgLen];
-                        rawMessage[rawMsgLen] = '\0';
-                        //HSerial->println(calcChecksum(message, rawMsgLen));
-                        if(msgChecksum == calcChecksum(rawMessage, rawMsgLen)){
-                            //parseMessage();
-                            msgIndex = 0;
-                            if(requireSTX){
-                                receiveStarted = false;
-                            }
-                            getAddress(); // Call this to load the address in to the address array.
-                            return rawMsgLen;
-                        }
-                        else if(useAckNak){
-                            port.hardware->println(Nak);
-                        }
+            #endif
+            // message complete so calculate the checksum and compare it
+            rawMessage[msgIndex] = '\0';
+            if(msgIndex >= msgMinLen){ // make sure message is long enough
+                if(useChecksum){
+                    rawMsgLen = msgIndex - 1;
+                    char msgChecksum = rawMessage[rawMsgLen];
+                    rawMessage[rawMsgLen] = '\0';
+                    if(msgChecksum == calcChecksum(rawMessage, rawMsgLen)){
+                        return accept();
                     }
                     else{
-                        rawMsgLen = msgIndex;
-                        msgIndex = 0;
-                        if(requireSTX){
-                            receiveStarted = false;
-                        }
-                        getAddress(); // Call this to load the address in to the address array.
-                        return rawMsgLen;
+                        reject(frameErrorEnum::BadChecksum);
                     }
                 }
-                else if(useAckNak){
-                    port.hardware->println(Nak);
+                else{
+                    rawMsgLen = msgIndex;
+                    return accept();
                 }
-                // reset megIndex for next message
-                msgIndex = 0;
             }
             else{
-                // message too long so scrap it and start again.
-                msgIndex = 0;
-                // HSerial->println("Too long");
-                if(useAckNak){
-                    port.hardware->println(Nak);
-                }
-            } 
+                reject(frameErrorEnum::TooShort);
+            }
+            // reset megIndex for next message
+            msgIndex = 0;
         }
         else{
-            if(in == STX){
-                receiveStarted = true;
-            }
-            else if(in == '\n'){
-                if(useAckNak){
-                    port.hardware->println(Nak);
-                }
-            }
+            // message too long so scrap it and start again.
+            msgIndex = 0;
+            reject(frameErrorEnum::TooLong);
+        }
+    }
+    else{
+        #if SERIALCHECKER_ADDRESS_FILTER
+        addressKind = addressKindEnum::None; // whatever this is, it isn't the last message
+        #endif
+        if(in == STX){
+            receiveStarted = true;
+        }
+        else if(in == '\n'){
+            reject(frameErrorEnum::MissingSTX);
         }
     }
     return 0;
 }
 
-
 /**
- * @brief      Returns the address that the message was sent to as a c-style char string. Do not call this if the @addressLen variable is set to the default of zero.
+ * @brief      Deals with a message that has passed the length and checksum checks. If enableSeqNum() is used, the sequence number is taken off the front of the message here.
  *
- * @return     The address.
+ * @return     The length of the message, or 0 if the sequence number is not valid.
  */
-char* SerialChecker::getAddress(){
-    if(addressLen > 0){
-        for(uint8_t i = 0; i < addressLen; i++){
-            address[i] = rawMessage[i];
+uint8_t SerialChecker::accept(){
+    msgIndex = 0;
+    if(useSeqNum){
+        int8_t high = hexDigitValue(rawMessage[0]);
+        int8_t low = rawMsgLen >= 2 ? hexDigitValue(rawMessage[1]) : -1;
+        uint8_t received = (high << 4) | low;
+        if(high < 0 || low < 0 || (received >= SERIALCHECKER_SEQ_COUNT && received != SERIALCHECKER_SEQ_NONE)){
+            reject(frameErrorEnum::BadSeqNum);
+            return 0;
         }
-        address[addressLen] = '\0';
-        return address;
+        if(rawMsgLen == 2){
+            reject(frameErrorEnum::TooShort);
+            return 0;
+        }
+        seqNum = received;
+        rawMsgLen -= 2;
+        memmove(rawMessage, &rawMessage[2], rawMsgLen + 1);
     }
-    else{
-        return '\0';
+    if(requireSTX){
+        receiveStarted = false;
+    }
+    getAddress(); // Call this to load the address in to the address array.
+    #if SERIALCHECKER_RECORDER
+    if(recBuffer){
+        record(recorderEntryEnum::Event, (uint8_t)recorderEventEnum::Accepted);
     }
+    #endif
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    if(duplicates){
+        duplicateOpen = nullptr;
+        if(isDuplicate()){
+            return 0;
+        }
+    }
+    #endif
+    return rawMsgLen;
 }
 
 /**
- * @brief      Returns the address char. DO NOT USE THIS IF THE ADDRESS c-style string IS MORE THAN 1 CHAR LONG.
+ * @brief      Deals with a message that is being thrown away: remembers why for getLastError(), logs it if the recorder is on and sends a Nak if enableAckNak() is used, unless the message was sent to a group or broadcast address.
  *
- * @return     The address char.
+ * @param[in]  reason  The reason
  */
- char SerialChecker::getAddressChar(){
-    return *address;
- }
+void SerialChecker::reject(frameErrorEnum reason){
+    lastError = reason;
+    #if SERIALCHECKER_RECORDER
+    if(recBuffer){
+        record(recorderEntryEnum::Event, (uint8_t)reason);
+    }
+    #endif
+    #if SERIALCHECKER_ADDRESS_FILTER
+    if(addressKind == addressKindEnum::Group || addressKind == addressKindEnum::Broadcast){
+        return; // or every node would answer at once
+    }
+    #endif
+    if(useAckNak){
+        if(useSeqNum){
+            sendNak(SERIALCHECKER_SEQ_NONE); // the sequence number of a bad message can not be trusted
+        }
+        else{
+            sendNak();
+        }
+    }
+}
 
+#if SERIALCHECKER_DUPLICATE_FILTER
 /**
- * @brief      Gets the raw message. This is the full message including the address if there is one.
+ * @brief      Turns on the duplicate filter. When an Ack is lost the sender sends the same command again, and without this the sketch would carry it out twice, which for something like a relative move is dangerous. With it, check() remembers the last SERIALCHECKER_DUPLICATE_CACHE_SIZE messages and the replies sent to them, up to SERIALCHECKER_DUPLICATE_REPLY_LEN chars of sendAck() and sendFrame() replies. A message that arrives again within windowMillis is answered with the same reply and not returned by check(), so the sketch never sees it. A message that was Naked is forgotten, so that it can be sent again. A reply too long to keep is not sent again, though the repeat is still dropped. Everything sent from when a message is accepted until the next one is counts as its reply, so frames sent in between that aren't replies, such as streamed readings, can push it over the limit.
  *
- * @return     The raw message.
+ * Messages are matched on their sequence number, if enableSeqNum() is used, their length, their first SERIALCHECKER_DUPLICATE_MATCH_LEN chars and a 16 bit hash of their address and message, so two different messages are only taken for each other if all of these agree. They are looked up in a table of SERIALCHECKER_DUPLICATE_CACHE_SIZE slots by the hash, so a lookup takes the same time however many are remembered. Without sequence numbers the same command sent again on purpose within the window is dropped too, so use sequence numbers or keep the window shorter than the time between deliberate repeats.
+ *
+ * @param[in]  windowMillis  How long a message is remembered for, in milliseconds. Make it longer than the sender takes to give up sending again.
  */
-char* SerialChecker::getRawMsg(){
-    return rawMessage;
+void SerialChecker::enableDuplicateFilter(uint32_t windowMillis){
+    if(!duplicates){
+        duplicates = new DuplicateEntry[SERIALCHECKER_DUPLICATE_CACHE_SIZE]();
+    }
+    duplicateWindowMillis = windowMillis;
 }
 
 /**
- * @brief      Gets the raw message length. This is the length of the full message including the address if there is one.
- *
- * @return     The raw message length.
+ * @brief      Turns off the duplicate filter and forgets the messages it remembered. This is the default.
  */
-uint8_t SerialChecker::getRawMsgLen(){
-    return rawMsgLen;
+void SerialChecker::disableDuplicateFilter(){
+    delete [] duplicates;
+    duplicates = nullptr;
+    duplicateOpen = nullptr;
 }
 
 /**
- * @brief      Gets the contents of the message buffer. The message buffer is updated if new chars are received by check().
+ * @brief      Gets the number of repeated messages the duplicate filter has answered and dropped.
  *
- * @return     The message buffer which is null terminated.
+ * @return     The number of duplicates.
+ */
+uint32_t SerialChecker::getDuplicateCount(){
+    return duplicateCount;
+}
+
+/**
+ * @brief      Looks a message that has just been accepted up in the duplicate filter. A repeat is answered with the reply kept from the first time. A new message takes its slot, and the replies sent until the next message is accepted are kept in it.
+ *
+ * @return     True if the message is a repeat.
+ */
+bool SerialChecker::isDuplicate(){
+    uint16_t hash = rawMsgLen;
+    for(uint8_t i = 0; i < rawMsgLen; i++){
+        hash = hash * 31 + (uint8_t)rawMessage[i];
+    }
+    uint8_t received = useSeqNum ? seqNum : SERIALCHECKER_SEQ_NONE;
+    DuplicateEntry& entry = duplicates[(hash ^ (hash >> 8) ^ received) & (SERIALCHECKER_DUPLICATE_CACHE_SIZE - 1)];
+    uint32_t now = millis();
+    uint8_t matchLen = rawMsgLen < SERIALCHECKER_DUPLICATE_MATCH_LEN ? rawMsgLen : SERIALCHECKER_DUPLICATE_MATCH_LEN;
+    if(entry.used && entry.hash == hash && entry.seqNum == received && entry.msgLen == rawMsgLen && memcmp(entry.msgStart, rawMessage, matchLen) == 0 && now - entry.seenMillis < duplicateWindowMillis){
+        entry.seenMillis = now; // the sender is still trying, so keep remembering it
+        duplicateCount++;
+        if(entry.replyLen){
+            write(entry.reply, entry.replyLen);
+        }
+        else if(entry.acked){
+            sendAck();
+        }
+        return true;
+    }
+    entry.used = true;
+    entry.acked = false;
+    entry.replyTooLong = false;
+    entry.seqNum = received;
+    entry.hash = hash;
+    entry.msgLen = rawMsgLen;
+    memcpy(entry.msgStart, rawMessage, matchLen);
+    entry.replyLen = 0;
+    entry.seenMillis = now;
+    duplicateOpen = &entry;
+    return false;
+}
+
+/**
+ * @brief      Adds chars sent in reply to the message being dealt with to its duplicate filter entry. Once a reply doesn't fit, none of it is kept.
+ */
+void SerialChecker::keepReply(const char* reply, size_t len){
+    if(duplicateOpen->replyTooLong || duplicateOpen->replyLen + len > SERIALCHECKER_DUPLICATE_REPLY_LEN){
+        duplicateOpen->replyTooLong = true;
+        duplicateOpen->replyLen = 0;
+        return;
+    }
+    memcpy(&duplicateOpen->reply[duplicateOpen->replyLen], reply, len);
+    duplicateOpen->replyLen += len;
+}
+#endif
+
+/**
+ * @brief      Gets the reason the most recent invalid message was thrown away by check() or checkChar(). It stays set until clearLastError() is called, so it can be polled after check() returns 0 to tell an incomplete message apart from a rejected one.
+ *
+ * @return     The last error, or frameErrorEnum::None if nothing has been rejected since the last clearLastError().
+ */
+frameErrorEnum SerialChecker::getLastError(){
+    return lastError;
+}
+
+/**
+ * @brief      Resets the last error to frameErrorEnum::None.
+ */
+void SerialChecker::clearLastError(){
+    lastError = frameErrorEnum::None;
+}
+
+#if SERIALCHECKER_RECORDER
+/**
+ * @brief      Turns on the traffic recorder. From now on every char received by check() is logged with a timestamp, along with whether each message was accepted or why it was rejected, so that intermittent faults can be looked at afterwards. The log is kept in a ring buffer supplied by the user; once it is full the oldest entries are overwritten. Each received char normally takes two bytes: a header byte holding the entry type and the time since the previous entry, and the char itself.
+ *
+ * @param      buffer  The buffer to record in to, for example a global uint8_t array. It must stay valid while the recorder is on.
+ * @param[in]  size    The size of the buffer in bytes
+ */
+void SerialChecker::enableRecorder(uint8_t* buffer, uint16_t size){
+    recBuffer = buffer;
+    recSize = size;
+    clearRecorder();
+}
+
+/**
+ * @brief      Turns off the traffic recorder. The buffer is no longer used.
+ */
+void SerialChecker::disableRecorder(){
+    recBuffer = nullptr;
+    recSize = 0;
+    recUsed = 0;
+}
+
+/**
+ * @brief      Empties the recorder buffer.
+ */
+void SerialChecker::clearRecorder(){
+    recTail = 0;
+    recUsed = 0;
+}
+
+/**
+ * @brief      Gets the number of bytes of the recorder buffer in use.
+ *
+ * @return     The bytes used.
+ */
+uint16_t SerialChecker::getRecorderUsed(){
+    return recUsed;
+}
+
+/**
+ * @brief      Sends the recorder buffer, oldest entry first, over the serial port so that it can be saved on the PC and replayed with host/replay_dump.cpp. The dump looks like this, with the recorded bytes as hex, 32 to a line:
+ * 
+ * REC <micros() of the oldest entry> <tick shift> <bytes>
+ * 0A41...
+ * REC END
+ */
+void SerialChecker::dumpRecorder(){
+    print(F("REC "));
+    print(recTailMicros);
+    print(' ');
+    print((uint8_t)SERIALCHECKER_RECORDER_TICK_SHIFT);
+    print(' ');
+    println(recUsed);
+    static const char hexChars[] PROGMEM = "0123456789ABCDEF";
+    char line[65];
+    uint8_t lineLen = 0;
+    uint16_t index = recTail;
+    for(uint16_t i = 0; i < recUsed; i++){
+        line[lineLen++] = pgm_read_byte(&hexChars[recBuffer[index] >> 4]);
+        line[lineLen++] = pgm_read_byte(&hexChars[recBuffer[index] & 0x0F]);
+        if(++index >= recSize){
+            index = 0;
+        }
+        if(lineLen == 64 || i + 1 == recUsed){
+            line[lineLen] = '\0';
+            println(line);
+            lineLen = 0;
+        }
+    }
+    println(F("REC END"));
+}
+
+/**
+ * @brief      Adds an entry to the recorder, dropping the oldest entries if there is no room.
+ *
+ * @param[in]  type  The entry type
+ * @param[in]  data  The received char or the recorderEventEnum
+ */
+void SerialChecker::record(recorderEntryEnum type, uint8_t data){
+    uint32_t now = micros();
+    uint32_t ticks = 0;
+    if(recUsed){
+        ticks = (now - recLastMicros) >> SERIALCHECKER_RECORDER_TICK_SHIFT;
+        recLastMicros += ticks << SERIALCHECKER_RECORDER_TICK_SHIFT; // whole ticks only, so that rounding errors do not add up
+    }
+    else{
+        recLastMicros = now;
+    }
+    uint8_t len = 2;
+    if(ticks >= 63){
+        uint32_t t = ticks;
+        do{
+            len++;
+            t >>= 7;
+        } while(t);
+    }
+    if(len > recSize){
+        return;
+    }
+    while(recSize - recUsed < len){
+        recorderDropOldest();
+    }
+    if(recUsed == 0){
+        recTailMicros = recLastMicros;
+    }
+    recorderPut(((uint8_t)type << 6) | (ticks >= 63 ? 63 : ticks));
+    if(ticks >= 63){
+        while(ticks >= 0x80){
+            recorderPut((ticks & 0x7F) | 0x80);
+            ticks >>= 7;
+        }
+        recorderPut(ticks);
+    }
+    recorderPut(data);
+}
+
+void SerialChecker::recorderPut(uint8_t b){
+    uint16_t index = recTail + recUsed;
+    if(index >= recSize){
+        index -= recSize;
+    }
+    recBuffer[index] = b;
+    recUsed++;
+}
+
+/**
+ * @brief      Works out the length of the recorder entry starting at index.
+ *
+ * @param[in]  index  The index of the entry's header byte
+ * @param      ticks  Set to the time since the previous entry
+ *
+ * @return     The length of the entry in bytes.
+ */
+uint8_t SerialChecker::recorderEntryLen(uint16_t index, uint32_t& ticks){
+    ticks = recBuffer[index] & 0x3F;
+    if(ticks < 63){
+        return 2;
+    }
+    ticks = 0;
+    uint8_t len = 1;
+    uint8_t shift = 0;
+    uint8_t b;
+    do{
+        if(++index >= recSize){
+            index = 0;
+        }
+        b = recBuffer[index];
+        ticks |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+        len++;
+    } while(b & 0x80);
+    return len + 1;
+}
+
+void SerialChecker::recorderDropOldest(){
+    uint32_t ticks;
+    uint8_t len = recorderEntryLen(recTail, ticks);
+    recTail += len;
+    if(recTail >= recSize){
+        recTail -= recSize;
+    }
+    recUsed -= len;
+    if(recUsed){
+        // The new oldest entry's time is relative to the entry just dropped.
+        recorderEntryLen(recTail, ticks);
+        recTailMicros += ticks << SERIALCHECKER_RECORDER_TICK_SHIFT;
+    }
+}
+
+#endif
+
+/**
+ * @brief      Returns the address that the message was sent to as a c-style char string. Do not call this if the @addressLen variable is set to the default of zero.
+ *
+ * @return     The address.
+ */
+char* SerialChecker::getAddress(){
+    if(addressLen > 0){
+        for(uint8_t i = 0; i < addressLen; i++){
+            address[i] = rawMessage[i];
+        }
+        address[addressLen] = '\0';
+        return address;
+    }
+    else{
+        return nullptr;
+    }
+}
+
+/**
+ * @brief      Returns the address char. DO NOT USE THIS IF THE ADDRESS c-style string IS MORE THAN 1 CHAR LONG.
+ *
+ * @return     The address char.
+ */
+ char SerialChecker::getAddressChar(){
+    return *address;
+ }
+
+/**
+ * @brief      Gets the raw message. This is the full message including the address if there is one.
+ *
+ * @return     The raw message.
+ */
+char* SerialChecker::getRawMsg(){
+    return rawMessage;
+}
+
+/**
+ * @brief      Loads a message that has already been received and checked elsewhere, for example by another thread, in to the message buffer. The address is split off as it is by check() so that getMsg(), contains() and the number conversions work on it. Messages longer than the maximum message length are cut short.
+ *
+ * @param[in]  rawMsg  The raw message including the address if there is one but without STX, checksum or ETX chars.
+ * @param[in]  len     The length of the raw message
+ *
+ * @return     The length of the loaded message.
+ */
+uint8_t SerialChecker::loadMsg(const char* rawMsg, uint8_t len){
+    if(len > msgMaxLen){
+        len = msgMaxLen;
+    }
+    memcpy(rawMessage, rawMsg, len);
+    rawMessage[len] = '\0';
+    rawMsgLen = len;
+    getAddress();
+    #if SERIALCHECKER_ADDRESS_FILTER
+    if(addressCount && len >= addressLen){
+        addressKind = lookupAddress(rawMessage);
+    }
+    #endif
+    return rawMsgLen;
+}
+
+/**
+ * @brief      Gets the raw message length. This is the length of the full message including the address if there is one.
+ *
+ * @return     The raw message length.
+ */
+uint8_t SerialChecker::getRawMsgLen(){
+    return rawMsgLen;
+}
+
+/**
+ * @brief      Gets the contents of the message buffer. The message buffer is updated if new chars are received by check().
+ *
+ * @return     The message buffer which is null terminated.
  */
 char* SerialChecker::getMsg(){
     return message;
@@ -599,8 +1147,10 @@ void SerialChecker::setMsgMinLen(uint8_t msgMinLen){
  */
 void SerialChecker::setMsgMaxLen(uint8_t msgMaxLen){
     this->msgMaxLen = msgMaxLen;
-    delete [] message;
-    message = new char[msgMaxLen];
+    delete [] rawMessage;
+    rawMessage = new char[msgMaxLen + 1]; // + 1 to allow for null terminator
+    message = &rawMessage[addressLen];
+    msgIndex = 0;
 }
 
 /**
@@ -609,6 +1159,9 @@ void SerialChecker::setMsgMaxLen(uint8_t msgMaxLen){
  * @param[in]  len   The new value
  */
 void SerialChecker::setAddressLen(uint8_t len){
+    #if SERIALCHECKER_ADDRESS_FILTER
+    clearAddresses(); // they were the old length
+    #endif
     address = new char[len + 1]; // + 1 to allow for null terminator
     address[0] = '\0';
     addressLen = len;
@@ -624,6 +1177,150 @@ uint8_t SerialChecker::getAddressLen(){
     return addressLen;
 }
 
+#if SERIALCHECKER_ADDRESS_FILTER
+/**
+ * @brief      Sets the address of this node so that messages for other addresses are thrown away as soon as their address has arrived. The rest of such a message is skipped up to its ETX char without being stored, checksummed or Naked, and check() never returns it. On a shared bus, such as RS-485 with many nodes, each node then only spends time on its own messages. Call setAddressLen() first; the filter is the same length. This is the same as clearAddresses() followed by addAddress(address, addressKindEnum::Unicast).
+ *
+ * @param      address  The address to accept
+ */
+void SerialChecker::setAddressFilter(char* address){
+    clearAddresses();
+    addAddress(address, addressKindEnum::Unicast);
+}
+
+/**
+ * @brief      Removes the address filter so that every message is returned by check() again. This is the default. Same as clearAddresses().
+ */
+void SerialChecker::clearAddressFilter(){
+    clearAddresses();
+}
+
+/**
+ * @brief      Adds an address that this node answers to, such as its own address, the address of a group of nodes it belongs to or a broadcast address. Messages for any other address are skipped as described in setAddressFilter(). Each message's address is looked up in one go however many addresses are added: a bitset is used for 1 char addresses and a small hash table, holding up to SERIALCHECKER_ADDRESS_TABLE_SIZE addresses, for longer ones. getAddressKind() then says which kind of address a message was sent to. Naks are not sent for group and broadcast messages, or every node would answer at once. Call setAddressLen() first, as changing it removes the addresses.
+ *
+ * @param      address  The address, setAddressLen() chars long
+ * @param[in]  kind     The kind of address
+ *
+ * @return     False if the hash table is full.
+ */
+bool SerialChecker::addAddress(char* address, addressKindEnum kind){
+    if(addressLen == 0 || kind == addressKindEnum::None){
+        return false;
+    }
+    if(addressLen == 1){
+        if(!addressBits){
+            addressBits = new uint8_t[48]; // 128 bits for each kind of address
+            memset(addressBits, 0, 48);
+        }
+        uint8_t c = address[0];
+        if(c & 0x80){
+            return false;
+        }
+        addressBits[((uint8_t)kind - 1) * 16 + (c >> 3)] |= 1 << (c & 7);
+        addressCount++;
+        return true;
+    }
+    if(!addressTable){
+        addressTable = new char[SERIALCHECKER_ADDRESS_TABLE_SIZE * addressLen];
+        addressKinds = new uint8_t[SERIALCHECKER_ADDRESS_TABLE_SIZE];
+        memset(addressKinds, 0, SERIALCHECKER_ADDRESS_TABLE_SIZE);
+    }
+    uint8_t slot = addressHash(address);
+    for(uint8_t i = 0; i < SERIALCHECKER_ADDRESS_TABLE_SIZE; i++){
+        char* entry = &addressTable[slot * addressLen];
+        if(addressKinds[slot] == (uint8_t)addressKindEnum::None || memcmp(entry, address, addressLen) == 0){
+            if(addressKinds[slot] == (uint8_t)addressKindEnum::None){
+                addressCount++;
+            }
+            memcpy(entry, address, addressLen);
+            addressKinds[slot] = (uint8_t)kind;
+            return true;
+        }
+        slot = (slot + 1) & (SERIALCHECKER_ADDRESS_TABLE_SIZE - 1);
+    }
+    return false;
+}
+
+/**
+ * @brief      Removes every address added with addAddress() or setAddressFilter(), so that check() returns messages for every address again.
+ */
+void SerialChecker::clearAddresses(){
+    delete [] addressBits;
+    delete [] addressTable;
+    delete [] addressKinds;
+    addressBits = nullptr;
+    addressTable = nullptr;
+    addressKinds = nullptr;
+    addressCount = 0;
+    addressKind = addressKindEnum::None;
+    skipping = false;
+}
+
+/**
+ * @brief      Gets the kind of address the last message was sent to, when addresses have been added with addAddress() or setAddressFilter().
+ *
+ * @return     The kind of address, or addressKindEnum::None if no addresses have been added.
+ */
+addressKindEnum SerialChecker::getAddressKind(){
+    return addressKind;
+}
+
+/**
+ * @brief      Gets the number of messages skipped by the address filter since the last call, for example to see how busy the bus is.
+ *
+ * @return     The number of messages for other addresses.
+ */
+uint32_t SerialChecker::getSkippedCount(){
+    uint32_t count = skippedCount;
+    skippedCount = 0;
+    return count;
+}
+
+/**
+ * @brief      Looks up the address chars of a message, which may still be arriving, in the addresses added by addAddress().
+ *
+ * @param[in]  received  The first address char
+ *
+ * @return     The kind of address, or addressKindEnum::None if the message is for another node.
+ */
+addressKindEnum SerialChecker::lookupAddress(const char* received){
+    if(addressLen == 1){
+        uint8_t c = received[0];
+        if(!addressBits || (c & 0x80)){
+            return addressKindEnum::None;
+        }
+        for(uint8_t kind = 0; kind < 3; kind++){
+            if(addressBits[kind * 16 + (c >> 3)] & (1 << (c & 7))){
+                return (addressKindEnum)(kind + 1);
+            }
+        }
+        return addressKindEnum::None;
+    }
+    if(!addressTable){
+        return addressKindEnum::None;
+    }
+    uint8_t slot = addressHash(received);
+    for(uint8_t i = 0; i < SERIALCHECKER_ADDRESS_TABLE_SIZE && addressKinds[slot]; i++){
+        if(memcmp(&addressTable[slot * addressLen], received, addressLen) == 0){
+            return (addressKindEnum)addressKinds[slot];
+        }
+        slot = (slot + 1) & (SERIALCHECKER_ADDRESS_TABLE_SIZE - 1);
+    }
+    return addressKindEnum::None;
+}
+
+/**
+ * @brief      Hashes addressLen chars of an address in to a slot of the address hash table.
+ */
+uint8_t SerialChecker::addressHash(const char* address){
+    uint8_t hash = 0;
+    for(uint8_t i = 0; i < addressLen; i++){
+        hash = hash * 31 + address[i];
+    }
+    return (hash ^ (hash >> 4)) & (SERIALCHECKER_ADDRESS_TABLE_SIZE - 1);
+}
+#endif
+
 /**
  * @brief      Check to see if the received address matches an address being tested for.
  *
@@ -643,6 +1340,25 @@ bool SerialChecker::addressMatch(char* addressToMatch){
     return true;
 }
 
+/**
+ * @brief      As addressMatch(char* addressToMatch) for an address kept in flash with F().
+ *
+ * @param[in]  addressToMatch  The address to match
+ *
+ * @return     True if the received address matches.
+ */
+bool SerialChecker::addressMatch(const __FlashStringHelper* addressToMatch){
+    const char* p = (const char*)addressToMatch;
+    int i = 0;
+    char c;
+    while((c = pgm_read_byte(p++))){
+        if(c != address[i++]){
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * @brief      Check to see if the received message contains a char array starting at startIndex. With this function the user can check to see what type of message has been sent.
  *
@@ -677,6 +1393,37 @@ bool SerialChecker::contains(char* snippet){
     return contains(snippet, 0);
 }
 
+/**
+ * @brief      As contains(char* snippet, uint8_t startIndex) for a snippet kept in flash with F(), such as sc.contains(F("TEST"), 1). Command names compared this way take up no RAM, which on an Uno with many commands can free hundreds of bytes.
+ *
+ * @param[in]  snippet     The snippet to be compared
+ * @param[in]  startIndex  The index in the message to compare from
+ *
+ * @return     Returns true if the snippet is present and false if not.
+ */
+bool SerialChecker::contains(const __FlashStringHelper* snippet, uint8_t startIndex){
+    const char* p = (const char*)snippet;
+    char* m = &message[startIndex];
+    char c;
+    while((c = pgm_read_byte(p++))){
+        if(c != *m++){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief      As contains(char* snippet) for a snippet kept in flash with F().
+ *
+ * @param[in]  snippet  The snippet to be compared
+ *
+ * @return     Returns true if the message starts with the snippet and false if not.
+ */
+bool SerialChecker::contains(const __FlashStringHelper* snippet){
+    return contains(snippet, 0);
+}
+
 /**
  * @brief      Check to see if the received message contains a char (uint8_t). With this function the user can check to see what type of message has been sent.
  *
@@ -718,7 +1465,7 @@ bool SerialChecker::contains(const char& c){
  * @return     The checksum char.
  */
 char SerialChecker::calcChecksum(char* rawMessage, int len){
-    char checksum;
+    char checksum = 0;
     switch(checksumType){
         case checksumTypeEnum::SpellmanMPS:
             checksum = chksmSpellmanMPS(rawMessage, len);
@@ -741,7 +1488,7 @@ char SerialChecker::calcChecksum(char* rawMessage, int len){
  * @return     The checksum char.
  */
 char SerialChecker::calcChecksum(char* rawMessage){
-    char checksum;
+    char checksum = 0;
     switch(checksumType){
         case checksumTypeEnum::SpellmanMPS:
             checksum = chksmSpellmanMPS(rawMessage);
@@ -761,17 +1508,8 @@ char SerialChecker::calcChecksum(char* rawMessage){
  *
  * @return     the calculated checksum char
  */
-char SerialChecker::chksmSpellmanMPS(char* rawMessage, int len){
-    uint8_t checksum=0; // used to use uint16_t but 8 works
-    for(uint8_t i = 0; i < len; i++)
-    { //add the command
-        checksum += rawMessage[i];
-    }
-    //Calculate checksum based on MPS manual
-    checksum = ~checksum+1; //the checksum is currently a unsigned 16bit int. Invert all the bits and add 1.
-    checksum = 0x7F & checksum; // discard the 8 MSBs and clear the remaining MSB (B0000000001111111)
-    checksum = 0x40 | checksum; //bitwise or bit6 with 0x40 (or with a seventh bit which is set to 1.) (B0000000001000000)
-    return (char) checksum;
+char SerialChecker::chksmSpellmanMPS(const char* rawMessage, int len){
+    return spellmanMPSFromSum(sum8(rawMessage, len));
 }
 
 /**
@@ -781,16 +1519,8 @@ char SerialChecker::chksmSpellmanMPS(char* rawMessage, int len){
  *
  * @return     the calculated checksum char
  */
-char SerialChecker::chksmSpellmanMPS(char* rawMessage){
-    uint8_t checksum=0; // used to use uint16_t but 8 works
-    while(*rawMessage){
-        checksum += *rawMessage;
-        rawMessage++;
-    }
-    checksum = ~checksum+1; //the checksum is currently a unsigned 16bit int. Invert all the bits and add 1.
-    checksum = 0x7F & checksum; // discard the 8 MSBs and clear the remaining MSB (B0000000001111111)
-    checksum = 0x40 | checksum; //bitwise or bit6 with 0x40 (or with a seventh bit which is set to 1.) (B0000000001000000)
-    return (char) checksum;
+char SerialChecker::chksmSpellmanMPS(const char* rawMessage){
+    return spellmanMPSFromSum(sum8(rawMessage, strlen(rawMessage)));
 }
 
 /**
@@ -801,18 +1531,8 @@ char SerialChecker::chksmSpellmanMPS(char* rawMessage){
  *
  * @return     the calculated checksum char
  */
-char SerialChecker::chksm8bitAllReadableChars(char* rawMessage, int len){
-    uint8_t checksum=0; // used to use uint16_t but 8 works
-    for(uint8_t i = 0; i < len; i++)
-    { //add the command
-        checksum += rawMessage[i];
-    }
-    checksum &= 0x7F; // clear the MSB (0b1111111) so that the number can only be between 0 and 127.
-    checksum += 33; // 33 is the minimum printable char '!'
-    if(checksum > 126){
-        checksum -= 94; // 126 is the last readable char '~', so wrap back to the first printable char by subtracting 94.
-    }
-    return (char) checksum;
+char SerialChecker::chksm8bitAllReadableChars(const char* rawMessage, int len){
+    return readable8bitCharsFromSum(sum8(rawMessage, len));
 }
 
 /**
@@ -822,21 +1542,68 @@ char SerialChecker::chksm8bitAllReadableChars(char* rawMessage, int len){
  *
  * @return     the calculated checksum char
  */
-char SerialChecker::chksm8bitAllReadableChars(char* rawMessage){
-    uint8_t checksum=0; // used to use uint16_t but 8 works
-    while(*rawMessage){
-        checksum += *rawMessage;
-        rawMessage++;
-    }
-    checksum &= 0x7F; // clear the MSB (0b1111111) so that the number can only be between 0 and 127.
-    checksum += 33; // 33 is the minimum printable char '!'
-    if(checksum > 126){
-        checksum -= 94; // 126 is the last readable char '~', so wrap back to the first printable char by subtracting 94.
-    }
-    return (char) checksum;
+char SerialChecker::chksm8bitAllReadableChars(const char* rawMessage){
+    return readable8bitCharsFromSum(sum8(rawMessage, strlen(rawMessage)));
 }
 
-// def testChecksum8bitReadableChars(i: int) -> int:
+/**
+ * @brief      Adds up the chars of a message in to a byte. Both checksums are worked out from this sum.
+ *
+ * @param      rawMessage  The raw message
+ * @param[in]  len         The length of the message
+ *
+ * @return     The sum, wrapped around at 256.
+ */
+uint8_t SerialChecker::sum8(const char* rawMessage, int len){
+    uint8_t sum = 0;
+    for(int i = 0; i < len; i++){ // int so that messages longer than 255 chars still finish
+        sum += rawMessage[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief      The last steps of chksmSpellmanMPS(), turning the sum of the chars in to the checksum char. Public so that other code that adds up the chars its own way, such as host/ChecksumSIMD.cpp, finishes the checksum with the same code.
+ */
+char SerialChecker::spellmanMPSFromSum(uint8_t checksum){
+    //Calculate checksum based on MPS manual
+    checksum = ~checksum+1; //the checksum is currently a unsigned 16bit int. Invert all the bits and add 1.
+    checksum = 0x7F & checksum; // discard the 8 MSBs and clear the remaining MSB (B0000000001111111)
+    checksum = 0x40 | checksum; //bitwise or bit6 with 0x40 (or with a seventh bit which is set to 1.) (B0000000001000000)
+    return (char) checksum;
+}
+
+/**
+ * @brief      The last steps of chksm8bitAllReadableChars(), turning the sum of the chars in to the checksum char.
+ */
+char SerialChecker::readable8bitCharsFromSum(uint8_t checksum){
+    checksum &= 0x7F; // clear the MSB (0b1111111) so that the number can only be between 0 and 127.
+    checksum += 33; // 33 is the minimum printable char '!'
+    if(checksum > 126){
+        checksum -= 94; // 126 is the last readable char '~', so wrap back to the first printable char by subtracting 94.
+    }
+    return (char) checksum;
+}
+
+/**
+ * @brief      Gets the value of a hex digit, upper or lower case.
+ *
+ * @return     The value, or -1 if c is not a hex digit.
+ */
+int8_t SerialChecker::hexDigitValue(char c){
+    if(c >= '0' && c <= '9'){
+        return c - '0';
+    }
+    if(c >= 'A' && c <= 'F'){
+        return c - 'A' + 10;
+    }
+    if(c >= 'a' && c <= 'f'){
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// def testChecksum8bitReadableChars(i: int) -> int:
 //     checksum = i
 //     checksum &= 127 #0x7F 0b1111111
 //     checksum += 33 # first readable char is '!'
@@ -968,8 +1735,6 @@ float SerialChecker::toFloat(uint8_t startIndex){
  * @return     the converted float value
  */
 float SerialChecker::toFloat(){
-    uint8_t number = 0;
-    bool negative = false;
     uint8_t startIndex = 0;
     while(message[startIndex]){
         if((message[startIndex] == '-') || (message[startIndex] >= '0' && message[startIndex] <= '9')){
@@ -1027,8 +1792,60 @@ uint8_t SerialChecker::toInt8(uint8_t startIndex){
  */
 uint8_t SerialChecker::toInt8(){
     // Returns the number stored in a char array, starting at startIndex
-    uint8_t number = 0;
+    uint8_t startIndex = 0;
+    while(message[startIndex]){
+        if((message[startIndex] == '-') || 
+            (message[startIndex] >= '0' && message[startIndex] <= '9')){
+            break;
+        }
+        startIndex++;
+    }
+    return toInt8(startIndex);
+}
+
+/**
+ * @brief      Converts the message buffer (starting at startIndex) to an int16_t. This works for both unsigned and signed ints as long as the container it is loaded in to is of the correct type.
+ *
+ * @param[in]  startIndex  The start index
+ *
+ * @return     the converted int16_t
+ */
+uint16_t SerialChecker::toInt16(uint8_t startIndex){
+    // Returns the number stored in a char array, starting at startIndex
+    uint16_t number = 0;
     bool negative = false;
+    if( message[startIndex] == '-'){
+        negative = true;
+        startIndex++;
+    }
+    // for(int i = startIndex; i < rawMsgLen - addressLen; i++) 
+    // {
+    //     number *= 10;
+    //     number += (message[i] -'0');        
+    // }
+    while(message[startIndex]){
+        if( (message[startIndex] >= '0' && message[startIndex] <= '9') ){
+            number *= 10;
+            number += (message[startIndex] -'0');
+        }
+        else{
+            break;
+        }
+        startIndex++;
+    }
+    if(negative){
+        number *= -1;
+    }
+    return number;
+}
+
+/**
+ * @brief      Converts the message buffer to an int16_t. This works for both unsigned and signed ints as long as the container it is loaded in to is of the correct type.
+ *
+ * @return     the converted int16_t
+ */
+uint16_t SerialChecker::toInt16(){
+    // Returns the number stored in a char array, starting at startIndex
     uint8_t startIndex = 0;
     while(message[startIndex]){
         if((message[startIndex] == '-') || 
@@ -1037,167 +1854,984 @@ uint8_t SerialChecker::toInt8(){
         }
         startIndex++;
     }
-    return toInt8(startIndex);
+    return toInt16(startIndex);
+}
+
+/**
+ * @brief      Converts the message buffer (starting at startIndex) to an int32_t. This works for both unsigned and signed ints as long as the container it is loaded in to is of the correct type.
+ *
+ * @param[in]  startIndex  The start index
+ *
+ * @return     the converted int32_t
+ */
+uint32_t SerialChecker::toInt32(uint8_t startIndex){
+    // Returns the number stored in a char array, starting at startIndex
+    uint32_t number = 0;
+    bool negative = false;
+    if( message[startIndex] == '-'){
+        negative = true;
+        startIndex++;
+    }
+    // for(int i = startIndex; i < rawMsgLen - addressLen; i++) 
+    // {
+    //     number *= 10;
+    //     number += (message[i] -'0');
+    // }
+    while(message[startIndex]){
+        if( (message[startIndex] >= '0' && message[startIndex] <= '9') ){
+            number *= 10;
+            number += (message[startIndex] -'0');
+        }
+        else{
+            break;
+        }
+        startIndex++;
+    }
+    if(negative){
+        number *= -1;
+    }
+    return number;
+}
+
+/**
+ * @brief      Converts the message buffer to an int32_t. This works for both unsigned and signed ints as long as the container it is loaded in to is of the correct type.
+ *
+ * @return     the converted int32_t
+ */
+uint32_t SerialChecker::toInt32(){
+    // Returns the number stored in a char array, starting at startIndex
+    uint8_t startIndex = 0;
+    while(message[startIndex]){
+        if((message[startIndex] == '-') || 
+            (message[startIndex] >= '0' && message[startIndex] <= '9')){
+            break;
+        }
+        startIndex++;
+    }
+    return toInt32(startIndex);
+}
+
+/**
+ * @brief      Converts the message buffer (starting at startIndex) to a scaled integer without using floats, which are slow and large on boards without an FPU. For example, "12.345" with a scale of 1000 gives 12345, such as millivolts from a reading in volts. Decimals beyond the scale are rounded. As with toInt32(), the number must fit in the result.
+ *
+ * @param[in]  startIndex  The start index
+ * @param[in]  scale       A power of 10: 1, 10, 100 and so on
+ *
+ * @return     The number multiplied by scale.
+ */
+int32_t SerialChecker::toScaled(uint8_t startIndex, uint32_t scale){
+    bool negative = false;
+    if(message[startIndex] == '-'){
+        negative = true;
+        startIndex++;
+    }
+    uint32_t number = 0;
+    while(message[startIndex] >= '0' && message[startIndex] <= '9'){
+        number = number * 10 + (message[startIndex] - '0');
+        startIndex++;
+    }
+    number *= scale;
+    if(message[startIndex] == '.'){
+        startIndex++;
+        uint32_t place = scale / 10;
+        for(; place && message[startIndex] >= '0' && message[startIndex] <= '9'; startIndex++){
+            number += (message[startIndex] - '0') * place;
+            place /= 10;
+        }
+        if(!place && message[startIndex] >= '5' && message[startIndex] <= '9'){
+            number++; // round on the first decimal that doesn't fit
+        }
+    }
+    return negative ? -(int32_t)number : number;
+}
+
+/**
+ * @brief      Converts the message buffer to a scaled integer, starting from the first numeric or minus sign. See toScaled(uint8_t startIndex, uint32_t scale).
+ *
+ * @param[in]  scale  A power of 10
+ *
+ * @return     The number multiplied by scale.
+ */
+int32_t SerialChecker::toScaled(uint32_t scale){
+    return toScaled(firstNumberIndex(), scale);
+}
+
+/**
+ * @brief      Does the work of toFixed<Q>(). The whole number part is shifted up and the decimals are turned into binary fraction bits from the last digit back, so only integer arithmetic is needed. Up to 9 decimals are used and the result is rounded to the nearest fraction bit.
+ *
+ * @param[in]  startIndex  The start index
+ * @param[in]  fracBits    The number of fraction bits, up to 24
+ *
+ * @return     The number multiplied by 2 to the power of fracBits.
+ */
+int32_t SerialChecker::toFixedBits(uint8_t startIndex, uint8_t fracBits){
+    bool negative = false;
+    if(message[startIndex] == '-'){
+        negative = true;
+        startIndex++;
+    }
+    uint32_t whole = 0;
+    while(message[startIndex] >= '0' && message[startIndex] <= '9'){
+        whole = whole * 10 + (message[startIndex] - '0');
+        startIndex++;
+    }
+    uint32_t fraction = 0; // with one extra bit for rounding
+    if(message[startIndex] == '.'){
+        uint8_t first = ++startIndex;
+        while(message[startIndex] >= '0' && message[startIndex] <= '9' && startIndex - first < 9){
+            startIndex++;
+        }
+        // Each step is (digit + fraction) / 10, working from the last decimal back to the first.
+        while(startIndex > first){
+            startIndex--;
+            fraction = (fraction + ((uint32_t)(message[startIndex] - '0') << (fracBits + 1))) / 10;
+        }
+        fraction = (fraction + 1) >> 1;
+    }
+    uint32_t number = (whole << fracBits) + fraction;
+    return negative ? -(int32_t)number : number;
+}
+
+/**
+ * @brief      Finds the first numeric or minus sign in the message, as toFloat() and toInt32() do.
+ */
+uint8_t SerialChecker::firstNumberIndex(){
+    uint8_t startIndex = 0;
+    while(message[startIndex]){
+        if((message[startIndex] == '-') || (message[startIndex] >= '0' && message[startIndex] <= '9')){
+            break;
+        }
+        startIndex++;
+    }
+    return startIndex;
+}
+
+/**
+ * @brief      Sends an Ack char followed by the ETX char. If enableSeqNum() is used, the Ack is sent as a frame with the sequence number of the last message received.
+ */
+void SerialChecker::sendAck(){
+    #if SERIALCHECKER_ACK_BATCHING
+    if(useAckBatching){
+        #if SERIALCHECKER_DUPLICATE_FILTER
+        if(duplicateOpen){
+            duplicateOpen->acked = true;
+        }
+        #endif
+        queueAck(seqNum);
+        return;
+    }
+    #endif
+    if(useSeqNum){
+        sendReply(Ack, seqNum);
+        return;
+    }
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    if(duplicateOpen){
+        const char reply[3] = { Ack, '\r', '\n' };
+        keepReply(reply, sizeof(reply));
+    }
+    #endif
+    switch (serialType) {
+    #ifdef USBserial_h_
+        case serialTypes::USB:
+            port.usb->println(Ack);
+            break;
+    #endif
+    #ifdef USBCON
+        case serialTypes::ATMEGAXXU4:
+            port.atmegaXXu4->println(Ack);
+            break;
+    #endif
+    #ifdef ARDUINO
+        case serialTypes::HardWare:
+            port.hardware->println(Ack);
+            break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(Ack);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief      Sends an Nak char followed by the ETX char. If enableSeqNum() is used, the Nak is sent as a frame with the sequence number of the last message received.
+ */
+void SerialChecker::sendNak(){
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    if(duplicateOpen){
+        // It wasn't carried out, so the sender's next try must get through.
+        duplicateOpen->used = false;
+        duplicateOpen = nullptr;
+    }
+    #endif
+    if(useSeqNum){
+        sendReply(Nak, seqNum);
+        return;
+    }
+    switch (serialType) {
+    #ifdef USBserial_h_
+        case serialTypes::USB:
+            port.usb->println(Nak);
+            break;
+    #endif
+    #ifdef USBCON
+        case serialTypes::ATMEGAXXU4:
+            port.atmegaXXu4->println(Nak);
+            break;
+    #endif
+    #ifdef ARDUINO
+        case serialTypes::HardWare:
+            port.hardware->println(Nak);
+            break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(Nak);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief      Sends an Ack for a particular message. Use this with enableSeqNum() to answer a message some time after it arrived.
+ *
+ * @param[in]  seqNum  The sequence number of the message being answered
+ */
+void SerialChecker::sendAck(uint8_t seqNum){
+    #if SERIALCHECKER_ACK_BATCHING
+    if(useAckBatching){
+        queueAck(seqNum);
+        return;
+    }
+    #endif
+    sendReply(Ack, seqNum);
+}
+
+/**
+ * @brief      Sends a Nak for a particular message. Use this with enableSeqNum() to answer a message some time after it arrived.
+ *
+ * @param[in]  seqNum  The sequence number of the message being answered
+ */
+void SerialChecker::sendNak(uint8_t seqNum){
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    if(duplicateOpen && seqNum == this->seqNum){
+        duplicateOpen->used = false;
+        duplicateOpen = nullptr;
+    }
+    #endif
+    sendReply(Nak, seqNum);
+}
+
+#if SERIALCHECKER_ACK_BATCHING
+/**
+ * @brief      Turns on Ack batching. Rather than one reply per message, sendAck() saves the Ack up and a single Ack is sent for several messages. This cuts the traffic back to the sender, which can otherwise be busier than the messages themselves when lots of short messages are streamed. Naks are still sent straight away.
+ *
+ * If enableSeqNum() is used, the batched Ack is a frame with the sequence number of the first message Acked and the Ack char followed by a hex bitmap of the messages Acked: bit 0 is the first message, bit 1 the next sequence number and so on, up to 32 messages. Otherwise it is the Ack char followed by the number of messages Acked in hex. A batch of one is sent as a normal Ack. On the receiving end, isAck() recognises all of these and getAckBitmap() and getAckCount() say what was Acked. The receiving end's message maximum length must allow for the hex digits.
+ *
+ * The Acks are sent once maxFrames have been saved up, or once the oldest has waited maxMicros. With a maxMicros of 0 they are sent as soon as check() has read every char waiting in the serial buffer. The time is only checked by check(), so call it often, or call flushAcks().
+ *
+ * @param[in]  maxFrames  The most messages to Ack at once, up to 32
+ * @param[in]  maxMicros  The longest time in microseconds to hold an Ack back, or 0 to send the Acks when the serial buffer is empty
+ */
+void SerialChecker::enableAckBatching(uint8_t maxFrames, uint32_t maxMicros){
+    useAckBatching = true;
+    ackBatchMax = maxFrames < 1 ? 1 : (maxFrames > 32 ? 32 : maxFrames);
+    ackBatchMicros = maxMicros;
+}
+
+/**
+ * @brief      Turns off Ack batching, sending any Acks that have been saved up. This is the default.
+ */
+void SerialChecker::disableAckBatching(){
+    flushAcks();
+    useAckBatching = false;
+}
+
+/**
+ * @brief      Sends any Acks that have been saved up by Ack batching straight away.
+ */
+void SerialChecker::flushAcks(){
+    if(!ackPendingCount){
+        return;
+    }
+    static const char hexChars[] PROGMEM = "0123456789ABCDEF";
+    char reply[10]; // the Ack char, up to 8 hex digits and the null terminator
+    uint32_t value = useSeqNum ? ackPendingMask : ackPendingCount;
+    uint8_t len = 0;
+    reply[len++] = Ack;
+    if(value != 1){
+        uint8_t digits = 1;
+        while(digits < 8 && (value >> (4 * digits))){
+            digits++;
+        }
+        while(digits){
+            digits--;
+            reply[len++] = pgm_read_byte(&hexChars[(value >> (4 * digits)) & 0x0F]);
+        }
+    }
+    reply[len] = '\0';
+    ackPendingCount = 0;
+    ackPendingMask = 0;
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    DuplicateEntry* open = duplicateOpen;
+    duplicateOpen = nullptr; // the duplicate filter sends a repeat's Ack again with sendAck() instead
+    #endif
+    if(useSeqNum){
+        sendFrame(reply, ackPendingBase);
+    }
+    else{
+        println(reply);
+    }
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    duplicateOpen = open;
+    #endif
+}
+
+/**
+ * @brief      Saves up an Ack for Ack batching, sending the batch if it is full or the message is too far from the start of the batch to fit in the bitmap.
+ */
+void SerialChecker::queueAck(uint8_t seqNum){
+    if(useSeqNum){
+        if(ackPendingCount && ((seqNum - ackPendingBase) & (SERIALCHECKER_SEQ_COUNT - 1)) >= 32){
+            flushAcks();
+        }
+        if(!ackPendingCount){
+            ackPendingBase = seqNum;
+            ackPendingSince = micros();
+        }
+        uint32_t bit = (uint32_t)1 << ((seqNum - ackPendingBase) & (SERIALCHECKER_SEQ_COUNT - 1));
+        if(ackPendingMask & bit){
+            return; // already waiting to be Acked
+        }
+        ackPendingMask |= bit;
+    }
+    else if(!ackPendingCount){
+        ackPendingSince = micros();
+    }
+    ackPendingCount++;
+    if(ackPendingCount >= ackBatchMax){
+        flushAcks();
+    }
+}
+#endif
+
+void SerialChecker::sendReply(char reply, uint8_t seqNum){
+    char message[2] = { reply, '\0' };
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    DuplicateEntry* open = duplicateOpen;
+    if(seqNum != this->seqNum){
+        duplicateOpen = nullptr; // answering an earlier message, not the one the duplicate filter is keeping replies for
+    }
+    #endif
+    sendFrame(message, seqNum);
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    duplicateOpen = open;
+    #endif
+}
+
+/**
+ * @brief      Sends a message framed the way check() expects to receive it: the STX char if enableSTX() is used, the sequence number if enableSeqNum() is used, the message, the checksum char if enableChecksum() is used and finally the ETX char. Short frames are put together first so that they go out in a single write.
+ *
+ * @param      message  The null terminated message, including the address if one is used.
+ *
+ * @return     The sequence number the message was sent with, so that the reply can be matched to it, or SERIALCHECKER_SEQ_NONE if sequence numbers are not used.
+ */
+uint8_t SerialChecker::sendFrame(char* message){
+    if(!useSeqNum){
+        sendFrame(message, SERIALCHECKER_SEQ_NONE);
+        return SERIALCHECKER_SEQ_NONE;
+    }
+    uint8_t sent = txSeqNum;
+    txSeqNum = (txSeqNum + 1) & (SERIALCHECKER_SEQ_COUNT - 1);
+    sendFrame(message, sent);
+    return sent;
+}
+
+/**
+ * @brief      Sends a message with a particular sequence number, for example to send a message again after a Nak. The sequence number is only sent if enableSeqNum() is used.
+ *
+ * @param      message  The null terminated message, including the address if one is used.
+ * @param[in]  seqNum   The sequence number
+ */
+void SerialChecker::sendFrame(char* message, uint8_t seqNum){
+    char frame[SERIALCHECKER_FRAME_BUFFER_LEN];
+    size_t frameLen = buildFrame(message, seqNum, frame);
+    if(frameLen){
+        #if SERIALCHECKER_DUPLICATE_FILTER
+        if(duplicateOpen){
+            keepReply(frame, frameLen);
+        }
+        #endif
+        write(frame, frameLen);
+    }
+    else{
+        #if SERIALCHECKER_DUPLICATE_FILTER
+        if(duplicateOpen){
+            duplicateOpen->replyTooLong = true;
+            duplicateOpen->replyLen = 0;
+        }
+        #endif
+        uint8_t seqLen = useSeqNum ? 2 : 0;
+        size_t len = strlen(message);
+        frameLen = frameHeader(frame, seqNum);
+        char* seq = &frame[frameLen - seqLen];
+        write(frame, frameLen);
+        print(message);
+        if(useChecksum){
+            // The checksums only depend on the sum of the chars, so the sequence number and message can be summed separately.
+            uint8_t sum = sum8(seq, seqLen) + sum8(message, len);
+            print(checksumType == checksumTypeEnum::SpellmanMPS ? spellmanMPSFromSum(sum) : readable8bitCharsFromSum(sum));
+        }
+        print(ETX);
+    }
+}
+
+/**
+ * @brief      As sendFrame(char* message) for a message kept in flash with F(), such as sc.sendFrame(F("OK")). The message is read from flash a few chars at a time as it is sent, so it never needs to fit in RAM.
+ *
+ * @param[in]  message  The message, including the address if there is one
+ *
+ * @return     The sequence number the message was sent with, or SERIALCHECKER_SEQ_NONE if sequence numbers are not used.
+ */
+uint8_t SerialChecker::sendFrame(const __FlashStringHelper* message){
+    if(!useSeqNum){
+        sendFrame(message, SERIALCHECKER_SEQ_NONE);
+        return SERIALCHECKER_SEQ_NONE;
+    }
+    uint8_t sent = txSeqNum;
+    txSeqNum = (txSeqNum + 1) & (SERIALCHECKER_SEQ_COUNT - 1);
+    sendFrame(message, sent);
+    return sent;
+}
+
+/**
+ * @brief      As sendFrame(char* message, uint8_t seqNum) for a message kept in flash with F().
+ *
+ * @param[in]  message  The message, including the address if there is one
+ * @param[in]  seqNum   The sequence number
+ */
+void SerialChecker::sendFrame(const __FlashStringHelper* message, uint8_t seqNum){
+    uint8_t seqLen = useSeqNum ? 2 : 0;
+    char frame[18]; // 16 chars of message at a time plus the checksum and ETX at the end
+    size_t frameLen = frameHeader(frame, seqNum);
+    uint8_t sum = sum8(&frame[frameLen - seqLen], seqLen);
+    const char* p = (const char*)message;
+    char c;
+    while((c = pgm_read_byte(p++))){
+        frame[frameLen++] = c;
+        sum += c;
+        if(frameLen == 16){
+            #if SERIALCHECKER_DUPLICATE_FILTER
+            if(duplicateOpen){
+                keepReply(frame, frameLen);
+            }
+            #endif
+            write(frame, frameLen);
+            frameLen = 0;
+        }
+    }
+    if(useChecksum){
+        frame[frameLen++] = checksumType == checksumTypeEnum::SpellmanMPS ? spellmanMPSFromSum(sum) : readable8bitCharsFromSum(sum);
+    }
+    frame[frameLen++] = ETX;
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    if(duplicateOpen){
+        keepReply(frame, frameLen);
+    }
+    #endif
+    write(frame, frameLen);
+}
+
+#if SERIALCHECKER_REPLY_CACHE
+/**
+ * @brief      Turns on the reply cache, for queries such as "ID?" or "STATUS?" that are polled often and get the same answer most of the time. A handler first tries sendCachedReply(). If that returns false, it works out the answer and sends it with sendFrameCached(), which keeps the framed reply. The next time the same command arrives, sendCachedReply() sends the kept frame with a single write, with no formatting and no checksum to add up. With sequence numbers only the two digits and the checksum char are changed.
+ *
+ * Replies are kept with a version number. Pass one that changes whenever the answer would, such as a count bumped each time the status changes, and a kept reply with an old version is not used. clearReplyCache() forgets them all. Replies are keyed by the whole command including the address, up to SERIALCHECKER_REPLY_CACHE_COMMAND_LEN chars, and are kept if they fit in SERIALCHECKER_REPLY_CACHE_FRAME_LEN chars. Each command has one of SERIALCHECKER_REPLY_CACHE_SIZE slots, picked by a hash of the command, so two commands that share a slot push each other out. Call clearReplyCache() after changing the framing, such as turning the checksum on.
+ *
+ *              if(sc.contains(F("STATUS?"))){
+ *                  if(!sc.sendCachedReply(statusVersion)){
+ *                      // format the status in to reply
+ *                      sc.sendFrameCached(reply, statusVersion);
+ *                  }
+ *              }
+ */
+void SerialChecker::enableReplyCache(){
+    if(!replyCache){
+        replyCache = new CachedReply[SERIALCHECKER_REPLY_CACHE_SIZE]();
+    }
+}
+
+/**
+ * @brief      Turns off the reply cache. sendCachedReply() always returns false and sendFrameCached() sends as sendFrame() does. This is the default.
+ */
+void SerialChecker::disableReplyCache(){
+    delete [] replyCache;
+    replyCache = nullptr;
+}
+
+/**
+ * @brief      Forgets every kept reply, for example when settings change that several answers depend on.
+ */
+void SerialChecker::clearReplyCache(){
+    if(!replyCache){
+        return;
+    }
+    for(uint8_t i = 0; i < SERIALCHECKER_REPLY_CACHE_SIZE; i++){
+        replyCache[i].used = false;
+    }
+}
+
+/**
+ * @brief      Sends the kept reply to the message just received, if there is one for the same command and version.
+ *
+ * @param[in]  version  The version of the answer, as passed to sendFrameCached()
+ *
+ * @return     True if the reply was sent, false if the answer has to be worked out and sent with sendFrameCached().
+ */
+bool SerialChecker::sendCachedReply(uint16_t version){
+    if(!replyCache){
+        return false;
+    }
+    CachedReply& entry = replySlot();
+    if(!entry.used || entry.version != version || entry.commandLen != rawMsgLen || memcmp(entry.command, rawMessage, rawMsgLen) != 0){
+        return false;
+    }
+    if(useSeqNum){
+        static const char hexChars[] PROGMEM = "0123456789ABCDEF";
+        char* seq = &entry.frame[useSTX ? 1 : 0];
+        seq[0] = pgm_read_byte(&hexChars[txSeqNum >> 4]);
+        seq[1] = pgm_read_byte(&hexChars[txSeqNum & 0x0F]);
+        txSeqNum = (txSeqNum + 1) & (SERIALCHECKER_SEQ_COUNT - 1);
+        if(useChecksum){
+            uint8_t sum = entry.sum + sum8(seq, 2);
+            entry.frame[entry.frameLen - 2] = checksumType == checksumTypeEnum::SpellmanMPS ? spellmanMPSFromSum(sum) : readable8bitCharsFromSum(sum);
+        }
+    }
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    if(duplicateOpen){
+        keepReply(entry.frame, entry.frameLen);
+    }
+    #endif
+    write(entry.frame, entry.frameLen);
+    replyCacheHits++;
+    return true;
+}
+
+/**
+ * @brief      Sends a reply as sendFrame(char* message) does and keeps it for sendCachedReply() to send again when the same command next arrives.
+ *
+ * @param      message  The null terminated reply, including the address if one is used.
+ * @param[in]  version  The version of the answer, see enableReplyCache()
+ *
+ * @return     The sequence number the reply was sent with, or SERIALCHECKER_SEQ_NONE if sequence numbers are not used.
+ */
+uint8_t SerialChecker::sendFrameCached(char* message, uint16_t version){
+    uint8_t sent = SERIALCHECKER_SEQ_NONE;
+    if(useSeqNum){
+        sent = txSeqNum;
+        txSeqNum = (txSeqNum + 1) & (SERIALCHECKER_SEQ_COUNT - 1);
+    }
+    char frame[SERIALCHECKER_FRAME_BUFFER_LEN];
+    size_t frameLen = replyCache ? buildFrame(message, sent, frame) : 0;
+    if(!frameLen || frameLen > SERIALCHECKER_REPLY_CACHE_FRAME_LEN || rawMsgLen > SERIALCHECKER_REPLY_CACHE_COMMAND_LEN){
+        sendFrame(message, sent);
+        return sent;
+    }
+    CachedReply& entry = replySlot();
+    entry.used = true;
+    entry.commandLen = rawMsgLen;
+    memcpy(entry.command, rawMessage, rawMsgLen);
+    entry.version = version;
+    entry.sum = sum8(message, strlen(message));
+    entry.frameLen = frameLen;
+    memcpy(entry.frame, frame, frameLen);
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    if(duplicateOpen){
+        keepReply(frame, frameLen);
+    }
+    #endif
+    write(frame, frameLen);
+    return sent;
+}
+
+/**
+ * @brief      Gets the number of replies sent from the reply cache.
+ *
+ * @return     The number of replies.
+ */
+uint32_t SerialChecker::getReplyCacheHits(){
+    return replyCacheHits;
+}
+
+/**
+ * @brief      Picks the reply cache slot for the message just received by hashing the whole command.
+ */
+CachedReply& SerialChecker::replySlot(){
+    uint8_t hash = rawMsgLen;
+    for(uint8_t i = 0; i < rawMsgLen; i++){
+        hash = hash * 31 + rawMessage[i];
+    }
+    return replyCache[(hash ^ (hash >> 4)) & (SERIALCHECKER_REPLY_CACHE_SIZE - 1)];
+}
+#endif
+
+#if SERIALCHECKER_TX_QUEUES
+/**
+ * @brief      Gives a priority class its own queue. Frames sent with sendFrame(message, priority) wait in their class's queue and are only handed to the port when its transmit buffer has room for the whole frame, so the port's buffer never fills up with frames that a more urgent one would have to wait behind. Critical frames always go first, then Control frames, and Bulk frames only go when nothing higher is waiting. So an urgent frame waits behind no more than what is already in the port's buffer, even while bulk data is streaming.
+ *
+ * The queues are emptied by serviceTx(), which check() also calls. A class without a queue has its frames written straight to the port, as sendFrame() does. Frames sent without a priority, and replies such as Acks, are written straight to the port too.
+ *
+ * Each frame takes SERIALCHECKER_TX_ENTRY_HEADER bytes of the buffer plus the frame itself. When a queue is full, Control and Bulk frames are dropped and counted, see getTxStats(). Critical frames are never dropped: sendFrame() waits for the oldest ones to go until there is room.
+ *
+ * @param[in]  priority  The priority class
+ * @param      buffer    The buffer to queue in to, for example a global uint8_t array. It must stay valid while the queue is used.
+ * @param[in]  size      The size of the buffer in bytes
+ */
+void SerialChecker::enableTxQueue(txPriorityEnum priority, uint8_t* buffer, uint16_t size){
+    if(!txQueues){
+        txQueues = new TxQueue[SERIALCHECKER_TX_CLASSES]();
+    }
+    TxQueue& queue = txQueues[(uint8_t)priority];
+    while(queue.used){
+        txSendOldest(queue, true);
+    }
+    queue.buffer = buffer;
+    queue.size = size;
+    queue.head = 0;
+}
+
+/**
+ * @brief      Sends everything still waiting, highest priority first, and goes back to writing every frame straight to the port. This is the default.
+ */
+void SerialChecker::disableTxQueues(){
+    if(!txQueues){
+        return;
+    }
+    for(uint8_t i = 0; i < SERIALCHECKER_TX_CLASSES; i++){
+        while(txQueues[i].used){
+            txSendOldest(txQueues[i], true);
+        }
+    }
+    delete [] txQueues;
+    txQueues = nullptr;
+}
+
+/**
+ * @brief      Sends a frame as sendFrame(char* message) does but through its priority class's queue, see enableTxQueue(). The frame is put together with its sequence number and checksum straight away, so the message buffer can be reused as soon as this returns. Frames longer than SERIALCHECKER_FRAME_BUFFER_LEN are written straight to the port.
+ *
+ * @param      message   The null terminated message, including the address if one is used.
+ * @param[in]  priority  The priority class
+ *
+ * @return     The sequence number the message was sent with, or SERIALCHECKER_SEQ_NONE if sequence numbers are not used or the frame was dropped. A dropped frame doesn't use up a sequence number.
+ */
+uint8_t SerialChecker::sendFrame(char* message, txPriorityEnum priority){
+    TxQueue* queue = txQueues && txQueues[(uint8_t)priority].buffer ? &txQueues[(uint8_t)priority] : nullptr;
+    uint8_t entry[SERIALCHECKER_TX_ENTRY_HEADER + SERIALCHECKER_FRAME_BUFFER_LEN];
+    char* frame = (char*)&entry[SERIALCHECKER_TX_ENTRY_HEADER];
+    uint8_t sent = useSeqNum ? txSeqNum : SERIALCHECKER_SEQ_NONE;
+    uint16_t frameLen = queue ? buildFrame(message, sent, frame) : 0;
+    if(!frameLen){
+        return sendFrame(message);
+    }
+    uint16_t entryLen = SERIALCHECKER_TX_ENTRY_HEADER + frameLen;
+    if(queue->size - queue->used < entryLen){
+        serviceTx();
+    }
+    bool direct = false;
+    if(priority == txPriorityEnum::Critical){
+        while(queue->used && queue->size - queue->used < entryLen){
+            txSendOldest(*queue, true);
+        }
+        direct = queue->size < entryLen; // it will never fit, so it goes straight out
+    }
+    if(!direct && queue->size - queue->used < entryLen){
+        queue->stats.dropped++;
+        return SERIALCHECKER_SEQ_NONE;
+    }
+    // Only now is the frame certain to go out, so only now does it use up a sequence number and count as a reply.
+    if(useSeqNum){
+        txSeqNum = (txSeqNum + 1) & (SERIALCHECKER_SEQ_COUNT - 1);
+    }
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    if(duplicateOpen){
+        keepReply(frame, frameLen);
+    }
+    #endif
+    if(direct){
+        write(frame, frameLen);
+        queue->stats.frames++;
+        return sent;
+    }
+    uint32_t now = micros();
+    entry[0] = frameLen;
+    memcpy(&entry[1], &now, sizeof(now));
+    uint16_t index = queue->head + queue->used;
+    for(uint16_t i = 0; i < entryLen; i++){
+        if(index >= queue->size){
+            index -= queue->size;
+        }
+        queue->buffer[index++] = entry[i];
+    }
+    queue->used += entryLen;
+    txQueued += entryLen;
+    if(queue->used > queue->stats.maxQueued){
+        queue->stats.maxQueued = queue->used;
+    }
+    serviceTx();
+    return sent;
+}
+
+/**
+ * @brief      Hands queued frames to the port while its transmit buffer has room for them, highest priority first. A lower class only gets a turn once every higher class's queue is empty. check() calls this, so it only needs calling from a sketch that sends a lot between calls to check().
+ *
+ * @return     The number of bytes still waiting in the queues.
+ */
+uint16_t SerialChecker::serviceTx(){
+    if(!txQueued){
+        return 0;
+    }
+    for(uint8_t i = 0; i < SERIALCHECKER_TX_CLASSES; i++){
+        while(txQueues[i].used){
+            if(!txSendOldest(txQueues[i], false)){
+                return txQueued;
+            }
+        }
+    }
+    return txQueued;
+}
+
+/**
+ * @brief      Gets the number of bytes waiting in a priority class's queue.
+ *
+ * @param[in]  priority  The priority class
+ *
+ * @return     The number of bytes, including each frame's header.
+ */
+uint16_t SerialChecker::getTxQueued(txPriorityEnum priority){
+    return txQueues ? txQueues[(uint8_t)priority].used : 0;
+}
+
+/**
+ * @brief      Gets the counts kept for a priority class: the frames sent and dropped, their time in queue and the most bytes waiting at once. The mean time in queue is totalMicros / frames.
+ *
+ * @param[in]  priority  The priority class
+ *
+ * @return     The stats, all 0 if enableTxQueue() hasn't been used.
+ */
+TxStats SerialChecker::getTxStats(txPriorityEnum priority){
+    if(!txQueues){
+        TxStats none = {};
+        return none;
+    }
+    return txQueues[(uint8_t)priority].stats;
 }
 
 /**
- * @brief      Converts the message buffer (starting at startIndex) to an int16_t. This works for both unsigned and signed ints as long as the container it is loaded in to is of the correct type.
+ * @brief      Sets the counts kept for every priority class back to 0.
+ */
+void SerialChecker::clearTxStats(){
+    if(!txQueues){
+        return;
+    }
+    for(uint8_t i = 0; i < SERIALCHECKER_TX_CLASSES; i++){
+        txQueues[i].stats = TxStats();
+    }
+}
+
+/**
+ * @brief      Hands the oldest frame in a queue to the port and records its time in queue. A frame bigger than the port's transmit buffer, such as a 64 char frame on an arduino whose buffer takes 63, could never find room for all of it. It goes once the buffer is as empty as it has ever been seen, and write() waits for the rest.
  *
- * @param[in]  startIndex  The start index
+ * @param      queue  The queue
+ * @param[in]  wait   True to write it even if the port's buffer is full, waiting as write() does
  *
- * @return     the converted int16_t
+ * @return     False if the port didn't have room for it.
  */
-uint16_t SerialChecker::toInt16(uint8_t startIndex){
-    // Returns the number stored in a char array, starting at startIndex
-    uint16_t number = 0;
-    bool negative = false;
-    if( message[startIndex] == '-'){
-        negative = true;
-        startIndex++;
-    }
-    // for(int i = startIndex; i < rawMsgLen - addressLen; i++) 
-    // {
-    //     number *= 10;
-    //     number += (message[i] -'0');        
-    // }
-    while(message[startIndex]){
-        if( (message[startIndex] >= '0' && message[startIndex] <= '9') ){
-            number *= 10;
-            number += (message[startIndex] -'0');
+bool SerialChecker::txSendOldest(TxQueue& queue, bool wait){
+    uint8_t frameLen = queue.buffer[queue.head];
+    if(!wait){
+        int room = availableForWrite();
+        if(room > txRoomMax){
+            txRoomMax = room > 255 ? 255 : room;
         }
-        else{
-            break;
+        if(room < frameLen && room < txRoomMax){
+            return false;
         }
-        startIndex++;
     }
-    if(negative){
-        number *= -1;
+    uint8_t entry[SERIALCHECKER_TX_ENTRY_HEADER + SERIALCHECKER_FRAME_BUFFER_LEN];
+    uint16_t entryLen = SERIALCHECKER_TX_ENTRY_HEADER + frameLen;
+    for(uint16_t i = 0; i < entryLen; i++){
+        entry[i] = queue.buffer[queue.head++];
+        if(queue.head >= queue.size){
+            queue.head = 0;
+        }
     }
-    return number;
+    queue.used -= entryLen;
+    txQueued -= entryLen;
+    uint32_t queuedAt;
+    memcpy(&queuedAt, &entry[1], sizeof(queuedAt));
+    uint32_t waited = micros() - queuedAt;
+    queue.stats.frames++;
+    queue.stats.totalMicros += waited;
+    if(waited > queue.stats.maxMicros){
+        queue.stats.maxMicros = waited;
+    }
+    write((char*)&entry[SERIALCHECKER_TX_ENTRY_HEADER], frameLen);
+    return true;
 }
+#endif
 
 /**
- * @brief      Converts the message buffer to an int16_t. This works for both unsigned and signed ints as long as the container it is loaded in to is of the correct type.
+ * @brief      Puts a whole frame together, as sendFrame() sends it, if it fits in SERIALCHECKER_FRAME_BUFFER_LEN chars.
  *
- * @return     the converted int16_t
+ * @param      message  The null terminated message
+ * @param[in]  seqNum   The sequence number
+ * @param      frame    The buffer, SERIALCHECKER_FRAME_BUFFER_LEN chars long
+ *
+ * @return     The length of the frame, or 0 if it doesn't fit.
  */
-uint16_t SerialChecker::toInt16(){
-    // Returns the number stored in a char array, starting at startIndex
-    uint8_t startIndex = 0;
-    while(message[startIndex]){
-        if((message[startIndex] == '-') || 
-            (message[startIndex] >= '0' && message[startIndex] <= '9')){
-            break;
-        }
-        startIndex++;
+size_t SerialChecker::buildFrame(char* message, uint8_t seqNum, char* frame){
+    uint8_t seqLen = useSeqNum ? 2 : 0;
+    size_t len = strlen(message);
+    size_t frameLen = frameHeader(frame, seqNum);
+    if(len + frameLen + 2 > SERIALCHECKER_FRAME_BUFFER_LEN){
+        return 0;
     }
-    return toInt16(startIndex);
+    memcpy(&frame[frameLen], message, len);
+    frameLen += len;
+    if(useChecksum){
+        frame[frameLen] = calcChecksum(&frame[frameLen - len - seqLen], len + seqLen);
+        frameLen++;
+    }
+    frame[frameLen++] = ETX;
+    return frameLen;
 }
 
 /**
- * @brief      Converts the message buffer (starting at startIndex) to an int32_t. This works for both unsigned and signed ints as long as the container it is loaded in to is of the correct type.
+ * @brief      Puts the STX char and sequence number that start a frame, if they are used, in to a buffer.
  *
- * @param[in]  startIndex  The start index
+ * @param      frame   The buffer, with room for at least 3 chars
+ * @param[in]  seqNum  The sequence number
  *
- * @return     the converted int32_t
+ * @return     The number of chars used.
  */
-uint32_t SerialChecker::toInt32(uint8_t startIndex){
-    // Returns the number stored in a char array, starting at startIndex
-    uint32_t number = 0;
-    bool negative = false;
-    if( message[startIndex] == '-'){
-        negative = true;
-        startIndex++;
-    }
-    // for(int i = startIndex; i < rawMsgLen - addressLen; i++) 
-    // {
-    //     number *= 10;
-    //     number += (message[i] -'0');
-    // }
-    while(message[startIndex]){
-        if( (message[startIndex] >= '0' && message[startIndex] <= '9') ){
-            number *= 10;
-            number += (message[startIndex] -'0');
-        }
-        else{
-            break;
-        }
-        startIndex++;
+size_t SerialChecker::frameHeader(char* frame, uint8_t seqNum){
+    static const char hexChars[] PROGMEM = "0123456789ABCDEF";
+    size_t frameLen = 0;
+    if(useSTX){
+        frame[frameLen++] = STX;
     }
-    if(negative){
-        number *= -1;
+    if(useSeqNum){
+        frame[frameLen++] = pgm_read_byte(&hexChars[seqNum >> 4]);
+        frame[frameLen++] = pgm_read_byte(&hexChars[seqNum & 0x0F]);
     }
-    return number;
+    return frameLen;
 }
 
 /**
- * @brief      Converts the message buffer to an int32_t. This works for both unsigned and signed ints as long as the container it is loaded in to is of the correct type.
+ * @brief      Same as Serial's .availableForWrite method: how many chars can be written without waiting.
  *
- * @return     the converted int32_t
+ * @return     The number of chars. Checkers without a port can always take a whole frame.
  */
-uint32_t SerialChecker::toInt32(){
-    // Returns the number stored in a char array, starting at startIndex
-    uint32_t number = 0;
-    bool negative = false;
-    uint8_t startIndex = 0;
-    while(message[startIndex]){
-        if((message[startIndex] == '-') || 
-            (message[startIndex] >= '0' && message[startIndex] <= '9')){
-            break;
-        }
-        startIndex++;
+int SerialChecker::availableForWrite(){
+    switch (serialType) {
+    #ifdef USBserial_h_
+        case serialTypes::USB:
+            return port.usb->availableForWrite();
+    #endif
+    #ifdef USBCON
+        case serialTypes::ATMEGAXXU4:
+            return port.atmegaXXu4->availableForWrite();
+    #endif
+    #ifdef ARDUINO
+        case serialTypes::HardWare:
+            return port.hardware->availableForWrite();
+    #else
+        case serialTypes::POSIX:
+            return port.posix->availableForWrite();
+    #endif
+        case serialTypes::NoPort:
+        default:
+            return SERIALCHECKER_FRAME_BUFFER_LEN;
     }
-    return toInt32(startIndex);
 }
 
 /**
- * @brief      Sends an Ack char followed by the ETX char.
+ * @brief      Same as Serial's .write method for a buffer of chars.
+ *
+ * @param      buffer  The chars to send
+ * @param[in]  len     The number of chars
  */
-void SerialChecker::sendAck(){
+void SerialChecker::write(const char* buffer, size_t len){
     switch (serialType) {
     #ifdef USBserial_h_
         case serialTypes::USB:
-            port.usb->println(Ack);
+            port.usb->write(buffer, len);
             break;
     #endif
     #ifdef USBCON
         case serialTypes::ATMEGAXXU4:
-            port.atmegaXXu4->println(Ack);
+            port.atmegaXXu4->write(buffer, len);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
-            port.hardware->println(Ack);
+            port.hardware->write(buffer, len);
+            break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->write(buffer, len);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
             break;
     }
 }
 
 /**
- * @brief      Sends an Nak char followed by the ETX char.
+ * @brief      Same as Serial's .print method.
+ *
+ * @param      message  The c style string message
  */
-void SerialChecker::sendNak(){
+void SerialChecker::print(char* message){
     switch (serialType) {
     #ifdef USBserial_h_
         case serialTypes::USB:
-            port.usb->println(Nak);
+            port.usb->print(message);
             break;
     #endif
     #ifdef USBCON
         case serialTypes::ATMEGAXXU4:
-            port.atmegaXXu4->println(Nak);
+            port.atmegaXXu4->print(message);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
-            port.hardware->println(Nak);
+            port.hardware->print(message);
+            break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(message);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
             break;
     }
 }
 
 /**
- * @brief      Same as Serial's .print method.
+ * @brief      Same as Serial's .print method for a string kept in flash with F(), such as sc.print(F("Checksum turned on.")). It is sent straight from flash without using any RAM.
  *
- * @param      message  The c style string message
+ * @param[in]  message  The string
  */
-void SerialChecker::print(char* message){
+void SerialChecker::print(const __FlashStringHelper* message){
     switch (serialType) {
     #ifdef USBserial_h_
         case serialTypes::USB:
@@ -1209,9 +2843,18 @@ void SerialChecker::print(char* message){
             port.atmegaXXu4->print(message);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->print(message);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(message);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1232,9 +2875,18 @@ void SerialChecker::print(char c){
             port.atmegaXXu4->print(c);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->print(c);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(c);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1255,9 +2907,18 @@ void SerialChecker::print(uint8_t n){
             port.atmegaXXu4->print(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->print(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1278,9 +2939,18 @@ void SerialChecker::print(uint16_t n){
             port.atmegaXXu4->print(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->print(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1301,9 +2971,18 @@ void SerialChecker::print(uint32_t n){
             port.atmegaXXu4->print(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->print(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1324,9 +3003,18 @@ void SerialChecker::print(int8_t n){
             port.atmegaXXu4->print(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->print(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1347,9 +3035,18 @@ void SerialChecker::print(int16_t n){
             port.atmegaXXu4->print(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->print(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1370,9 +3067,18 @@ void SerialChecker::print(int32_t n){
             port.atmegaXXu4->print(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->print(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1393,9 +3099,18 @@ void SerialChecker::print(float n){
             port.atmegaXXu4->print(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->print(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1416,9 +3131,18 @@ void SerialChecker::print(double n){
             port.atmegaXXu4->print(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->print(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->print(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1439,9 +3163,50 @@ void SerialChecker::println(char* message){
             port.atmegaXXu4->println(message);
             break;
     #endif
+    #ifdef ARDUINO
+        case serialTypes::HardWare:
+            port.hardware->println(message);
+            break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(message);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief      Same as Serial's .println method for a string kept in flash with F(), such as sc.println(F("Checksum turned on.")). It is sent straight from flash without using any RAM.
+ *
+ * @param[in]  message  The string
+ */
+void SerialChecker::println(const __FlashStringHelper* message){
+    switch (serialType) {
+    #ifdef USBserial_h_
+        case serialTypes::USB:
+            port.usb->println(message);
+            break;
+    #endif
+    #ifdef USBCON
+        case serialTypes::ATMEGAXXU4:
+            port.atmegaXXu4->println(message);
+            break;
+    #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println(message);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(message);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1462,9 +3227,18 @@ void SerialChecker::println(char c){
             port.atmegaXXu4->println(c);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println(c);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(c);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1485,9 +3259,18 @@ void SerialChecker::println(uint8_t n){
             port.atmegaXXu4->println(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1508,9 +3291,18 @@ void SerialChecker::println(uint16_t n){
             port.atmegaXXu4->println(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1531,9 +3323,18 @@ void SerialChecker::println(uint32_t n){
             port.atmegaXXu4->println(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1554,9 +3355,18 @@ void SerialChecker::println(int8_t n){
             port.atmegaXXu4->println(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1577,9 +3387,18 @@ void SerialChecker::println(int16_t n){
             port.atmegaXXu4->println(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1600,9 +3419,18 @@ void SerialChecker::println(int32_t n){
             port.atmegaXXu4->println(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1623,9 +3451,18 @@ void SerialChecker::println(float n){
             port.atmegaXXu4->println(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1646,9 +3483,18 @@ void SerialChecker::println(double n){
             port.atmegaXXu4->println(n);
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println(n);
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println(n);
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
     }
 }
 
@@ -1669,8 +3515,138 @@ void SerialChecker::println(){
             port.atmegaXXu4->println();
             break;
     #endif
+    #ifdef ARDUINO
         case serialTypes::HardWare:
             port.hardware->println();
             break;
+    #else
+        case serialTypes::POSIX:
+            port.posix->println();
+            break;
+    #endif
+        case serialTypes::NoPort:
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief      Writes a scaled integer, as read by toScaled(), as a decimal number. For example, 12345 with a scale of 1000 is written as "12.345". Only integer arithmetic is used.
+ *
+ * @param[in]  n      The scaled integer
+ * @param[in]  scale  A power of 10
+ * @param      out    Where to write it, at least SERIALCHECKER_NUMBER_BUFFER_LEN chars
+ *
+ * @return     The number of chars written. The null is not added.
+ */
+uint8_t SerialChecker::formatScaled(int32_t n, uint32_t scale, char* out){
+    uint8_t len = 0;
+    uint32_t magnitude = n;
+    if(n < 0){
+        out[len++] = '-';
+        magnitude = 0 - magnitude;
+    }
+    len += formatUnsigned(magnitude / scale, &out[len]);
+    if(scale > 1){
+        uint32_t fraction = magnitude % scale;
+        out[len++] = '.';
+        for(uint32_t place = scale / 10; place; place /= 10){
+            out[len++] = '0' + fraction / place % 10;
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief      Writes a fixed point number, as read by toFixed<Q>(), as a decimal number rounded to the given decimals. For example, 384 with 8 fraction bits and 2 decimals is written as "1.50". Only integer arithmetic is used.
+ *
+ * @param[in]  n         The fixed point number
+ * @param[in]  fracBits  The number of fraction bits, up to 24
+ * @param[in]  decimals  The number of decimals, up to 9
+ * @param      out       Where to write it, at least SERIALCHECKER_NUMBER_BUFFER_LEN chars
+ *
+ * @return     The number of chars written. The null is not added.
+ */
+uint8_t SerialChecker::formatFixed(int32_t n, uint8_t fracBits, uint8_t decimals, char* out){
+    if(decimals > 9){
+        decimals = 9;
+    }
+    uint32_t magnitude = n < 0 ? 0 - (uint32_t)n : n;
+    uint32_t whole = magnitude >> fracBits;
+    uint32_t fraction = magnitude & (((uint32_t)1 << fracBits) - 1);
+    char digits[9];
+    for(uint8_t i = 0; i < decimals; i++){
+        fraction *= 10; // fits as there are at most 24 fraction bits
+        digits[i] = '0' + (fraction >> fracBits);
+        fraction &= ((uint32_t)1 << fracBits) - 1;
+    }
+    // Round half up on what is left, carrying back through the digits.
+    if(fracBits && fraction >= (uint32_t)1 << (fracBits - 1)){
+        uint8_t i = decimals;
+        while(i > 0 && digits[i - 1] == '9'){
+            digits[--i] = '0';
+        }
+        if(i > 0){
+            digits[i - 1]++;
+        }
+        else{
+            whole++;
+        }
+    }
+    bool zero = whole == 0;
+    for(uint8_t i = 0; i < decimals; i++){
+        zero &= digits[i] == '0';
+    }
+    uint8_t len = 0;
+    if(n < 0 && !zero){ // not -0.00
+        out[len++] = '-';
+    }
+    len += formatUnsigned(whole, &out[len]);
+    if(decimals){
+        out[len++] = '.';
+        memcpy(&out[len], digits, decimals);
+        len += decimals;
+    }
+    return len;
+}
+
+/**
+ * @brief      Writes n in decimal.
+ *
+ * @return     The number of chars written. The null is not added.
+ */
+uint8_t SerialChecker::formatUnsigned(uint32_t n, char* out){
+    char digits[10];
+    uint8_t count = 0;
+    do{
+        digits[count++] = '0' + n % 10;
+        n /= 10;
+    } while(n);
+    for(uint8_t i = 0; i < count; i++){
+        out[i] = digits[count - 1 - i];
     }
-}
\ No newline at end of file
+    return count;
+}
+
+/**
+ * @brief      Prints a scaled integer, as read by toScaled(), as a decimal number, without using floats. See formatScaled().
+ *
+ * @param[in]  n      The scaled integer
+ * @param[in]  scale  A power of 10
+ */
+void SerialChecker::printScaled(int32_t n, uint32_t scale){
+    char buffer[SERIALCHECKER_NUMBER_BUFFER_LEN];
+    buffer[formatScaled(n, scale, buffer)] = '\0';
+    print(buffer);
+}
+
+/**
+ * @brief      Same as printScaled() followed by a new line.
+ *
+ * @param[in]  n      The scaled integer
+ * @param[in]  scale  A power of 10
+ */
+void SerialChecker::printlnScaled(int32_t n, uint32_t scale){
+    printScaled(n, scale);
+    println();
+}
@@ -1,21 +1,99 @@
 #ifndef SERIALCHECKER_H
 #define SERIALCHECKER_H
 
-#include<arduino.h>
+#ifdef ARDUINO
+#include<Arduino.h>
 #include<HardwareSerial.h>
+#else
+#include "PosixSerial.h" // host build: SerialChecker runs on a tty or pty file descriptor instead
+#endif
+
+/**
+ * @brief      Largest frame that sendFrame() puts together in one buffer before sending it with a single write. Longer frames are sent in pieces.
+ */
+#ifndef SERIALCHECKER_FRAME_BUFFER_LEN
+#define SERIALCHECKER_FRAME_BUFFER_LEN 64
+#endif
+
+/**
+ * @brief      Optional features can be left out at compile time. Each one's switch is 1 to compile it in or 0 to leave it out, in which case its functions don't exist and its state and per char checks cost nothing. On an arduino every checker would otherwise carry each feature's state in SRAM, so they are left out by default there and compiled in by default on a PC. Turn one on for an arduino with a build flag, such as -DSERIALCHECKER_RECORDER=1 in PlatformIO's build_flags.
+ */
+#ifdef ARDUINO
+#define SERIALCHECKER_FEATURE_DEFAULT 0
+#else
+#define SERIALCHECKER_FEATURE_DEFAULT 1
+#endif
+
+/**
+ * @brief      The traffic recorder, see enableRecorder().
+ */
+#ifndef SERIALCHECKER_RECORDER
+#define SERIALCHECKER_RECORDER SERIALCHECKER_FEATURE_DEFAULT
+#endif
+
+/**
+ * @brief      Ack batching, see enableAckBatching().
+ */
+#ifndef SERIALCHECKER_ACK_BATCHING
+#define SERIALCHECKER_ACK_BATCHING SERIALCHECKER_FEATURE_DEFAULT
+#endif
+
+/**
+ * @brief      The message hook that SerialCheckerRegisters answers its messages with, see setMessageHook(). It costs two pointers and is only tested once per message, so unlike the others it is compiled in on an arduino too.
+ */
+#ifndef SERIALCHECKER_MESSAGE_HOOK
+#define SERIALCHECKER_MESSAGE_HOOK 1
+#endif
+
+/**
+ * @brief      The duplicate filter, see enableDuplicateFilter().
+ */
+#ifndef SERIALCHECKER_DUPLICATE_FILTER
+#define SERIALCHECKER_DUPLICATE_FILTER SERIALCHECKER_FEATURE_DEFAULT
+#endif
+
+/**
+ * @brief      The reply cache, see enableReplyCache().
+ */
+#ifndef SERIALCHECKER_REPLY_CACHE
+#define SERIALCHECKER_REPLY_CACHE SERIALCHECKER_FEATURE_DEFAULT
+#endif
+
+/**
+ * @brief      Priority transmit queues, see enableTxQueue().
+ */
+#ifndef SERIALCHECKER_TX_QUEUES
+#define SERIALCHECKER_TX_QUEUES SERIALCHECKER_FEATURE_DEFAULT
+#endif
+
+/**
+ * @brief      Address filters, see addAddress().
+ */
+#ifndef SERIALCHECKER_ADDRESS_FILTER
+#define SERIALCHECKER_ADDRESS_FILTER SERIALCHECKER_FEATURE_DEFAULT
+#endif
+
+/**
+ * @brief      Big enough for any number formatted by formatScaled() or formatFixed(): a sign, 10 digits, a point, 9 decimals and the null.
+ */
+#define SERIALCHECKER_NUMBER_BUFFER_LEN 24
 
 /**
  * @brief      Borrowing from https://github.com/synfinatic/AnySerial to get USB and HardwareSerial working
- *              Need an enum to tell what type of serial is used
+ *              Need an enum to tell what type of serial is used. NoPort is for checkers that are only fed with checkChar() or loadMsg(). Anything they send is dropped.
  */
-enum class serialTypes{ USB, HardWare, ATMEGAXXU4 };
+enum class serialTypes{ USB, HardWare, ATMEGAXXU4, POSIX, NoPort };
 
 /**
  * @brief      Borrowing from https://github.com/synfinatic/AnySerial to get USB and HardwareSerial working
  *              Need this typedef thingy to tell which type of port is used.
  */
 typedef union {
+#ifdef ARDUINO
     HardwareSerial *hardware;
+#else
+    PosixSerial *posix;
+#endif
 #ifdef USBserial_h_
     usb_serial_class *usb;
 #endif
@@ -28,7 +106,164 @@ typedef union {
  * @brief      Different types of checksum algorithm can be used. At the moment the choice is limited to just two simple ones that only produce a limited set of printable chars.
  */
 enum class checksumTypeEnum{ SpellmanMPS, Readable8bitChars };
+/**
+ * @brief      The reasons check() can throw a received message away. See getLastError().
+ */
+enum class frameErrorEnum{ None, TooShort, TooLong, BadChecksum, MissingSTX, BadSeqNum };
+
+/**
+ * @brief      Recorder timestamps count in ticks of 2^SERIALCHECKER_RECORDER_TICK_SHIFT us. The default of 4 us keeps the gap between chars at 250000 baud (40 us) small enough to fit in the entry header byte.
+ */
+#ifndef SERIALCHECKER_RECORDER_TICK_SHIFT
+#define SERIALCHECKER_RECORDER_TICK_SHIFT 2
+#endif
+
+/**
+ * @brief      Types of recorder entry, stored in the top two bits of each entry's header byte. The bottom six bits hold the time since the previous entry in ticks, with 63 meaning that a varint of the full time follows. A received char entry is followed by the char and an event entry by a recorderEventEnum.
+ */
+enum class recorderEntryEnum{ ReceivedChar = 0, Event = 1 };
+
+/**
+ * @brief      Events that the recorder logs along with the received chars. The rejection events line up with frameErrorEnum.
+ */
+enum class recorderEventEnum{ Accepted = 0, TooShort = 1, TooLong = 2, BadChecksum = 3, MissingSTX = 4, BadSeqNum = 5 };
+
+/**
+ * @brief      Sequence numbers, see enableSeqNum(), count from 0 to SERIALCHECKER_SEQ_COUNT - 1 and then wrap around. They are sent as two hex digits. SERIALCHECKER_SEQ_NONE is sent in the Naks for frames that were too damaged for their sequence number to be trusted.
+ */
+#define SERIALCHECKER_SEQ_COUNT 128
+#define SERIALCHECKER_SEQ_NONE 0xFF
+
+/**
+ * @brief      The number of addresses longer than 1 char that addAddress() can hold. It must be a power of two.
+ */
+#ifndef SERIALCHECKER_ADDRESS_TABLE_SIZE
+#define SERIALCHECKER_ADDRESS_TABLE_SIZE 8
+#endif
+
+/**
+ * @brief      The kinds of address a node can answer to, see addAddress(). A message sent to a group address is for several nodes and one sent to the broadcast address is for all of them.
+ */
+enum class addressKindEnum{ None, Unicast, Group, Broadcast };
+
+/**
+ * @brief      The number of recent messages enableDuplicateFilter() remembers. It must be a power of two.
+ */
+#ifndef SERIALCHECKER_DUPLICATE_CACHE_SIZE
+#define SERIALCHECKER_DUPLICATE_CACHE_SIZE 8
+#endif
+
+/**
+ * @brief      The longest reply to a message that enableDuplicateFilter() keeps to send again, enough for an Ack frame or a short answer.
+ */
+#ifndef SERIALCHECKER_DUPLICATE_REPLY_LEN
+#define SERIALCHECKER_DUPLICATE_REPLY_LEN 12
+#endif
+
+/**
+ * @brief      How many chars from the start of a message enableDuplicateFilter() keeps, along with its length and hash, to tell it apart from a different message with the same hash.
+ */
+#ifndef SERIALCHECKER_DUPLICATE_MATCH_LEN
+#define SERIALCHECKER_DUPLICATE_MATCH_LEN 4
+#endif
+
+/**
+ * @brief      A message remembered by enableDuplicateFilter() and the reply sent to it.
+ */
+struct DuplicateEntry{
+    bool used;
+    bool acked; // with Ack batching, so there are no Ack chars to keep
+    bool replyTooLong;
+    uint8_t seqNum; // SERIALCHECKER_SEQ_NONE without sequence numbers
+    uint16_t hash; // of the address and message
+    uint8_t msgLen;
+    char msgStart[SERIALCHECKER_DUPLICATE_MATCH_LEN];
+    uint8_t replyLen;
+    uint32_t seenMillis;
+    char reply[SERIALCHECKER_DUPLICATE_REPLY_LEN];
+};
+
+/**
+ * @brief      The number of replies enableReplyCache() keeps. It must be a power of two.
+ */
+#ifndef SERIALCHECKER_REPLY_CACHE_SIZE
+#define SERIALCHECKER_REPLY_CACHE_SIZE 4
+#endif
+
+/**
+ * @brief      The longest command, address included, and the longest framed reply that enableReplyCache() keeps.
+ */
+#ifndef SERIALCHECKER_REPLY_CACHE_COMMAND_LEN
+#define SERIALCHECKER_REPLY_CACHE_COMMAND_LEN 12
+#endif
+#ifndef SERIALCHECKER_REPLY_CACHE_FRAME_LEN
+#define SERIALCHECKER_REPLY_CACHE_FRAME_LEN 32
+#endif
+
+/**
+ * @brief      A reply kept by sendFrameCached(): the command it answers and the whole frame as it was sent.
+ */
+struct CachedReply{
+    bool used;
+    uint8_t commandLen;
+    uint16_t version;
+    uint8_t sum; // of the message chars, to work out the checksum for a new sequence number
+    uint8_t frameLen;
+    char command[SERIALCHECKER_REPLY_CACHE_COMMAND_LEN];
+    char frame[SERIALCHECKER_REPLY_CACHE_FRAME_LEN];
+};
+
+/**
+ * @brief      Priority classes for frames sent with sendFrame(message, priority), see enableTxQueue(). Critical frames always go out first, then Control frames, and Bulk frames only when nothing else is waiting.
+ */
+enum class txPriorityEnum{ Critical = 0, Control = 1, Bulk = 2 };
+#define SERIALCHECKER_TX_CLASSES 3
+
+/**
+ * @brief      Each queued frame is stored after a length byte and the micros() it was queued at.
+ */
+#define SERIALCHECKER_TX_ENTRY_HEADER 5
+#if SERIALCHECKER_FRAME_BUFFER_LEN > 255
+#error "Queued frames keep their length in a byte, so SERIALCHECKER_FRAME_BUFFER_LEN can be at most 255"
+#endif
+
+/**
+ * @brief      Counts kept for each priority class, see getTxStats(). The time in queue is from sendFrame() to the frame being handed to the port.
+ */
+struct TxStats{
+    uint32_t frames; // handed to the port
+    uint32_t dropped; // no room in the queue
+    uint32_t totalMicros; // time in queue of all the frames, for the mean
+    uint32_t maxMicros; // longest time in queue
+    uint16_t maxQueued; // most bytes waiting at once
+};
+
+/**
+ * @brief      One priority class's queue of frames ready to send, in a ring buffer supplied by the user.
+ */
+struct TxQueue{
+    uint8_t* buffer;
+    uint16_t size;
+    uint16_t head; // the oldest frame
+    uint16_t used;
+    TxStats stats;
+};
 // enum class charNumTypeEnum{ NaN, DecPoint, MinusSign, Integer };
+/**
+ * @brief      Called by check() for every message it receives, see setMessageHook().
+ *
+ * @return     True if the hook has dealt with the message, so check() doesn't return it.
+ */
+typedef bool (*messageHook)(void* context);
+
+class SerialChecker;
+/**
+ * @brief      Feeds the chars waiting at a checker's port to its checkChar() until a message is complete, see checkWith().
+ *
+ * @return     The length of the message, or 0 if no complete, valid message has been received.
+ */
+typedef uint8_t (*messageReader)(SerialChecker& checker);
+
 /**
  * @brief      SerialChecker is an Arduino based class for the easy handling of serial messages.
  *              SerialChecker can be used to check incoming messages  
@@ -36,10 +271,17 @@ enum class checksumTypeEnum{ SpellmanMPS, Readable8bitChars };
 class SerialChecker{
 public:
     // SerialChecker(); // defaults to message of length 13, Serial and baudrate of 250000 
+    #ifdef ARDUINO
     SerialChecker(uint16_t msgMaxLen, HardwareSerial& HSerial, uint32_t baudrate);
     SerialChecker(HardwareSerial& port);
     // SerialChecker(); // defaults to message of length 13, Serial and baudrate of 250000 
     SerialChecker(HardwareSerial& port, uint32_t baudrate);
+    #else
+    SerialChecker(uint16_t msgMaxLen, PosixSerial& port, uint32_t baudrate);
+    SerialChecker(PosixSerial& port);
+    SerialChecker(PosixSerial& port, uint32_t baudrate);
+    #endif
+    SerialChecker(uint16_t msgMaxLen);
     #ifdef USBserial_h_
     SerialChecker(usb_serial_class& port);
     SerialChecker(usb_serial_class& port, uint32_t baudrate);
@@ -50,6 +292,9 @@ public:
     #endif
     ~SerialChecker();
     void init();
+    void setBaudrate(uint32_t baudrate);
+    uint32_t getBaudrate();
+    void flush();
     void disableAckNak();
     void enableAckNak();
     void enableAckNak(char Ack, char Nak);
@@ -62,10 +307,41 @@ public:
     void setETX(char ETX);
     void setAllowCR(bool allowCR);
     bool getAllowCR();
+    void enableSeqNum();
+    void disableSeqNum();
+    uint8_t getSeqNum();
+    bool isAck();
+    bool isNak();
+    uint32_t getAckBitmap();
+    uint8_t getAckCount();
+    #if SERIALCHECKER_ACK_BATCHING
+    void enableAckBatching(uint8_t maxFrames, uint32_t maxMicros);
+    void disableAckBatching();
+    void flushAcks();
+    #endif
+    #if SERIALCHECKER_MESSAGE_HOOK
+    void setMessageHook(messageHook hook, void* context);
+    #endif
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    void enableDuplicateFilter(uint32_t windowMillis);
+    void disableDuplicateFilter();
+    uint32_t getDuplicateCount();
+    #endif
     uint8_t check();
+    uint8_t checkChar(char in);
+    frameErrorEnum getLastError();
+    void clearLastError();
+    #if SERIALCHECKER_RECORDER
+    void enableRecorder(uint8_t* buffer, uint16_t size);
+    void disableRecorder();
+    void clearRecorder();
+    uint16_t getRecorderUsed();
+    void dumpRecorder();
+    #endif
     char* getAddress();
     char getAddressChar();
     char* getRawMsg();
+    uint8_t loadMsg(const char* rawMsg, uint8_t len);
     uint8_t getRawMsgLen();
     char* getMsg();
     char* getMsg(uint8_t startIndex);
@@ -75,16 +351,29 @@ public:
     void setAddressLen(uint8_t len);
     uint8_t getAddressLen();
     bool addressMatch(char* addressToMatch);
+    bool addressMatch(const __FlashStringHelper* addressToMatch);
+    #if SERIALCHECKER_ADDRESS_FILTER
+    void setAddressFilter(char* address);
+    void clearAddressFilter();
+    bool addAddress(char* address, addressKindEnum kind);
+    void clearAddresses();
+    addressKindEnum getAddressKind();
+    uint32_t getSkippedCount();
+    #endif
     bool contains(char* snippet, uint8_t startIndex);
     bool contains(char* snippet);
+    bool contains(const __FlashStringHelper* snippet, uint8_t startIndex);
+    bool contains(const __FlashStringHelper* snippet);
     bool contains(const char& c, uint8_t startIndex);
     bool contains(const char& c);
     char calcChecksum(char* rawMessage, int len);
     char calcChecksum(char* rawMessage);
-    char chksmSpellmanMPS(char* rawMessage, int len);
-    char chksmSpellmanMPS(char* rawMessage);
-    char chksm8bitAllReadableChars(char* rawMessage, int len);
-    char chksm8bitAllReadableChars(char* rawMessage);
+    static char chksmSpellmanMPS(const char* rawMessage, int len);
+    static char chksmSpellmanMPS(const char* rawMessage);
+    static char chksm8bitAllReadableChars(const char* rawMessage, int len);
+    static char chksm8bitAllReadableChars(const char* rawMessage);
+    static char spellmanMPSFromSum(uint8_t checksum);
+    static char readable8bitCharsFromSum(uint8_t checksum);
     // void setCheckConversion(bool checkConversion);
     // bool getCheckConversion();
     // charNumTypeEnum getNumType(const char& c);
@@ -97,9 +386,47 @@ public:
     uint16_t toInt16();
     uint32_t toInt32(uint8_t startIndex); // reads until end of message
     uint32_t toInt32(); // reads from first numeric or minus sign
+    int32_t toScaled(uint8_t startIndex, uint32_t scale); // "12.345" with a scale of 1000 gives 12345
+    int32_t toScaled(uint32_t scale);
+    template<uint8_t Q> int32_t toFixed(uint8_t startIndex){ // Q fraction bits, "1.5" as toFixed<8>() gives 384
+        static_assert(Q <= 24, "toFixed() takes at most 24 fraction bits");
+        return toFixedBits(startIndex, Q);
+    }
+    template<uint8_t Q> int32_t toFixed(){
+        static_assert(Q <= 24, "toFixed() takes at most 24 fraction bits");
+        return toFixedBits(firstNumberIndex(), Q);
+    }
+    static uint8_t formatScaled(int32_t n, uint32_t scale, char* out);
+    static uint8_t formatFixed(int32_t n, uint8_t fracBits, uint8_t decimals, char* out);
     void sendAck(); // sends an acknowledge char
+    void sendAck(uint8_t seqNum);
     void sendNak(); // sends a not acknowledge char
+    void sendNak(uint8_t seqNum);
+    uint8_t sendFrame(char* message); // sends STX, message, checksum and ETX as configured
+    void sendFrame(char* message, uint8_t seqNum);
+    uint8_t sendFrame(const __FlashStringHelper* message);
+    void sendFrame(const __FlashStringHelper* message, uint8_t seqNum);
+    #if SERIALCHECKER_REPLY_CACHE
+    void enableReplyCache();
+    void disableReplyCache();
+    void clearReplyCache();
+    bool sendCachedReply(uint16_t version);
+    uint8_t sendFrameCached(char* message, uint16_t version);
+    uint32_t getReplyCacheHits();
+    #endif
+    #if SERIALCHECKER_TX_QUEUES
+    void enableTxQueue(txPriorityEnum priority, uint8_t* buffer, uint16_t size);
+    void disableTxQueues();
+    uint8_t sendFrame(char* message, txPriorityEnum priority); // queued behind higher priority frames
+    uint16_t serviceTx();
+    uint16_t getTxQueued(txPriorityEnum priority);
+    TxStats getTxStats(txPriorityEnum priority);
+    void clearTxStats();
+    #endif
+    int availableForWrite();
+    void write(const char* buffer, size_t len);
     void print(char* message);
+    void print(const __FlashStringHelper* message);
     void print(char c);
     void print(uint8_t n);
     void print(uint16_t n);
@@ -111,6 +438,7 @@ public:
     void print(double n);
 
     void println(char* message);
+    void println(const __FlashStringHelper* message);
     void println(char c);
     void println(uint8_t n);
     void println(uint16_t n);
@@ -121,7 +449,19 @@ public:
     void println(float n);
     void println(double n);
     void println();
-private:
+    void printScaled(int32_t n, uint32_t scale);
+    void printlnScaled(int32_t n, uint32_t scale);
+    template<uint8_t Q> void printFixed(int32_t n, uint8_t decimals){
+        static_assert(Q <= 24, "printFixed() takes at most 24 fraction bits");
+        char buffer[SERIALCHECKER_NUMBER_BUFFER_LEN];
+        buffer[formatFixed(n, Q, decimals, buffer)] = '\0';
+        print(buffer);
+    }
+    template<uint8_t Q> void printlnFixed(int32_t n, uint8_t decimals){
+        printFixed<Q>(n, decimals);
+        println();
+    }
+protected: // so that SerialCheckerFraming.h can build on the same state
     uint32_t baudrate = 250000;
     serialTypes serialType;
     portType port;
@@ -133,6 +473,18 @@ private:
     bool requireSTX = false;
     bool receiveStarted = true;
     bool allowCR = false;
+    bool useSeqNum = false;
+    uint8_t seqNum = SERIALCHECKER_SEQ_NONE; // of the last message received
+    uint8_t txSeqNum = 0; // for the next message sent by sendFrame()
+    #if SERIALCHECKER_ACK_BATCHING
+    bool useAckBatching = false;
+    uint8_t ackBatchMax = 8;
+    uint32_t ackBatchMicros = 0;
+    uint8_t ackPendingCount = 0; // Acks saved up by sendAck()
+    uint8_t ackPendingBase = 0; // sequence number of bit 0 of ackPendingMask
+    uint32_t ackPendingMask = 0;
+    uint32_t ackPendingSince = 0; // micros() when the first saved up Ack was saved
+    #endif
     // bool checkConversion = false;
     uint8_t msgMinLen = 1;
     uint8_t msgMaxLen = 13;
@@ -140,13 +492,51 @@ private:
     char ETX = '\n'; 
     char Ack = 'A';//6; Acknowledge char
     char Nak = 'N';//21; Not Acknowledge char
-    uint8_t msgIndex;
-    uint8_t msgLen;
+    uint8_t msgIndex = 0;
+    uint8_t msgLen = 0;
     char* message = nullptr; // message excluding the address section, if present
     char* rawMessage = nullptr; // the full message including the address section, if present
-    uint8_t rawMsgLen;
+    uint8_t rawMsgLen = 0;
     uint8_t addressLen = 0;
     char* address = nullptr;
+    #if SERIALCHECKER_ADDRESS_FILTER
+    uint8_t* addressBits = nullptr; // bitsets of the 1 char addresses added by addAddress(), one per kind
+    char* addressTable = nullptr; // hash table of the longer addresses
+    uint8_t* addressKinds = nullptr; // the kind of each hash table entry, None if empty
+    uint8_t addressCount = 0;
+    addressKindEnum addressKind = addressKindEnum::None; // of the message being received
+    bool skipping = false; // skipping a message for another address
+    uint32_t skippedCount = 0;
+    #endif
+    frameErrorEnum lastError = frameErrorEnum::None;
+    #if SERIALCHECKER_MESSAGE_HOOK
+    messageHook hook = nullptr; // such as SerialCheckerRegisters answering get and set messages inside check()
+    void* hookContext = nullptr;
+    #endif
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    DuplicateEntry* duplicates = nullptr; // made by enableDuplicateFilter()
+    DuplicateEntry* duplicateOpen = nullptr; // the entry of the message being answered, which keeps the replies sent
+    uint32_t duplicateWindowMillis = 0;
+    uint32_t duplicateCount = 0;
+    #endif
+    #if SERIALCHECKER_REPLY_CACHE
+    CachedReply* replyCache = nullptr; // made by enableReplyCache()
+    uint32_t replyCacheHits = 0;
+    #endif
+    #if SERIALCHECKER_TX_QUEUES
+    TxQueue* txQueues = nullptr; // one per priority class, made by the first enableTxQueue()
+    uint16_t txQueued = 0; // bytes waiting in all of the queues
+    uint8_t txRoomMax = 0; // the most availableForWrite() has reported, taken as the size of the port's transmit buffer
+    #endif
+
+    #if SERIALCHECKER_RECORDER
+    uint8_t* recBuffer = nullptr; // the recorder ring buffer, owned by the user
+    uint16_t recSize = 0;
+    uint16_t recTail = 0; // the oldest entry
+    uint16_t recUsed = 0;
+    uint32_t recTailMicros = 0; // time of the oldest entry
+    uint32_t recLastMicros = 0; // time of the newest entry, rounded to whole ticks
+    #endif
 
     #ifdef USBserial_h_
     uint8_t checkUSBSerial();
@@ -154,7 +544,46 @@ private:
     #ifdef USBCON
     uint8_t checkATMEGAXXU4Serial();
     #endif
+    uint8_t checkWith(messageReader read);
+    static uint8_t readPort(SerialChecker& checker);
+    uint8_t accept();
+    #if SERIALCHECKER_DUPLICATE_FILTER
+    bool isDuplicate();
+    void keepReply(const char* reply, size_t len);
+    #endif
+    int32_t toFixedBits(uint8_t startIndex, uint8_t fracBits);
+    uint8_t firstNumberIndex();
+    static uint8_t formatUnsigned(uint32_t n, char* out);
+    static uint8_t sum8(const char* rawMessage, int len);
+    static int8_t hexDigitValue(char c);
+    void reject(frameErrorEnum reason);
+    void sendReply(char reply, uint8_t seqNum);
+    #if SERIALCHECKER_ACK_BATCHING
+    void queueAck(uint8_t seqNum);
+    #endif
+    size_t frameHeader(char* frame, uint8_t seqNum);
+    size_t buildFrame(char* message, uint8_t seqNum, char* frame);
+    #if SERIALCHECKER_TX_QUEUES
+    bool txSendOldest(TxQueue& queue, bool wait);
+    #endif
+    #if SERIALCHECKER_REPLY_CACHE
+    CachedReply& replySlot();
+    #endif
+    #if SERIALCHECKER_ADDRESS_FILTER
+    addressKindEnum lookupAddress(const char* received);
+    uint8_t addressHash(const char* address);
+    #endif
+    #if SERIALCHECKER_RECORDER
+    void record(recorderEntryEnum type, uint8_t data);
+    void recorderPut(uint8_t b);
+    void recorderDropOldest();
+    uint8_t recorderEntryLen(uint16_t index, uint32_t& ticks);
+    #endif
+    #ifdef ARDUINO
     uint8_t checkHardwareSerial();
+    #else
+    uint8_t checkPOSIXSerial();
+    #endif
     
 
 };
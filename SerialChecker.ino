@@ -7,9 +7,10 @@ void setup(){
     sc.init();
     sc1.init();
     sc.setAddressLen(1);
-    Serial.println("Connected to SerialChecker.ino");
+    Serial.println(F("Connected to SerialChecker.ino"));
     // Can now print messages via the SerialChecker class instance itself:
-    sc.println("Still connected to SerialChecker.ino...");
+    sc.println(F("Still connected to SerialChecker.ino..."));
+    // Wrapping string literals in F() keeps them in flash rather than RAM. The commands below are compared straight from flash too.
     // You can use Serial.print or the class instance method since they are the same. The advantage of using the class instance message becomes apparent when you have multiple serial comms targets.
     sc.setETX('\r');
     //sc.enableAckNak('%', '*');// Ack = '%', Nak = '*'. Nak is sent automatically if bad message received. Ack must be sent manually with sc.sendAck();. Nak can also be sent with sendNak();
@@ -21,48 +22,48 @@ void loop(){
     delay(100);
     int len = sc.check();
     if(len){
-        sc.print("Address: ");
+        sc.print(F("Address: "));
         sc.println(sc.getAddress());
         sc.print(sc.getMsgLen());
-        sc.print(", ");
+        sc.print(F(", "));
         sc.print(len);
-        sc.print(", ");
+        sc.print(F(", "));
         sc.println(sc.getMsg());
-        if(sc.contains("TEST")){
-            sc.println("contains TEST");
+        if(sc.contains(F("TEST"))){
+            sc.println(F("contains TEST"));
         }
-        else if(sc.contains("U")){
+        else if(sc.contains(F("U"))){
             uint16_t num = sc.toInt16(1);
             sc.println(num);
         }
-        else if(sc.contains("I")){
+        else if(sc.contains(F("I"))){
             int16_t num = sc.toInt16(); // don't need to specify a start index!
             sc.println(num);
         }
-        else if(sc.contains("F")){
+        else if(sc.contains(F("F"))){
             sc.println(sc.toFloat());
         }
-        else if(sc.contains("Calc")){
+        else if(sc.contains(F("Calc"))){
             sc.println(sc.calcChecksum(sc.getRawMsg()));
         }
-        else if(sc.contains("M")){
+        else if(sc.contains(F("M"))){
             sc.println(sc.getMsg());
         }
-        else if(sc.contains("R")){
+        else if(sc.contains(F("R"))){
             sc.println(sc.getRawMsg());
         }
-        else if(sc.contains("EE")){
+        else if(sc.contains(F("EE"))){
             sc.sendAck();
             sc.sendNak();
         }
-        else if(sc.contains("SC1")){
-            sc.println("Checksum turned on.");
+        else if(sc.contains(F("SC1"))){
+            sc.println(F("Checksum turned on."));
             sc.enableChecksum();
         }
-        else if(sc.contains("SC0")){ 
+        else if(sc.contains(F("SC0"))){ 
         //the checksum is calculated for the rawMessage, i.e., the address is included in the calculation. 
         // If there is no address, SC0g will turn it off. If there is a 1 char address, 1SC0: will turn it off.
-            sc.println("Checksum turned off.");
+            sc.println(F("Checksum turned off."));
             sc.disableChecksum();
         }
     }
@@ -0,0 +1,270 @@
+#include "SerialCheckerARQ.h"
+
+/**
+ * @brief      Sets up reliable delivery on a SerialChecker. enableSeqNum() is called on the checker. Acks and Naks are sent as messages holding just the Ack or Nak char, so the user's own messages must not be just those chars, or the Ack char followed by hex digits if the other end uses SerialChecker::enableAckBatching() to cut down the Ack traffic.
+ *
+ * @param      checker    The checker, set up with the port, STX, checksum etc. as usual
+ * @param[in]  window     The number of messages that can be waiting for an Ack at once, at most SERIALCHECKERARQ_MAX_WINDOW. It is rounded down to a power of two, so 5 gives 4, see getWindow(). Two buffers of window * (msgMaxLen + 1) chars are allocated.
+ * @param[in]  msgMaxLen  The longest message that will be sent or received, without the sequence number, checksum, STX or ETX chars
+ */
+SerialCheckerARQ::SerialCheckerARQ(SerialChecker& checker, uint8_t window, uint8_t msgMaxLen){
+    this->checker = &checker;
+    if(window < 1){
+        window = 1;
+    }
+    if(window > SERIALCHECKERARQ_MAX_WINDOW){
+        window = SERIALCHECKERARQ_MAX_WINDOW;
+    }
+    // Sequence numbers wrap at SERIALCHECKER_SEQ_COUNT, so any other window would put two messages in flight in the same slot.
+    while(window & (window - 1)){
+        window &= window - 1;
+    }
+    this->window = window;
+    this->msgMaxLen = msgMaxLen;
+    txBuffer = new char[window * (msgMaxLen + 1)];
+    txLen = new uint8_t[window];
+    txTime = new uint32_t[window];
+    rxBuffer = new char[window * (msgMaxLen + 1)];
+    rxLen = new uint8_t[window];
+    rxNaked = new bool[window];
+    for(uint8_t i = 0; i < window; i++){
+        txLen[i] = 0;
+        rxLen[i] = 0;
+        rxNaked[i] = false;
+    }
+    checker.enableSeqNum();
+}
+
+SerialCheckerARQ::~SerialCheckerARQ(){
+    delete [] txBuffer;
+    delete [] txLen;
+    delete [] txTime;
+    delete [] rxBuffer;
+    delete [] rxLen;
+    delete [] rxNaked;
+}
+
+/**
+ * @brief      Sets how long to wait for an Ack before sending a message again. It should be longer than the time taken to send a whole window of messages and get the replies back. The default is 100 ms.
+ *
+ * @param[in]  timeout  The timeout in ms
+ */
+void SerialCheckerARQ::setTimeout(uint16_t timeout){
+    this->timeout = timeout;
+}
+
+/**
+ * @brief      Checks whether there is room in the window for another message.
+ *
+ * @return     True if send() will accept a message.
+ */
+bool SerialCheckerARQ::canSend(){
+    return getInFlight() < window;
+}
+
+/**
+ * @brief      Sends a message and keeps a copy until it is Acked. Call check() or update() often so that Acks are read and lost messages are sent again.
+ *
+ * @param      message  The null terminated message. Longer than msgMaxLen chars and it is cut short.
+ *
+ * @return     False if the window is full or the message is empty, in which case nothing is sent.
+ */
+bool SerialCheckerARQ::send(char* message){
+    if(!canSend() || !message[0]){
+        return false;
+    }
+    uint8_t s = slot(txNext);
+    char* copy = &txBuffer[s * (msgMaxLen + 1)];
+    uint8_t len = 0;
+    while(message[len] && len < msgMaxLen){
+        copy[len] = message[len];
+        len++;
+    }
+    copy[len] = '\0';
+    txLen[s] = len;
+    transmit(txNext);
+    txNext = (txNext + 1) & (SERIALCHECKER_SEQ_COUNT - 1);
+    return true;
+}
+
+/**
+ * @brief      Gets the number of messages sent that have not been Acked yet.
+ *
+ * @return     The number of messages in flight.
+ */
+uint8_t SerialCheckerARQ::getInFlight(){
+    return (txNext - txBase) & (SERIALCHECKER_SEQ_COUNT - 1);
+}
+
+/**
+ * @brief      Gets the window in use, which is the one asked for rounded down to a power of two.
+ *
+ * @return     The number of messages that can be waiting for an Ack at once.
+ */
+uint8_t SerialCheckerARQ::getWindow(){
+    return window;
+}
+
+/**
+ * @brief      Use this in place of the checker's check(). It reads Acks and Naks for the messages sent, Acks the messages received and hands them over in the order they were sent. The message is loaded in to the checker, so getMsg(), contains(), toFloat() etc. are used on the checker as usual. It also sends messages again if their Acks are late.
+ *
+ * @return     The length of the next message, or 0 if there is none yet.
+ */
+uint8_t SerialCheckerARQ::check(){
+    update();
+    uint8_t len;
+    while(true){
+        // Messages that arrived early are handed over once the ones in front of them have been.
+        uint8_t s = slot(rxBase);
+        if(rxLen[s]){
+            len = checker->loadMsg(&rxBuffer[s * (msgMaxLen + 1)], rxLen[s]);
+            rxLen[s] = 0;
+            rxNaked[s] = false;
+            rxBase = (rxBase + 1) & (SERIALCHECKER_SEQ_COUNT - 1);
+            return len;
+        }
+        len = checker->check();
+        if(!len){
+            return 0;
+        }
+        if(checker->isAck()){
+            // A batched Ack, see SerialChecker::enableAckBatching(), can be for several messages.
+            uint32_t bitmap = checker->getAckBitmap();
+            for(uint8_t i = 0; bitmap; i++, bitmap >>= 1){
+                if(bitmap & 1){
+                    handleReply(true, (checker->getSeqNum() + i) & (SERIALCHECKER_SEQ_COUNT - 1));
+                }
+            }
+        }
+        else if(checker->isNak()){
+            handleReply(false, checker->getSeqNum());
+        }
+        else if(checker->getSeqNum() != SERIALCHECKER_SEQ_NONE){
+            len = handleMessage(len, checker->getSeqNum());
+            if(len){
+                return len;
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Sends again any message whose Ack is overdue. check() calls this, so it is only needed when sending without receiving.
+ */
+void SerialCheckerARQ::update(){
+    uint32_t now = millis();
+    for(uint8_t seqNum = txBase; seqNum != txNext; seqNum = (seqNum + 1) & (SERIALCHECKER_SEQ_COUNT - 1)){
+        uint8_t s = slot(seqNum);
+        if(txLen[s] && now - txTime[s] >= timeout){
+            transmit(seqNum);
+            retransmits++;
+        }
+    }
+}
+
+/**
+ * @brief      Gets the number of messages that have been sent again, after a Nak or a timeout.
+ *
+ * @return     The retransmit count.
+ */
+uint32_t SerialCheckerARQ::getRetransmitCount(){
+    return retransmits;
+}
+
+/**
+ * @brief      Gets the number of received messages that were thrown away because they had already been received. These are sent again when an Ack is lost.
+ *
+ * @return     The duplicate count.
+ */
+uint32_t SerialCheckerARQ::getDuplicateCount(){
+    return duplicates;
+}
+
+uint8_t SerialCheckerARQ::slot(uint8_t seqNum){
+    return seqNum & (window - 1);
+}
+
+void SerialCheckerARQ::transmit(uint8_t seqNum){
+    uint8_t s = slot(seqNum);
+    checker->sendFrame(&txBuffer[s * (msgMaxLen + 1)], seqNum);
+    txTime[s] = millis();
+}
+
+/**
+ * @brief      Deals with an Ack or Nak for a message that was sent. Acks free the message's slot and slide the window along past any Acked messages. Naks send just that message again straight away.
+ *
+ * A serial link keeps things in order, so an Ack also means that any older message sent before it, which is still not Acked, or its Ack, has been lost. Those are sent again at once rather than holding up the window until their timers run out.
+ */
+void SerialCheckerARQ::handleReply(bool ack, uint8_t seqNum){
+    if(seqNum == SERIALCHECKER_SEQ_NONE){
+        return; // a message was damaged but it is not known which, so leave it to the timers
+    }
+    uint8_t offset = (seqNum - txBase) & (SERIALCHECKER_SEQ_COUNT - 1);
+    uint8_t s = slot(seqNum);
+    if(offset >= getInFlight() || !txLen[s]){
+        return; // a late reply for a message that has already been Acked
+    }
+    if(ack){
+        txLen[s] = 0;
+        uint32_t sentTime = txTime[s];
+        for(uint8_t older = txBase; older != seqNum; older = (older + 1) & (SERIALCHECKER_SEQ_COUNT - 1)){
+            uint8_t o = slot(older);
+            if(txLen[o] && (int32_t)(sentTime - txTime[o]) > 0){
+                transmit(older);
+                retransmits++;
+            }
+        }
+        while(txBase != txNext && !txLen[slot(txBase)]){
+            txBase = (txBase + 1) & (SERIALCHECKER_SEQ_COUNT - 1);
+        }
+    }
+    else{
+        transmit(seqNum);
+        retransmits++;
+    }
+}
+
+/**
+ * @brief      Deals with a message received. It is Acked, and Naks are sent for any missing messages in front of it. If it is the next one due it is handed straight to the user, otherwise it is kept until the ones in front of it arrive.
+ *
+ * @return     The message length if it can be handed to the user now, otherwise 0.
+ */
+uint8_t SerialCheckerARQ::handleMessage(uint8_t len, uint8_t seqNum){
+    uint8_t offset = (seqNum - rxBase) & (SERIALCHECKER_SEQ_COUNT - 1);
+    if(offset >= window){
+        if(offset >= SERIALCHECKER_SEQ_COUNT - window){
+            // Already handed over, so the sender did not get the Ack.
+            checker->sendAck(seqNum);
+            duplicates++;
+        }
+        return 0;
+    }
+    uint8_t s = slot(seqNum);
+    if(offset == 0){
+        checker->sendAck(seqNum);
+        rxNaked[s] = false;
+        rxBase = (rxBase + 1) & (SERIALCHECKER_SEQ_COUNT - 1);
+        return len; // already in the checker
+    }
+    if(rxLen[s]){
+        checker->sendAck(seqNum);
+        duplicates++;
+        return 0;
+    }
+    if(len > msgMaxLen){
+        len = msgMaxLen;
+    }
+    char* copy = &rxBuffer[s * (msgMaxLen + 1)];
+    memcpy(copy, checker->getRawMsg(), len);
+    copy[len] = '\0';
+    rxLen[s] = len;
+    checker->sendAck(seqNum);
+    for(uint8_t missing = rxBase; missing != seqNum; missing = (missing + 1) & (SERIALCHECKER_SEQ_COUNT - 1)){
+        uint8_t m = slot(missing);
+        if(!rxLen[m] && !rxNaked[m]){
+            checker->sendNak(missing);
+            rxNaked[m] = true;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+#ifndef SERIALCHECKERARQ_H
+#define SERIALCHECKERARQ_H
+
+#include "SerialChecker.h"
+
+/**
+ * @brief      The biggest window SerialCheckerARQ can use. Half the sequence numbers, so that a new message can always be told apart from a repeat of an old one. Windows are rounded down to a power of two, 1, 2, 4 up to this, so that the sequence numbers in flight, which wrap at SERIALCHECKER_SEQ_COUNT, always land in different slots.
+ */
+#define SERIALCHECKERARQ_MAX_WINDOW (SERIALCHECKER_SEQ_COUNT / 2)
+
+/**
+ * @brief      Reliable delivery of messages on top of a SerialChecker with sequence numbers, for bulk transfers such as waveform tables over noisy links. Up to a window of messages can be waiting for their Acks at once. Every message received is Acked on its own, messages that arrive out of order are held back until the missing ones turn up, a Nak is sent for each gap so that only the missing message is sent again, and messages that are not Acked in time are sent again. Messages are handed to the user in the order they were sent, once each.
+ *
+ *              The same class is used on the arduino and on the PC, and both ends can send and receive at the same time. Both ends must use the same window size.
+ */
+class SerialCheckerARQ{
+public:
+    SerialCheckerARQ(SerialChecker& checker, uint8_t window, uint8_t msgMaxLen);
+    ~SerialCheckerARQ();
+    void setTimeout(uint16_t timeout);
+    bool canSend();
+    bool send(char* message);
+    uint8_t getInFlight();
+    uint8_t getWindow();
+    uint8_t check();
+    void update();
+    uint32_t getRetransmitCount();
+    uint32_t getDuplicateCount();
+private:
+    SerialChecker* checker;
+    uint8_t window; // a power of two
+    uint8_t msgMaxLen;
+    uint16_t timeout = 100; // ms
+
+    char* txBuffer = nullptr; // window slots of msgMaxLen + 1 chars, indexed by sequence number & (window - 1)
+    uint8_t* txLen = nullptr; // 0 once Acked
+    uint32_t* txTime = nullptr; // millis() when last sent
+    uint8_t txBase = 0; // oldest sequence number not yet Acked
+    uint8_t txNext = 0; // sequence number of the next message sent
+
+    char* rxBuffer = nullptr; // messages that arrived before the ones in front of them
+    uint8_t* rxLen = nullptr; // 0 if the slot is empty
+    bool* rxNaked = nullptr; // a Nak has been sent for this missing message
+    uint8_t rxBase = 0; // sequence number of the next message to hand to the user
+
+    uint32_t retransmits = 0;
+    uint32_t duplicates = 0;
+
+    uint8_t slot(uint8_t seqNum);
+    void transmit(uint8_t seqNum);
+    void handleReply(bool ack, uint8_t seqNum);
+    uint8_t handleMessage(uint8_t len, uint8_t seqNum);
+};
+
+#endif
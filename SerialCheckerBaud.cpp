@@ -0,0 +1,312 @@
+#include "SerialCheckerBaud.h"
+
+/**
+ * @brief      Sets up baudrate negotiation for a checker. The checker's current rate becomes the base rate the link watchdog goes back to.
+ *
+ * @param      checker  The checker whose port is switched
+ */
+SerialCheckerBaud::SerialCheckerBaud(SerialChecker& checker){
+    this->checker = &checker;
+    baseBaudrate = checker.getBaudrate();
+    stats.baudrate = baseBaudrate;
+    rateSince = millis();
+    lastHeard = rateSince;
+}
+
+/**
+ * @brief      Limits the rates this end accepts when the other end proposes one. By default any rate is accepted. The array is not copied, so it must stay around.
+ *
+ * @param[in]  rates  The rates
+ * @param[in]  count  The number of rates
+ */
+void SerialCheckerBaud::setRates(const uint32_t* rates, uint8_t count){
+    this->rates = rates;
+    this->rateCount = count;
+}
+
+/**
+ * @brief      Changes the char that starts negotiation messages, '~' by default. Pick one that none of the sketch's own messages start with.
+ *
+ * @param[in]  commandChar  The command char
+ */
+void SerialCheckerBaud::setCommandChar(char commandChar){
+    this->commandChar = commandChar;
+}
+
+/**
+ * @brief      Sets how long each step may take.
+ *
+ * @param[in]  answerMillis    How long the host waits for an answer to a proposal or a probe. The default is 100.
+ * @param[in]  settleMillis    How long the host waits after switching before probing, for the node to switch too. The default is 10.
+ * @param[in]  probes          How many probes the host sends before giving up. The default is 3.
+ * @param[in]  linkLostMillis  Away from the base rate, how long without a message before going back to the base rate, or 0 for never, which is the default.
+ */
+void SerialCheckerBaud::setTimeouts(uint32_t answerMillis, uint32_t settleMillis, uint8_t probes, uint32_t linkLostMillis){
+    this->answerMillis = answerMillis;
+    this->settleMillis = settleMillis;
+    this->probes = probes ? probes : 1;
+    this->linkLostMillis = linkLostMillis;
+}
+
+/**
+ * @brief      Proposes a new rate to the other end. The result comes later, see getState() and getLastResult().
+ *
+ * @param[in]  baudrate  The rate
+ *
+ * @return     False if a negotiation is already going on.
+ */
+bool SerialCheckerBaud::propose(uint32_t baudrate){
+    if(state != baudStateEnum::Idle){
+        return false;
+    }
+    isHost = true;
+    newBaudrate = baudrate;
+    oldBaudrate = checker->getBaudrate();
+    stats.proposals++;
+    send('B', baudrate);
+    state = baudStateEnum::Proposed;
+    since = millis();
+    return true;
+}
+
+/**
+ * @brief      Deals with the checker's current message if it is part of a negotiation. Every message passed in counts as hearing from the other end, for the link watchdog, and towards getBytesPerSecond().
+ *
+ * @return     True if the message was a negotiation message, false if it is one for the sketch.
+ */
+bool SerialCheckerBaud::handle(){
+    char* message = checker->getMsg();
+    lastHeard = millis();
+    stats.bytes += checker->getRawMsgLen() + 1;
+    if(message[0] != commandChar){
+        return false;
+    }
+    uint32_t baudrate = checker->toInt32(2);
+    switch(message[1]){
+        case 'B': // a proposal, so this end is the node
+            stats.proposals++;
+            if(!accepts(baudrate)){
+                stats.refused++;
+                send('R', baudrate);
+                break;
+            }
+            send('A', baudrate);
+            isHost = false;
+            oldBaudrate = checker->getBaudrate();
+            newBaudrate = baudrate;
+            switchTo(baudrate);
+            state = baudStateEnum::Probing;
+            since = millis();
+            break;
+        case 'A':
+            if(isHost && state == baudStateEnum::Proposed && baudrate == newBaudrate){
+                switchTo(baudrate);
+                probesSent = 0;
+                state = baudStateEnum::Settling;
+                since = millis();
+            }
+            break;
+        case 'R':
+            if(isHost && state == baudStateEnum::Proposed && baudrate == newBaudrate){
+                stats.refused++;
+                finish(baudResultEnum::Refused, false);
+            }
+            break;
+        case 'P':{
+            uint8_t len = strlen(&message[2]);
+            // The last char is a checksum of the rest, so a probe is checked even when the checker doesn't use checksums.
+            bool good = len >= 2 && len <= SERIALCHECKERBAUD_PROBE_LEN && message[1 + len] == SerialChecker::chksm8bitAllReadableChars(&message[2], len - 1);
+            if(!good){
+                break;
+            }
+            if(isHost){
+                if(state == baudStateEnum::Probing && strcmp(&message[2], probe) == 0){
+                    finish(baudResultEnum::Switched, false);
+                }
+            }
+            else{
+                reply(message);
+                if(state == baudStateEnum::Probing){
+                    finish(baudResultEnum::Switched, false);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return true;
+}
+
+/**
+ * @brief      Moves the negotiation on when its time is up, and runs the link watchdog. Call it every loop.
+ */
+void SerialCheckerBaud::update(){
+    uint32_t now = millis();
+    switch(state){
+        case baudStateEnum::Proposed:
+            if(now - since >= answerMillis){
+                finish(baudResultEnum::NoAnswer, false);
+            }
+            break;
+        case baudStateEnum::Settling:
+            if(now - since >= settleMillis){
+                sendProbe();
+                state = baudStateEnum::Probing;
+                since = now;
+            }
+            break;
+        case baudStateEnum::Probing:
+            if(isHost && now - since >= answerMillis){
+                if(probesSent < probes){
+                    sendProbe();
+                    since = now;
+                }
+                else{
+                    finish(baudResultEnum::ProbeFailed, true);
+                }
+            }
+            // The node gives the host time to settle and send all of its probes.
+            else if(!isHost && now - since >= settleMillis + answerMillis * (probes + 1)){
+                finish(baudResultEnum::ProbeFailed, true);
+            }
+            break;
+        default:
+            if(linkLostMillis && checker->getBaudrate() != baseBaudrate && now - lastHeard >= linkLostMillis){
+                stats.linkLost++;
+                lastResult = baudResultEnum::LinkLost;
+                switchTo(baseBaudrate);
+            }
+            break;
+    }
+}
+
+/**
+ * @brief      Goes straight back to the base rate, for example when the host has lost touch with the node. Any negotiation is dropped.
+ */
+void SerialCheckerBaud::fallBack(){
+    state = baudStateEnum::Idle;
+    switchTo(baseBaudrate);
+}
+
+/**
+ * @brief      Gets where the negotiation is up to.
+ *
+ * @return     The state, Idle once it has finished.
+ */
+baudStateEnum SerialCheckerBaud::getState(){
+    return state;
+}
+
+/**
+ * @brief      Gets how the last negotiation ended.
+ *
+ * @return     The result.
+ */
+baudResultEnum SerialCheckerBaud::getLastResult(){
+    return lastResult;
+}
+
+/**
+ * @brief      Gets the counts of negotiations, the rate in use and the message bytes handled at it.
+ *
+ * @return     The stats.
+ */
+BaudStats SerialCheckerBaud::getStats(){
+    stats.baudrate = checker->getBaudrate();
+    stats.millisAtRate = millis() - rateSince;
+    return stats;
+}
+
+/**
+ * @brief      Gets the effective throughput: the bytes of the messages passed to handle() per second since the rate was last set. Compare it with the baudrate / 10 an 8N1 line could carry.
+ *
+ * @return     Bytes per second.
+ */
+uint32_t SerialCheckerBaud::getBytesPerSecond(){
+    uint32_t elapsed = millis() - rateSince;
+    return elapsed ? (uint64_t)stats.bytes * 1000 / elapsed : 0;
+}
+
+/**
+ * @brief      Checks a proposed rate against setRates().
+ */
+bool SerialCheckerBaud::accepts(uint32_t baudrate){
+    if(!rates){
+        return baudrate > 0;
+    }
+    for(uint8_t i = 0; i < rateCount; i++){
+        if(rates[i] == baudrate){
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief      Sends ~B, ~A or ~R with a rate.
+ */
+void SerialCheckerBaud::send(char type, uint32_t baudrate){
+    char body[SERIALCHECKER_NUMBER_BUFFER_LEN + 2];
+    body[0] = commandChar;
+    body[1] = type;
+    body[2 + SerialChecker::formatScaled(baudrate, 1, &body[2])] = '\0';
+    reply(body);
+}
+
+/**
+ * @brief      Sends a probe. Its chars change every bit from one to the next, to show up a rate that is not quite right, and it ends with its own checksum.
+ */
+void SerialCheckerBaud::sendProbe(){
+    static const char pattern[] = "U5jZU5jZ";
+    uint8_t len = 0;
+    probe[len++] = '0' + probesSent % 10;
+    for(uint8_t i = 0; pattern[i] && len < SERIALCHECKERBAUD_PROBE_LEN - 1; i++){
+        probe[len++] = pattern[i];
+    }
+    probe[len] = SerialChecker::chksm8bitAllReadableChars(probe, len);
+    probe[len + 1] = '\0';
+    probesSent++;
+    char body[SERIALCHECKERBAUD_PROBE_LEN + 3];
+    body[0] = commandChar;
+    body[1] = 'P';
+    strcpy(&body[2], probe);
+    reply(body);
+}
+
+/**
+ * @brief      Sends a negotiation message, with the address of the message being answered in front if addresses are used.
+ */
+void SerialCheckerBaud::reply(const char* body){
+    char frame[SERIALCHECKER_FRAME_BUFFER_LEN];
+    uint8_t addressLen = isHost ? 0 : checker->getAddressLen();
+    memcpy(frame, checker->getRawMsg(), addressLen);
+    strncpy(&frame[addressLen], body, sizeof(frame) - addressLen - 1);
+    frame[sizeof(frame) - 1] = '\0';
+    checker->sendFrame(frame);
+}
+
+/**
+ * @brief      Changes the port's rate and starts the throughput count again.
+ */
+void SerialCheckerBaud::switchTo(uint32_t baudrate){
+    checker->setBaudrate(baudrate);
+    rateSince = millis();
+    lastHeard = rateSince;
+    stats.bytes = 0;
+}
+
+/**
+ * @brief      Ends the negotiation, going back to the old rate if asked.
+ */
+void SerialCheckerBaud::finish(baudResultEnum result, bool revert){
+    state = baudStateEnum::Idle;
+    lastResult = result;
+    if(result == baudResultEnum::Switched){
+        stats.switched++;
+    }
+    if(revert){
+        stats.fallbacks++;
+        switchTo(oldBaudrate);
+    }
+}
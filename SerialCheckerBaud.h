@@ -0,0 +1,102 @@
+#ifndef SERIALCHECKERBAUD_H
+#define SERIALCHECKERBAUD_H
+
+#include "SerialChecker.h"
+
+/**
+ * @brief      Longest probe sent to check a new rate, see SerialCheckerBaud.
+ */
+#define SERIALCHECKERBAUD_PROBE_LEN 16
+
+/**
+ * @brief      Where a baudrate negotiation is up to.
+ *              Idle: nothing going on.
+ *              Proposed: the host has proposed a rate and is waiting for the answer.
+ *              Settling: both ends have switched and the host is giving the other end time to do so before probing.
+ *              Probing: the host is waiting for a probe to be echoed, or the node is waiting for a probe.
+ */
+enum class baudStateEnum{ Idle, Proposed, Settling, Probing };
+
+/**
+ * @brief      How the last negotiation ended. LinkLost means the link watchdog went back to the base rate.
+ */
+enum class baudResultEnum{ None, Switched, Refused, NoAnswer, ProbeFailed, LinkLost };
+
+/**
+ * @brief      Counts kept by SerialCheckerBaud, see getStats().
+ */
+struct BaudStats{
+    uint32_t baudrate; // the rate in use
+    uint16_t proposals; // made or received
+    uint16_t switched;
+    uint16_t refused;
+    uint16_t fallbacks; // back to the old rate after a failed probe
+    uint16_t linkLost; // back to the base rate after nothing was heard for too long
+    uint32_t bytes; // of the messages handled at this rate
+    uint32_t millisAtRate; // since this rate was set
+};
+
+/**
+ * @brief      Agrees a new baudrate with the other end of a point to point link and goes back to the old one if it doesn't work. One end, the host, calls propose(). The exchange is:
+ *
+ *              host: ~B1000000     proposes 1 Mbaud at the current rate
+ *              node: ~A1000000     accepts, or ~R1000000 to refuse, then both switch
+ *              host: ~P...         after a short settling time, a probe with its own checksum at the new rate
+ *              node: ~P...         the probe echoed back, after which both keep the new rate
+ *
+ *              If the probe or its echo doesn't arrive, the host probes again, then both ends go back to the rate they had before. The node does the same if no good probe arrives in time. Both ends use the same class: pass every message from check() to handle() and call update() every loop for the timeouts.
+ *
+ *              There is one case the handshake can't settle: the node receives a probe but its echo is lost every time. The node then keeps the new rate while the host goes back. To cover this, setTimeouts() can turn on a link watchdog. Away from the base rate, it goes back to the base rate if no message has been handled for a while. The base rate is the one the checker had when this object was constructed.
+ *
+ *              SerialCheckerBaud baud(sc);
+ *              ...
+ *              if(sc.check() && !baud.handle()){
+ *                  // the sketch's own messages
+ *              }
+ *              baud.update();
+ */
+class SerialCheckerBaud{
+public:
+    SerialCheckerBaud(SerialChecker& checker);
+    void setRates(const uint32_t* rates, uint8_t count);
+    void setCommandChar(char commandChar);
+    void setTimeouts(uint32_t answerMillis, uint32_t settleMillis, uint8_t probes, uint32_t linkLostMillis);
+    bool propose(uint32_t baudrate);
+    bool handle();
+    void update();
+    void fallBack();
+    baudStateEnum getState();
+    baudResultEnum getLastResult();
+    BaudStats getStats();
+    uint32_t getBytesPerSecond();
+private:
+    SerialChecker* checker;
+    const uint32_t* rates = nullptr; // the rates this end accepts, any if nullptr
+    uint8_t rateCount = 0;
+    char commandChar = '~';
+    uint32_t answerMillis = 100;
+    uint32_t settleMillis = 10;
+    uint8_t probes = 3;
+    uint32_t linkLostMillis = 0;
+    uint32_t baseBaudrate;
+    uint32_t oldBaudrate = 0; // to go back to if the new rate fails
+    uint32_t newBaudrate = 0;
+    baudStateEnum state = baudStateEnum::Idle;
+    baudResultEnum lastResult = baudResultEnum::None;
+    bool isHost = false; // for the negotiation in progress
+    uint8_t probesSent = 0;
+    uint32_t since = 0; // millis() when the current state started
+    uint32_t lastHeard = 0;
+    uint32_t rateSince = 0;
+    BaudStats stats = {};
+    char probe[SERIALCHECKERBAUD_PROBE_LEN + 1];
+
+    bool accepts(uint32_t baudrate);
+    void send(char type, uint32_t baudrate);
+    void sendProbe();
+    void reply(const char* body);
+    void switchTo(uint32_t baudrate);
+    void finish(baudResultEnum result, bool revert);
+};
+
+#endif
@@ -0,0 +1,247 @@
+#include "SerialCheckerDelta.h"
+
+// The chars used for values and frame counts are '0' to 'o'. 5 bits of value and a flag for more chars to come.
+#define SERIALCHECKERDELTA_FIRST_CHAR '0'
+#define SERIALCHECKERDELTA_MORE 32
+#define SERIALCHECKERDELTA_COUNT_MODULUS 64
+
+/**
+ * @brief      Writes a value as a zigzag varint.
+ *
+ * @return     The number of chars written.
+ */
+static uint8_t putVarint(int32_t value, char* out){
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    uint8_t len = 0;
+    while(zigzag >= SERIALCHECKERDELTA_MORE){
+        out[len++] = SERIALCHECKERDELTA_FIRST_CHAR + SERIALCHECKERDELTA_MORE + (zigzag & 31);
+        zigzag >>= 5;
+    }
+    out[len++] = SERIALCHECKERDELTA_FIRST_CHAR + zigzag;
+    return len;
+}
+
+/**
+ * @brief      Reads a zigzag varint.
+ *
+ * @param      in     Where to read from, moved on past the value
+ * @param      value  The value
+ *
+ * @return     False if the chars run out or aren't value chars.
+ */
+static bool getVarint(const char*& in, int32_t& value){
+    uint32_t zigzag = 0;
+    for(uint8_t shift = 0; shift < 35; shift += 5){
+        uint8_t c = *in - SERIALCHECKERDELTA_FIRST_CHAR;
+        if(*in < SERIALCHECKERDELTA_FIRST_CHAR || c >= 2 * SERIALCHECKERDELTA_MORE){
+            return false;
+        }
+        in++;
+        zigzag |= (uint32_t)(c & 31) << shift;
+        if(!(c & SERIALCHECKERDELTA_MORE)){
+            value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief      Sets up an encoder. The first frame sent is a keyframe.
+ *
+ * @param[in]  channels          The number of readings in each frame
+ * @param[in]  keyframeInterval  Frames from one keyframe to the next, 1 for every frame to be a keyframe
+ */
+SerialCheckerDeltaEncoder::SerialCheckerDeltaEncoder(uint8_t channels, uint8_t keyframeInterval){
+    this->channels = channels;
+    this->keyframeInterval = keyframeInterval ? keyframeInterval : 1;
+    previous = new int32_t[channels];
+    buffer = new char[SERIALCHECKERDELTA_MAX_LEN(channels) + 1];
+}
+
+SerialCheckerDeltaEncoder::~SerialCheckerDeltaEncoder(){
+    delete [] previous;
+    delete [] buffer;
+}
+
+/**
+ * @brief      Changes the chars that start keyframes and delta frames, 'K' and 'D' by default. Pick chars that none of the sketch's own messages start with. Both ends must use the same ones.
+ *
+ * @param[in]  keyframeMarker  The keyframe marker
+ * @param[in]  deltaMarker     The delta frame marker
+ */
+void SerialCheckerDeltaEncoder::setMarkers(char keyframeMarker, char deltaMarker){
+    this->keyframeMarker = keyframeMarker;
+    this->deltaMarker = deltaMarker;
+}
+
+/**
+ * @brief      Makes the next frame a keyframe, for example when the receiver asks for one after losing its place.
+ */
+void SerialCheckerDeltaEncoder::requestKeyframe(){
+    keyframeDue = true;
+}
+
+/**
+ * @brief      Encodes a set of readings into a message.
+ *
+ * @param[in]  values  One reading per channel
+ * @param      out     Where to write the message, at least SERIALCHECKERDELTA_MAX_LEN(channels) + 1 chars
+ *
+ * @return     The length of the message, which is null terminated.
+ */
+uint8_t SerialCheckerDeltaEncoder::encode(const int32_t* values, char* out){
+    bool keyframe = keyframeDue || sinceKeyframe >= keyframeInterval;
+    uint8_t len = 0;
+    out[len++] = keyframe ? keyframeMarker : deltaMarker;
+    out[len++] = SERIALCHECKERDELTA_FIRST_CHAR + frameCount;
+    frameCount = (frameCount + 1) % SERIALCHECKERDELTA_COUNT_MODULUS;
+    for(uint8_t i = 0; i < channels; i++){
+        // Worked out unsigned so that a change too big for an int32_t wraps the same way on both ends.
+        int32_t change = keyframe ? values[i] : (int32_t)((uint32_t)values[i] - (uint32_t)previous[i]);
+        len += putVarint(change, &out[len]);
+        previous[i] = values[i];
+    }
+    out[len] = '\0';
+    if(keyframe){
+        keyframeDue = false;
+        sinceKeyframe = 0;
+    }
+    sinceKeyframe++;
+    return len;
+}
+
+/**
+ * @brief      Encodes a set of readings and sends them with the checker's sendFrame().
+ *
+ * @param      checker  The checker to send with
+ * @param[in]  values   One reading per channel
+ *
+ * @return     The sequence number sendFrame() used.
+ */
+uint8_t SerialCheckerDeltaEncoder::send(SerialChecker& checker, const int32_t* values){
+    encode(values, buffer);
+    return checker.sendFrame(buffer);
+}
+
+/**
+ * @brief      Sets up a decoder. Nothing is decoded until the first keyframe arrives.
+ *
+ * @param[in]  channels  The number of readings in each frame, the same as the encoder's
+ */
+SerialCheckerDeltaDecoder::SerialCheckerDeltaDecoder(uint8_t channels){
+    this->channels = channels;
+    previous = new int32_t[channels];
+}
+
+SerialCheckerDeltaDecoder::~SerialCheckerDeltaDecoder(){
+    delete [] previous;
+}
+
+/**
+ * @brief      Changes the chars that start keyframes and delta frames, see SerialCheckerDeltaEncoder::setMarkers().
+ *
+ * @param[in]  keyframeMarker  The keyframe marker
+ * @param[in]  deltaMarker     The delta frame marker
+ */
+void SerialCheckerDeltaDecoder::setMarkers(char keyframeMarker, char deltaMarker){
+    this->keyframeMarker = keyframeMarker;
+    this->deltaMarker = deltaMarker;
+}
+
+/**
+ * @brief      Checks whether a message starts with one of the markers.
+ *
+ * @param[in]  message  The message
+ *
+ * @return     True if it is a keyframe or delta frame.
+ */
+bool SerialCheckerDeltaDecoder::isTelemetry(const char* message){
+    return message[0] == keyframeMarker || message[0] == deltaMarker;
+}
+
+/**
+ * @brief      Decodes a message from the encoder.
+ *
+ * @param[in]  message  The message
+ * @param      values   Set to the readings, one per channel, if the message could be used
+ *
+ * @return     True if values has been set. False if the message isn't a frame, is damaged, or is a delta frame while out of step, in which case wait for the next keyframe.
+ */
+bool SerialCheckerDeltaDecoder::decode(const char* message, int32_t* values){
+    bool keyframe = message[0] == keyframeMarker;
+    if(!keyframe && message[0] != deltaMarker){
+        return false;
+    }
+    uint8_t count = message[1] - SERIALCHECKERDELTA_FIRST_CHAR;
+    if(message[1] < SERIALCHECKERDELTA_FIRST_CHAR || count >= SERIALCHECKERDELTA_COUNT_MODULUS){
+        synced = false;
+        return false;
+    }
+    if(started && count != expectedCount){
+        lost += (count - expectedCount) % SERIALCHECKERDELTA_COUNT_MODULUS;
+        synced = false;
+    }
+    started = true;
+    expectedCount = (count + 1) % SERIALCHECKERDELTA_COUNT_MODULUS;
+    if(!keyframe && !synced){
+        return false;
+    }
+    // Decoded into values first so that a damaged message leaves previous as it was.
+    const char* in = &message[2];
+    for(uint8_t i = 0; i < channels; i++){
+        int32_t change;
+        if(!getVarint(in, change)){
+            synced = false;
+            return false;
+        }
+        values[i] = keyframe ? change : (int32_t)((uint32_t)previous[i] + (uint32_t)change);
+    }
+    if(*in){
+        synced = false;
+        return false;
+    }
+    memcpy(previous, values, channels * sizeof(int32_t));
+    synced = true;
+    frames++;
+    return true;
+}
+
+/**
+ * @brief      Decodes the checker's current message, see decode().
+ *
+ * @param      checker  The checker that received the message
+ * @param      values   Set to the readings, one per channel, if the message could be used
+ *
+ * @return     True if values has been set.
+ */
+bool SerialCheckerDeltaDecoder::receive(SerialChecker& checker, int32_t* values){
+    return decode(checker.getMsg(), values);
+}
+
+/**
+ * @brief      Says whether delta frames can be decoded, that is a keyframe has arrived and no frame has been lost since.
+ *
+ * @return     True if in step with the encoder.
+ */
+bool SerialCheckerDeltaDecoder::isSynced(){
+    return synced;
+}
+
+/**
+ * @brief      Gets the number of frames decoded.
+ *
+ * @return     The number of frames.
+ */
+uint32_t SerialCheckerDeltaDecoder::getFrameCount(){
+    return frames;
+}
+
+/**
+ * @brief      Gets the number of frames lost, worked out from the gaps in the frame counts. A run of 64 or more lost frames can't be told from a shorter one.
+ *
+ * @return     The number of lost frames.
+ */
+uint32_t SerialCheckerDeltaDecoder::getLostCount(){
+    return lost;
+}
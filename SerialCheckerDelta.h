@@ -0,0 +1,78 @@
+#ifndef SERIALCHECKERDELTA_H
+#define SERIALCHECKERDELTA_H
+
+#include "SerialChecker.h"
+
+/**
+ * @brief      Longest encoded value: 32 bits at 5 bits a char.
+ */
+#define SERIALCHECKERDELTA_VALUE_LEN 7
+
+/**
+ * @brief      Longest message for a number of channels: the marker, the frame count and the values.
+ */
+#define SERIALCHECKERDELTA_MAX_LEN(channels) (2 + SERIALCHECKERDELTA_VALUE_LEN * (channels))
+
+/**
+ * @brief      Sends a set of readings, one int32_t per channel, as the change from the last set. Most readings, such as temperatures in hundredths of a degree, change by a few counts from one sample to the next, so most channels take one char rather than a whole number and a comma.
+ *
+ *              Each change is zigzag encoded, so small negative changes are small too, then sent 5 bits a char, lowest bits first. The chars are '0' (0x30) to 'o' (0x6F), with 32 added while more chars follow. They never clash with the STX or ETX chars or commas. A message starts with a marker char, 'D' for a delta frame or 'K' for a keyframe that holds the whole values, and then a frame count char from the same set so the receiver can tell when a frame is lost. A keyframe goes out every keyframeInterval frames, or straight away after requestKeyframe(), which lets a receiver that has lost its place get going again.
+ *
+ *              SerialCheckerDeltaEncoder telemetry(4, 50);
+ *              ...
+ *              int32_t readings[4] = { temperature, pressure, flow, level }; // scaled integers, see SerialChecker::toScaled()
+ *              telemetry.send(sc, readings);
+ */
+class SerialCheckerDeltaEncoder{
+public:
+    SerialCheckerDeltaEncoder(uint8_t channels, uint8_t keyframeInterval);
+    ~SerialCheckerDeltaEncoder();
+    void setMarkers(char keyframeMarker, char deltaMarker);
+    void requestKeyframe();
+    uint8_t encode(const int32_t* values, char* out);
+    uint8_t send(SerialChecker& checker, const int32_t* values);
+private:
+    uint8_t channels;
+    uint8_t keyframeInterval;
+    uint8_t sinceKeyframe = 0;
+    bool keyframeDue = true;
+    uint8_t frameCount = 0;
+    char keyframeMarker = 'K';
+    char deltaMarker = 'D';
+    int32_t* previous;
+    char* buffer; // for send()
+};
+
+/**
+ * @brief      Turns the messages from SerialCheckerDeltaEncoder back into readings. Delta frames are only used once a keyframe has been received and while no frame has been lost. After a lost or damaged frame, decode() returns false until the next keyframe.
+ *
+ *              SerialCheckerDeltaDecoder telemetry(4);
+ *              ...
+ *              if(sc.check() && telemetry.receive(sc, readings)){
+ *                  // readings holds the latest values
+ *              }
+ */
+class SerialCheckerDeltaDecoder{
+public:
+    SerialCheckerDeltaDecoder(uint8_t channels);
+    ~SerialCheckerDeltaDecoder();
+    void setMarkers(char keyframeMarker, char deltaMarker);
+    bool isTelemetry(const char* message);
+    bool decode(const char* message, int32_t* values);
+    bool receive(SerialChecker& checker, int32_t* values);
+    bool isSynced();
+    uint32_t getFrameCount();
+    uint32_t getLostCount();
+private:
+    uint8_t channels;
+    char keyframeMarker = 'K';
+    char deltaMarker = 'D';
+    bool synced = false;
+    bool started = false; // a frame count has been seen, so gaps can be counted
+    uint8_t expectedCount = 0;
+    uint32_t frames = 0;
+    uint32_t lost = 0;
+    int32_t* previous;
+};
+
+#endif
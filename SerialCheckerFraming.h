@@ -0,0 +1,229 @@
+#ifndef SERIALCHECKERFRAMING_H
+#define SERIALCHECKERFRAMING_H
+
+#include "SerialChecker.h"
+
+/**
+ * @brief      Policies for Framing, chosen when the sketch is compiled rather than with enableSTX(), enableChecksum() and so on. Each one only holds constants, so the compiler drops the branches and checksum algorithms that are not used.
+ */
+namespace STX{
+    struct None{ static const bool used = false; static const bool required = false; };
+    struct Optional{ static const bool used = true; static const bool required = false; }; // as enableSTX(false)
+    struct Required{ static const bool used = true; static const bool required = true; }; // as enableSTX(true)
+}
+
+namespace Checksum{
+    struct None{ static const bool used = false; static const checksumTypeEnum type = checksumTypeEnum::Readable8bitChars; };
+    struct SpellmanMPS{ static const bool used = true; static const checksumTypeEnum type = checksumTypeEnum::SpellmanMPS; };
+    struct Readable8bit{ static const bool used = true; static const checksumTypeEnum type = checksumTypeEnum::Readable8bitChars; };
+}
+
+namespace AckNak{
+    struct Off{ static const bool used = false; };
+    struct On{ static const bool used = true; }; // a Nak is sent for every bad message, as enableAckNak()
+}
+
+namespace CR{
+    struct Dropped{ static const bool kept = false; };
+    struct Kept{ static const bool kept = true; }; // as setAllowCR(true)
+}
+
+/**
+ * @brief      Helpers for Framing's constructor. The arduino toolchain has no <type_traits>, so the little that is needed is here.
+ */
+namespace FramingDetail{
+    template<bool condition, class T = void> struct enableIf{};
+    template<class T> struct enableIf<true, T>{ typedef T type; };
+    template<class T> struct removeReference{ typedef T type; };
+    template<class T> struct removeReference<T&>{ typedef T type; };
+    template<class T> struct removeReference<T&&>{ typedef T type; };
+    char checkerTest(const volatile SerialChecker*);
+    long checkerTest(const volatile void*);
+    // True for SerialChecker and everything derived from it, such as another Framing.
+    template<class T> struct isChecker{ static const bool value = sizeof(checkerTest((typename removeReference<T>::type*)0)) == sizeof(char); };
+}
+
+/**
+ * @brief      A SerialChecker whose STX, checksum and CR handling are fixed when the sketch is compiled, for builds that never change them. For example:
+ *
+ *              Framing<STX::Required, Checksum::Readable8bit, AckNak::On> sc(Serial);
+ *
+ *              It is constructed the same way as SerialChecker and everything else, such as getMsg(), contains(), the number conversions, sendFrame() and sendAck(), works as usual. Only check() and checkChar() are replaced: they test no runtime flags, the checksum is added up as the chars arrive rather than in a second pass over the message, and only the chosen checksum algorithm is compiled in. check() still does everything around each message that SerialChecker's does, so the message hook (and with it SerialCheckerRegisters), the transmit queues, Ack batching, sequence numbers and the duplicate filter all work. See host/bench_framing.cpp for how much that saves.
+ *
+ *              check() and checkChar() are not virtual, so that SerialChecker needs no virtual function table. Through a SerialChecker reference or pointer they are SerialChecker's own. Those accept the same messages, as the constructor sets SerialChecker's settings to match, but without the speed up. So call check() on the Framing itself.
+ *
+ *              The STX and ETX chars and the message length limits can still be set at run time. AckNak sets enableAckNak() at construction, and Naks then follow that setting. Calling enableSTX(), enableChecksum() or setAllowCR() on a Framing has no effect on its checkChar(). Address filters are applied once the whole message has arrived, rather than skipping the rest of a message as soon as its address is known. The recorder logs the accepted and rejected messages but not each char.
+ */
+template<class STXPolicy, class ChecksumPolicy, class AckNakPolicy, class CRPolicy = CR::Dropped>
+class Framing : public SerialChecker{
+public:
+    // Copying goes to the copy constructor rather than through here.
+    template<typename First, typename... Rest, typename = typename FramingDetail::enableIf<!FramingDetail::isChecker<First>::value>::type>
+    Framing(First&& first, Rest&&... rest) : SerialChecker(first, rest...){
+        // The base class settings are made to match so that sendFrame(), calcChecksum() and friends agree with checkChar().
+        if(STXPolicy::used){
+            enableSTX(STXPolicy::required);
+        }
+        if(ChecksumPolicy::used){
+            enableChecksum();
+            setChecksumType(ChecksumPolicy::type);
+        }
+        if(AckNakPolicy::used){
+            enableAckNak();
+        }
+        setAllowCR(CRPolicy::kept);
+    }
+
+    /**
+     * @brief      Same as SerialChecker::check() with the framing fixed by the policies.
+     *
+     * @return     The length of the message, or 0 if no complete, valid message has been received.
+     */
+    uint8_t check(){
+        return checkWith(readPort);
+    }
+
+    /**
+     * @brief      Same as SerialChecker::checkChar() with the framing fixed by the policies.
+     *
+     * @param[in]  in    The received char
+     *
+     * @return     The length of the message once a complete, valid message has arrived, otherwise 0.
+     */
+    uint8_t checkChar(char in){
+        if(STXPolicy::required && !receiveStarted){
+            if(in == STX){
+                receiveStarted = true;
+            }
+            else if(in == '\n'){
+                fail(frameErrorEnum::MissingSTX);
+            }
+            return 0;
+        }
+        if(STXPolicy::used && in == STX){
+            msgIndex = 0;
+            sum = 0;
+            return 0;
+        }
+        if(in == ETX){
+            return endOfMessage();
+        }
+        if(!CRPolicy::kept && in == '\r'){
+            return 0;
+        }
+        if(msgIndex < msgMaxLen){
+            rawMessage[msgIndex++] = in;
+            if(ChecksumPolicy::used){
+                sum += in;
+            }
+            return 0;
+        }
+        msgIndex = 0;
+        sum = 0;
+        fail(frameErrorEnum::TooLong);
+        return 0;
+    }
+private:
+    uint8_t sum = 0; // of the chars received so far, including what may turn out to be the checksum char
+
+    /**
+     * @brief      The messageReader for check(), as SerialChecker::readPort() but feeding this checkChar().
+     */
+    static uint8_t readPort(SerialChecker& checker){
+        Framing& framing = static_cast<Framing&>(checker);
+        switch (framing.serialType) {
+        #ifdef USBserial_h_
+            case serialTypes::USB:
+                while(framing.port.usb->available()){
+                    uint8_t len = framing.checkChar(framing.port.usb->read());
+                    if(len){
+                        return len;
+                    }
+                }
+                break;
+        #endif
+        #ifdef USBCON
+            case serialTypes::ATMEGAXXU4:
+                while(framing.port.atmegaXXu4->available()){
+                    uint8_t len = framing.checkChar(framing.port.atmegaXXu4->read());
+                    if(len){
+                        return len;
+                    }
+                }
+                break;
+        #endif
+        #ifdef ARDUINO
+            case serialTypes::HardWare:
+                while(framing.port.hardware->available()){
+                    uint8_t len = framing.checkChar(framing.port.hardware->read());
+                    if(len){
+                        return len;
+                    }
+                }
+                break;
+        #else
+            case serialTypes::POSIX:
+                while(framing.port.posix->available()){
+                    uint8_t len = framing.checkChar(framing.port.posix->read());
+                    if(len){
+                        return len;
+                    }
+                }
+                break;
+        #endif
+            case serialTypes::NoPort:
+            default:
+                break;
+        }
+        return 0;
+    }
+
+    uint8_t endOfMessage(){
+        uint8_t len = msgIndex;
+        uint8_t messageSum = sum;
+        msgIndex = 0;
+        sum = 0;
+        rawMessage[len] = '\0';
+        #if SERIALCHECKER_ADDRESS_FILTER
+        addressKind = addressKindEnum::None;
+        uint8_t addressStart = useSeqNum ? 2 : 0;
+        if(addressCount && len >= addressStart + addressLen){
+            addressKind = lookupAddress(&rawMessage[addressStart]);
+            if(addressKind == addressKindEnum::None){
+                // For another address, so dropped without a checksum test or a Nak, as SerialChecker does.
+                skippedCount++;
+                if(STXPolicy::required){
+                    receiveStarted = false;
+                }
+                return 0;
+            }
+        }
+        #endif
+        if(len < msgMinLen){
+            reject(frameErrorEnum::TooShort);
+            return 0;
+        }
+        if(ChecksumPolicy::used){
+            len--;
+            char msgChecksum = rawMessage[len];
+            rawMessage[len] = '\0';
+            messageSum -= msgChecksum;
+            char checksum = ChecksumPolicy::type == checksumTypeEnum::SpellmanMPS ? spellmanMPSFromSum(messageSum) : readable8bitCharsFromSum(messageSum);
+            if(msgChecksum != checksum){
+                reject(frameErrorEnum::BadChecksum);
+                return 0;
+            }
+        }
+        rawMsgLen = len;
+        return accept();
+    }
+
+    void fail(frameErrorEnum reason){
+        #if SERIALCHECKER_ADDRESS_FILTER
+        addressKind = addressKindEnum::None; // endOfMessage() finds the kind, so it is still the last message's
+        #endif
+        reject(reason);
+    }
+};
+
+#endif
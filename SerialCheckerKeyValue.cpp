@@ -0,0 +1,333 @@
+#include "SerialCheckerKeyValue.h"
+
+/**
+ * @brief      Sets up a key=value parser for the messages received by a checker.
+ *
+ * @param      checker  The checker whose message buffer is parsed
+ * @param[in]  maxKeys  The most keys that can be added
+ */
+SerialCheckerKeyValue::SerialCheckerKeyValue(SerialChecker& checker, uint8_t maxKeys){
+    this->checker = &checker;
+    this->maxKeys = maxKeys;
+    entries = new Entry[maxKeys];
+    byHash = new uint8_t[maxKeys];
+    unknownKey[0] = '\0';
+}
+
+SerialCheckerKeyValue::~SerialCheckerKeyValue(){
+    delete [] entries;
+    delete [] byHash;
+}
+
+/**
+ * @brief      Binds a key to a float variable. The key is not copied, so it must stay around, as a string literal does.
+ *
+ * @param[in]  key       The key, such as "T"
+ * @param      variable  The variable set by parse()
+ * @param[in]  min       The smallest value accepted
+ * @param[in]  max       The largest value accepted
+ *
+ * @return     False if maxKeys keys have already been added or the key has been added before.
+ */
+bool SerialCheckerKeyValue::add(const char* key, float* variable, float min, float max){
+    if(!addEntry(key, keyValueTypeEnum::Float, variable)){
+        return false;
+    }
+    Entry* entry = find(key, strlen(key), 0); // a hash of 0 makes find() work it out
+    entry->min.f = min;
+    entry->max.f = max;
+    return true;
+}
+
+/**
+ * @brief      Binds a key to an int32_t variable.
+ *
+ * @param[in]  key       The key
+ * @param      variable  The variable set by parse()
+ * @param[in]  min       The smallest value accepted
+ * @param[in]  max       The largest value accepted
+ *
+ * @return     False if maxKeys keys have already been added or the key has been added before.
+ */
+bool SerialCheckerKeyValue::add(const char* key, int32_t* variable, int32_t min, int32_t max){
+    if(!addEntry(key, keyValueTypeEnum::Int32, variable)){
+        return false;
+    }
+    Entry* entry = find(key, strlen(key), 0);
+    entry->min.i = min;
+    entry->max.i = max;
+    return true;
+}
+
+/**
+ * @brief      Binds a key to an int16_t variable.
+ *
+ * @param[in]  key       The key
+ * @param      variable  The variable set by parse()
+ * @param[in]  min       The smallest value accepted
+ * @param[in]  max       The largest value accepted
+ *
+ * @return     False if maxKeys keys have already been added or the key has been added before.
+ */
+bool SerialCheckerKeyValue::add(const char* key, int16_t* variable, int16_t min, int16_t max){
+    if(!addEntry(key, keyValueTypeEnum::Int16, variable)){
+        return false;
+    }
+    Entry* entry = find(key, strlen(key), 0);
+    entry->min.i = min;
+    entry->max.i = max;
+    return true;
+}
+
+/**
+ * @brief      Stops parse() from changing a key's variable. Values sent for it are counted as rejected.
+ *
+ * @param[in]  key   The key
+ *
+ * @return     False if the key has not been added.
+ */
+bool SerialCheckerKeyValue::setReadOnly(const char* key){
+    Entry* entry = find(key, strlen(key), 0);
+    if(!entry){
+        return false;
+    }
+    entry->readOnly = true;
+    return true;
+}
+
+/**
+ * @brief      Gets the number of keys added.
+ *
+ * @return     The number of keys.
+ */
+uint8_t SerialCheckerKeyValue::getKeyCount(){
+    return keyCount;
+}
+
+/**
+ * @brief      Parses the whole message, see parse(uint8_t startIndex).
+ *
+ * @return     The number of variables set.
+ */
+uint8_t SerialCheckerKeyValue::parse(){
+    return parse(0);
+}
+
+/**
+ * @brief      Parses comma separated key=value pairs in the checker's message, from startIndex to the end, and sets the variables of the keys found. Each value is converted with the checker's own toFloat() or toInt32().
+ *
+ * @param[in]  startIndex  Where the first key starts in the message, for example 1 to skip a command char
+ *
+ * @return     The number of variables set.
+ */
+uint8_t SerialCheckerKeyValue::parse(uint8_t startIndex){
+    char* message = checker->getMsg();
+    uint8_t stored = 0;
+    unknownCount = 0;
+    rejectedCount = 0;
+    unknownKey[0] = '\0';
+    uint8_t i = startIndex;
+    while(message[i]){
+        uint8_t keyStart = i;
+        uint16_t hash = 0;
+        while(message[i] && message[i] != '=' && message[i] != ','){
+            hash = hashStep(hash, message[i]);
+            i++;
+        }
+        uint8_t keyLen = i - keyStart;
+        Entry* entry = nullptr;
+        if(message[i] == '='){
+            entry = find(&message[keyStart], keyLen, hash);
+            i++;
+        }
+        if(!entry){
+            if(unknownCount++ == 0){
+                uint8_t len = keyLen < SERIALCHECKERKEYVALUE_KEY_LEN ? keyLen : SERIALCHECKERKEYVALUE_KEY_LEN;
+                memcpy(unknownKey, &message[keyStart], len);
+                unknownKey[len] = '\0';
+            }
+        }
+        else if(store(entry, i)){
+            stored++;
+        }
+        else{
+            rejectedCount++;
+        }
+        while(message[i] && message[i] != ','){
+            i++;
+        }
+        if(message[i] == ','){
+            i++;
+        }
+    }
+    return stored;
+}
+
+/**
+ * @brief      Gets the number of keys in the last message parsed that had not been added, or had no '='.
+ *
+ * @return     The number of unknown keys.
+ */
+uint8_t SerialCheckerKeyValue::getUnknownCount(){
+    return unknownCount;
+}
+
+/**
+ * @brief      Gets the first unknown key in the last message parsed, for example to send back in an error message.
+ *
+ * @return     The key, or an empty string if there were none.
+ */
+char* SerialCheckerKeyValue::getUnknownKey(){
+    return unknownKey;
+}
+
+/**
+ * @brief      Gets the number of values in the last message parsed that were out of range, not numbers or for read only keys. Their variables were left as they were.
+ *
+ * @return     The number of rejected values.
+ */
+uint8_t SerialCheckerKeyValue::getRejectedCount(){
+    return rejectedCount;
+}
+
+/**
+ * @brief      Adds a key to the table. The entries stay in the order they were added and byHash holds their indices in order of hash, so that find() can do a binary search.
+ */
+bool SerialCheckerKeyValue::addEntry(const char* key, keyValueTypeEnum type, void* variable){
+    uint8_t len = strlen(key);
+    uint16_t hash = 0;
+    for(uint8_t i = 0; i < len; i++){
+        hash = hashStep(hash, key[i]);
+    }
+    if(keyCount >= maxKeys || find(key, len, hash)){
+        return false;
+    }
+    Entry& entry = entries[keyCount];
+    entry.key = key;
+    entry.hash = hash;
+    entry.type = type;
+    entry.variable = variable;
+    entry.readOnly = false;
+    uint8_t i = keyCount;
+    while(i > 0 && entries[byHash[i - 1]].hash > hash){
+        byHash[i] = byHash[i - 1];
+        i--;
+    }
+    byHash[i] = keyCount;
+    keyCount++;
+    return true;
+}
+
+/**
+ * @brief      Finds a key in the table. If numbered keys are allowed, a key of digits is taken as the number of the key in the order they were added, starting from 0.
+ *
+ * @param[in]  key   The key, which does not need to be null terminated
+ * @param[in]  len   The length of the key
+ * @param[in]  hash  The key's hash, or 0 to work it out here
+ *
+ * @return     The entry, or nullptr if the key has not been added.
+ */
+SerialCheckerKeyValue::Entry* SerialCheckerKeyValue::find(const char* key, uint8_t len, uint16_t hash){
+    if(allowNumbers && len && key[0] >= '0' && key[0] <= '9'){
+        uint16_t number = 0;
+        for(uint8_t i = 0; i < len; i++){
+            if(key[i] < '0' || key[i] > '9'){
+                return nullptr;
+            }
+            number = number * 10 + key[i] - '0';
+            if(number >= keyCount){
+                return nullptr;
+            }
+        }
+        return &entries[number];
+    }
+    if(hash == 0){
+        for(uint8_t i = 0; i < len; i++){
+            hash = hashStep(hash, key[i]);
+        }
+    }
+    uint8_t low = 0;
+    uint8_t high = keyCount;
+    while(low < high){
+        uint8_t middle = (low + high) / 2;
+        if(entries[byHash[middle]].hash < hash){
+            low = middle + 1;
+        }
+        else{
+            high = middle;
+        }
+    }
+    // Different keys can share a hash, so check each entry with this hash.
+    for(; low < keyCount && entries[byHash[low]].hash == hash; low++){
+        Entry* entry = &entries[byHash[low]];
+        if(strncmp(entry->key, key, len) == 0 && entry->key[len] == '\0'){
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief      Converts the value starting at valueIndex and stores it if it is a number within the entry's range.
+ *
+ * @return     True if the variable was set.
+ */
+bool SerialCheckerKeyValue::store(Entry* entry, uint8_t valueIndex){
+    if(entry->readOnly){
+        return false;
+    }
+    char* value = &checker->getMsg()[valueIndex];
+    uint8_t i = value[0] == '-' ? 1 : 0;
+    bool digits = false;
+    bool point = false;
+    for(; value[i] && value[i] != ','; i++){
+        if(value[i] >= '0' && value[i] <= '9'){
+            digits = true;
+        }
+        else if(value[i] == '.' && !point && entry->type == keyValueTypeEnum::Float){
+            point = true;
+        }
+        else{
+            return false;
+        }
+    }
+    if(!digits){
+        return false;
+    }
+    if(entry->type == keyValueTypeEnum::Float){
+        float number = checker->toFloat(valueIndex);
+        if(number < entry->min.f || number > entry->max.f){
+            return false;
+        }
+        *(float*)entry->variable = number;
+        return true;
+    }
+    bool negative = value[0] == '-';
+    uint8_t first = negative;
+    while(value[first] == '0' && first + 1 < i){ // leading zeros, keeping the last digit
+        first++;
+    }
+    uint8_t digitCount = i - first;
+    if(digitCount > 10 || (digitCount == 10 && strncmp(&value[first], negative ? "2147483648" : "2147483647", 10) > 0)){
+        return false; // too big for an int32_t
+    }
+    int32_t number = checker->toInt32(valueIndex);
+    if(number < entry->min.i || number > entry->max.i){
+        return false;
+    }
+    if(entry->type == keyValueTypeEnum::Int16){
+        *(int16_t*)entry->variable = number;
+    }
+    else{
+        *(int32_t*)entry->variable = number;
+    }
+    return true;
+}
+
+/**
+ * @brief      One step of the key hash. A hash of 0 is avoided because find() takes 0 to mean "work it out".
+ */
+uint16_t SerialCheckerKeyValue::hashStep(uint16_t hash, char c){
+    hash = hash * 31 + (uint8_t)c;
+    return hash ? hash : 1;
+}
@@ -0,0 +1,67 @@
+#ifndef SERIALCHECKERKEYVALUE_H
+#define SERIALCHECKERKEYVALUE_H
+
+#include "SerialChecker.h"
+
+/**
+ * @brief      Longest unknown key that getUnknownKey() keeps. Longer ones are cut short.
+ */
+#ifndef SERIALCHECKERKEYVALUE_KEY_LEN
+#define SERIALCHECKERKEYVALUE_KEY_LEN 15
+#endif
+
+/**
+ * @brief      The types of variable a key can be bound to.
+ */
+enum class keyValueTypeEnum{ Float, Int32, Int16 };
+
+/**
+ * @brief      Parses settings messages such as "T=22.5,RAMP=10" straight in to the variables they set. Each key is added once with a pointer to its variable and the range of values it accepts. parse() then goes through the message once, looks each key up by its hash, which is worked out when the key is added, and stores every value that is in range. Values that are out of range or not numbers leave their variables alone, and keys that have not been added are counted so they can be reported.
+ *
+ *              SerialCheckerKeyValue settings(sc, 4);
+ *              settings.add("T", &temperature, -20.0, 80.0);
+ *              settings.add("RAMP", &rampRate, 0, 100);
+ *              ...
+ *              if(sc.check() && sc.contains('S')){
+ *                  settings.parse(1);
+ *              }
+ */
+class SerialCheckerKeyValue{
+public:
+    SerialCheckerKeyValue(SerialChecker& checker, uint8_t maxKeys);
+    ~SerialCheckerKeyValue();
+    bool add(const char* key, float* variable, float min, float max);
+    bool add(const char* key, int32_t* variable, int32_t min, int32_t max);
+    bool add(const char* key, int16_t* variable, int16_t min, int16_t max);
+    bool setReadOnly(const char* key);
+    uint8_t getKeyCount();
+    uint8_t parse();
+    uint8_t parse(uint8_t startIndex);
+    uint8_t getUnknownCount();
+    char* getUnknownKey();
+    uint8_t getRejectedCount();
+protected: // for SerialCheckerRegisters
+    struct Entry{
+        const char* key;
+        uint16_t hash;
+        keyValueTypeEnum type;
+        bool readOnly;
+        void* variable;
+        union{ float f; int32_t i; } min, max;
+    };
+    SerialChecker* checker;
+    Entry* entries; // in the order they were added
+    uint8_t* byHash; // indices of the entries in order of hash
+    bool allowNumbers = false; // keys of digits are entry numbers
+    uint8_t maxKeys;
+    uint8_t keyCount = 0;
+    uint8_t unknownCount = 0;
+    uint8_t rejectedCount = 0;
+    char unknownKey[SERIALCHECKERKEYVALUE_KEY_LEN + 1];
+    bool addEntry(const char* key, keyValueTypeEnum type, void* variable);
+    Entry* find(const char* key, uint8_t len, uint16_t hash);
+    bool store(Entry* entry, uint8_t valueIndex);
+    static uint16_t hashStep(uint16_t hash, char c);
+};
+
+#endif
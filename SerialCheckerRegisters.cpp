@@ -0,0 +1,204 @@
+#include "SerialCheckerRegisters.h"
+
+#if SERIALCHECKER_MESSAGE_HOOK
+
+/**
+ * @brief      Sets up a register table and hands it to the checker, whose check() answers register messages from then on.
+ *
+ * @param      checker       The checker that receives the messages and sends the replies
+ * @param[in]  maxRegisters  The most registers that can be added
+ */
+SerialCheckerRegisters::SerialCheckerRegisters(SerialChecker& checker, uint8_t maxRegisters) : SerialCheckerKeyValue(checker, maxRegisters){
+    allowNumbers = true;
+    checker.setMessageHook(handleHook, this);
+}
+
+SerialCheckerRegisters::~SerialCheckerRegisters(){
+    checker->setMessageHook(nullptr, nullptr);
+}
+
+/**
+ * @brief      Changes the chars that start get and set messages. They default to '?' and '!'. Pick chars that none of the sketch's own messages start with.
+ *
+ * @param[in]  getChar  The get char
+ * @param[in]  setChar  The set char
+ */
+void SerialCheckerRegisters::setCommandChars(char getChar, char setChar){
+    this->getChar = getChar;
+    this->setChar = setChar;
+}
+
+/**
+ * @brief      Answers the checker's current message if it is a get or set message. check() calls this for every message it receives.
+ *
+ * @return     True if the message was a register message and has been dealt with, false if it is one for the sketch.
+ */
+bool SerialCheckerRegisters::handle(){
+    char* message = checker->getMsg();
+    #if SERIALCHECKER_ADDRESS_FILTER
+    // Group and broadcast messages would get a reply from every node at once.
+    addressKindEnum kind = checker->getAddressKind();
+    bool reply = kind != addressKindEnum::Group && kind != addressKindEnum::Broadcast;
+    #else
+    bool reply = true; // without address filters there are no group or broadcast addresses
+    #endif
+    if(message[0] == setChar){
+        uint8_t stored = parse(1);
+        if(reply){
+            if(stored && !getUnknownCount() && !getRejectedCount()){
+                checker->sendAck();
+            }
+            else{
+                checker->sendNak();
+            }
+        }
+        return true;
+    }
+    if(message[0] != getChar){
+        return false;
+    }
+    if(!reply){
+        return true;
+    }
+    // Room for the STX, sequence number, checksum and ETX that sendFrame() adds, so the frame goes in one write.
+    const uint8_t maxLen = SERIALCHECKER_FRAME_BUFFER_LEN - 5;
+    char buffer[SERIALCHECKER_FRAME_BUFFER_LEN];
+    uint8_t len = checker->getAddressLen();
+    memcpy(buffer, checker->getRawMsg(), len);
+    uint8_t start = len;
+    if(message[1] == '\0'){
+        for(uint8_t i = 0; i < keyCount; i++){
+            if(!addRegister(buffer, len, maxLen, &entries[i])){
+                break;
+            }
+        }
+    }
+    else{
+        uint8_t i = 1;
+        while(message[i]){
+            uint8_t keyStart = i;
+            while(message[i] && message[i] != ','){
+                i++;
+            }
+            Entry* entry = find(&message[keyStart], i - keyStart, 0);
+            if(!entry){
+                checker->sendNak();
+                return true;
+            }
+            if(!addRegister(buffer, len, maxLen, entry)){
+                break;
+            }
+            if(message[i] == ','){
+                i++;
+            }
+        }
+    }
+    if(len == start){
+        checker->sendNak();
+        return true;
+    }
+    buffer[len] = '\0';
+    checker->sendFrame(buffer);
+    return true;
+}
+
+/**
+ * @brief      The checker's message hook, see SerialChecker::setMessageHook().
+ */
+bool SerialCheckerRegisters::handleHook(void* context){
+    return ((SerialCheckerRegisters*)context)->handle();
+}
+
+/**
+ * @brief      Adds "key=value" to the reply, with a comma first if it isn't the first one.
+ *
+ * @return     False if it doesn't fit, in which case the reply is left as it was.
+ */
+bool SerialCheckerRegisters::addRegister(char* reply, uint8_t& len, uint8_t maxLen, Entry* entry){
+    char value[24];
+    uint8_t valueLen;
+    switch(entry->type){
+        case keyValueTypeEnum::Float:
+            valueLen = formatFloat(*(float*)entry->variable, value);
+            break;
+        case keyValueTypeEnum::Int32:
+            valueLen = formatInt(*(int32_t*)entry->variable, value);
+            break;
+        default:
+            valueLen = formatInt(*(int16_t*)entry->variable, value);
+            break;
+    }
+    bool comma = len > checker->getAddressLen();
+    uint8_t keyLen = strlen(entry->key);
+    if(len + comma + keyLen + 1 + valueLen > maxLen){
+        return false;
+    }
+    if(comma){
+        reply[len++] = ',';
+    }
+    memcpy(&reply[len], entry->key, keyLen);
+    len += keyLen;
+    reply[len++] = '=';
+    memcpy(&reply[len], value, valueLen);
+    len += valueLen;
+    return true;
+}
+
+/**
+ * @brief      Writes n in decimal. snprintf() is avoided as it is large on an AVR.
+ *
+ * @return     The number of chars written, which are not null terminated.
+ */
+uint8_t SerialCheckerRegisters::formatInt(int32_t n, char* out){
+    uint8_t len = 0;
+    uint32_t u = n;
+    if(n < 0){
+        out[len++] = '-';
+        u = 0 - u;
+    }
+    char digits[10];
+    uint8_t count = 0;
+    do{
+        digits[count++] = '0' + u % 10;
+        u /= 10;
+    } while(u);
+    while(count){
+        out[len++] = digits[--count];
+    }
+    return len;
+}
+
+/**
+ * @brief      Writes f with SERIALCHECKERREGISTERS_DECIMALS decimal places, rounded. AVR's snprintf() has no %f. Values beyond the range of an int32_t are not written correctly.
+ *
+ * @return     The number of chars written, which are not null terminated.
+ */
+uint8_t SerialCheckerRegisters::formatFloat(float f, char* out){
+    uint32_t scale = 1;
+    for(uint8_t i = 0; i < SERIALCHECKERREGISTERS_DECIMALS; i++){
+        scale *= 10;
+    }
+    uint8_t len = 0;
+    bool negative = f < 0;
+    if(negative){
+        f = -f;
+    }
+    uint32_t whole = f;
+    uint32_t fraction = (f - whole) * scale + 0.5f;
+    if(fraction >= scale){
+        whole++;
+        fraction -= scale;
+    }
+    if(negative && (whole || fraction)){ // not -0.000
+        out[len++] = '-';
+    }
+    len += formatInt(whole, &out[len]);
+    if(SERIALCHECKERREGISTERS_DECIMALS){
+        out[len++] = '.';
+        for(uint32_t place = scale / 10; place; place /= 10){
+            out[len++] = '0' + fraction / place % 10;
+        }
+    }
+    return len;
+}
+#endif
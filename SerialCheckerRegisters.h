@@ -0,0 +1,48 @@
+#ifndef SERIALCHECKERREGISTERS_H
+#define SERIALCHECKERREGISTERS_H
+
+#include "SerialCheckerKeyValue.h"
+
+// check() answers register messages through the message hook, so there are no registers without it.
+#if SERIALCHECKER_MESSAGE_HOOK
+
+/**
+ * @brief      Decimal places used for float registers in replies.
+ */
+#ifndef SERIALCHECKERREGISTERS_DECIMALS
+#define SERIALCHECKERREGISTERS_DECIMALS 3
+#endif
+
+/**
+ * @brief      A table of registers that the checker answers by itself, so a sketch doesn't need its own "read X" / "write X" code. Registers are added the same way as keys in SerialCheckerKeyValue, with a pointer to the variable and its limits, and setReadOnly() stops the host from changing one. Once constructed, check() handles these messages itself and only returns the ones it doesn't recognise:
+ *
+ *              ?T             gets T, the reply is T=22.500
+ *              ?T,RAMP        gets several, the reply is T=22.500,RAMP=10
+ *              ?              gets every register in the order they were added
+ *              ?1             gets register number 1, the second one added, replying with its name
+ *              !T=22.5,RAMP=4 sets registers by name or number, the reply is an Ack, or a Nak if any were unknown, read only or out of range
+ *
+ *              Each reply is put together in one buffer and sent with sendFrame(), which uses a single write as long as the frame fits in SERIALCHECKER_FRAME_BUFFER_LEN. Registers that don't fit are left off the end, so ask for the rest by name or number. The node's address is put at the front of the reply, and messages sent to a group or broadcast address are acted on without a reply.
+ *
+ *              SerialCheckerRegisters registers(sc, 4);
+ *              registers.add("T", &temperature, -20.0, 80.0);
+ *              registers.add("V", &reading, 0, 1023);
+ *              registers.setReadOnly("V");
+ */
+class SerialCheckerRegisters : public SerialCheckerKeyValue{
+public:
+    SerialCheckerRegisters(SerialChecker& checker, uint8_t maxRegisters);
+    ~SerialCheckerRegisters();
+    void setCommandChars(char getChar, char setChar);
+    bool handle();
+private:
+    char getChar = '?';
+    char setChar = '!';
+    bool addRegister(char* reply, uint8_t& len, uint8_t maxLen, Entry* entry);
+    static bool handleHook(void* context);
+    static uint8_t formatInt(int32_t n, char* out);
+    static uint8_t formatFloat(float f, char* out);
+};
+
+#endif
+#endif
@@ -0,0 +1,314 @@
+#include "SerialCheckerSCPI.h"
+
+/**
+ * @brief      Sets up a command tree for the messages received by a checker. The table is not copied, so it must stay around, as a global const array does.
+ *
+ * @param      checker    The checker whose message buffer is parsed
+ * @param[in]  nodes      The table of nodes. A node's parent must come before it.
+ * @param[in]  nodeCount  The number of nodes, up to 254
+ * @param      context    Passed to every handler, or nullptr
+ */
+SerialCheckerSCPI::SerialCheckerSCPI(SerialChecker& checker, const scpiNode* nodes, uint8_t nodeCount, void* context){
+    this->checker = &checker;
+    this->nodes = nodes;
+    this->nodeCount = nodeCount;
+    this->context = context;
+    firstChild = new uint8_t[nodeCount + 1];
+    nextSibling = new uint8_t[nodeCount];
+    for(uint8_t i = 0; i <= nodeCount; i++){
+        firstChild[i] = SCPI_ROOT;
+    }
+    // Built backwards so that each node's children are linked in table order.
+    for(uint8_t i = nodeCount; i-- > 0;){
+        uint8_t parent = nodes[i].parent == SCPI_ROOT ? nodeCount : nodes[i].parent;
+        nextSibling[i] = firstChild[parent];
+        firstChild[parent] = i;
+    }
+}
+
+SerialCheckerSCPI::~SerialCheckerSCPI(){
+    delete [] firstChild;
+    delete [] nextSibling;
+}
+
+/**
+ * @brief      Handles the whole message, see handle(uint8_t startIndex).
+ *
+ * @return     The number of commands and queries run.
+ */
+uint8_t SerialCheckerSCPI::handle(){
+    return handle(0);
+}
+
+/**
+ * @brief      Walks the command tree along the checker's message and calls the handler of each command or query in it. It stops at the first error, see getLastError().
+ *
+ * @param[in]  startIndex  Where the first command starts in the message
+ *
+ * @return     The number of commands and queries run.
+ */
+uint8_t SerialCheckerSCPI::handle(uint8_t startIndex){
+    char* message = checker->getMsg();
+    uint8_t run = 0;
+    uint8_t branch = SCPI_ROOT; // where a command without a leading ':' starts
+    uint8_t i = startIndex;
+    lastError = scpiErrorEnum::None;
+    while(message[i]){
+        while(message[i] == ' '){
+            i++;
+        }
+        uint8_t node = branch;
+        if(message[i] == ':'){
+            node = SCPI_ROOT;
+            i++;
+        }
+        // Common commands such as *IDN? are found from the top and, as in IEEE 488.2, leave the branch as it was.
+        bool common = message[i] == '*';
+        if(common){
+            node = SCPI_ROOT;
+        }
+        // The header, one keyword per level of the tree.
+        while(true){
+            uint8_t keywordStart = i;
+            while(message[i] && message[i] != ':' && message[i] != ' ' && message[i] != '?' && message[i] != ';'){
+                i++;
+            }
+            node = findChild(node, &message[keywordStart], i - keywordStart);
+            if(node == SCPI_ROOT){
+                lastError = scpiErrorEnum::UndefinedHeader;
+                return run;
+            }
+            if(message[i] != ':'){
+                break;
+            }
+            i++;
+        }
+        bool query = message[i] == '?';
+        if(query){
+            i++;
+        }
+        argCount = 0;
+        while(message[i] == ' '){
+            i++;
+        }
+        while(message[i] && message[i] != ';'){
+            uint8_t start = i;
+            while(message[i] && message[i] != ',' && message[i] != ';'){
+                i++;
+            }
+            uint8_t end = i;
+            while(end > start && message[end - 1] == ' '){
+                end--;
+            }
+            if(argCount < SERIALCHECKERSCPI_MAX_ARGS){
+                argStart[argCount] = start;
+                argLen[argCount] = end - start;
+                argCount++;
+            }
+            if(message[i] == ','){
+                i++;
+                while(message[i] == ' '){
+                    i++;
+                }
+            }
+        }
+        scpiHandler handler = query ? nodes[node].query : nodes[node].command;
+        if(!handler){
+            lastError = query ? scpiErrorEnum::NotAQuery : scpiErrorEnum::QueryOnly;
+            return run;
+        }
+        if(!handler(*this, context)){
+            lastError = scpiErrorEnum::BadParameter;
+            return run;
+        }
+        run++;
+        if(!common){
+            branch = nodes[node].parent;
+        }
+        if(message[i] == ';'){
+            i++;
+        }
+    }
+    return run;
+}
+
+/**
+ * @brief      Gets why the last handle() stopped early.
+ *
+ * @return     scpiErrorEnum::None if every command in the message was run.
+ */
+scpiErrorEnum SerialCheckerSCPI::getLastError(){
+    return lastError;
+}
+
+/**
+ * @brief      Gets the number of arguments of the command being handled.
+ *
+ * @return     The number of arguments, up to SERIALCHECKERSCPI_MAX_ARGS.
+ */
+uint8_t SerialCheckerSCPI::getArgCount(){
+    return argCount;
+}
+
+/**
+ * @brief      Checks that an argument is a decimal number, with an optional sign and decimal point, before it is converted.
+ *
+ * @param[in]  arg   The argument number, starting from 0
+ *
+ * @return     True if it is a number.
+ */
+bool SerialCheckerSCPI::isNumber(uint8_t arg){
+    if(arg >= argCount){
+        return false;
+    }
+    char* value = &checker->getMsg()[argStart[arg]];
+    uint8_t i = value[0] == '-' || value[0] == '+' ? 1 : 0;
+    bool digits = false;
+    bool point = false;
+    for(; i < argLen[arg]; i++){
+        if(value[i] >= '0' && value[i] <= '9'){
+            digits = true;
+        }
+        else if(value[i] == '.' && !point){
+            point = true;
+        }
+        else{
+            return false;
+        }
+    }
+    return digits;
+}
+
+/**
+ * @brief      Converts an argument with the checker's toFloat().
+ *
+ * @param[in]  arg   The argument number, starting from 0
+ *
+ * @return     The value, or 0 if there is no such argument.
+ */
+float SerialCheckerSCPI::getFloat(uint8_t arg){
+    if(arg >= argCount){
+        return 0;
+    }
+    uint8_t start = argStart[arg];
+    if(checker->getMsg()[start] == '+'){
+        start++;
+    }
+    return checker->toFloat(start);
+}
+
+/**
+ * @brief      Converts an argument with the checker's toInt32().
+ *
+ * @param[in]  arg   The argument number, starting from 0
+ *
+ * @return     The value, or 0 if there is no such argument.
+ */
+int32_t SerialCheckerSCPI::getInt32(uint8_t arg){
+    if(arg >= argCount){
+        return 0;
+    }
+    uint8_t start = argStart[arg];
+    if(checker->getMsg()[start] == '+'){
+        start++;
+    }
+    return checker->toInt32(start);
+}
+
+/**
+ * @brief      Converts an argument with the checker's toInt16().
+ *
+ * @param[in]  arg   The argument number, starting from 0
+ *
+ * @return     The value, or 0 if there is no such argument.
+ */
+int16_t SerialCheckerSCPI::getInt16(uint8_t arg){
+    if(arg >= argCount){
+        return 0;
+    }
+    uint8_t start = argStart[arg];
+    if(checker->getMsg()[start] == '+'){
+        start++;
+    }
+    return checker->toInt16(start);
+}
+
+/**
+ * @brief      Gets an argument as text, for example for "ON" or "OFF". It is not null terminated, see getArgLen().
+ *
+ * @param[in]  arg   The argument number, starting from 0
+ *
+ * @return     Pointer to the start of the argument in the message, or nullptr if there is no such argument.
+ */
+char* SerialCheckerSCPI::getArg(uint8_t arg){
+    if(arg >= argCount){
+        return nullptr;
+    }
+    return &checker->getMsg()[argStart[arg]];
+}
+
+/**
+ * @brief      Gets the length of an argument, without any spaces around it.
+ *
+ * @param[in]  arg   The argument number, starting from 0
+ *
+ * @return     The length, or 0 if there is no such argument.
+ */
+uint8_t SerialCheckerSCPI::getArgLen(uint8_t arg){
+    if(arg >= argCount){
+        return 0;
+    }
+    return argLen[arg];
+}
+
+/**
+ * @brief      Gets the checker, so handlers can send their replies.
+ *
+ * @return     The checker.
+ */
+SerialChecker& SerialCheckerSCPI::getChecker(){
+    return *checker;
+}
+
+/**
+ * @brief      Looks through the children of a node for a keyword.
+ *
+ * @return     The index of the child, or SCPI_ROOT if there is none.
+ */
+uint8_t SerialCheckerSCPI::findChild(uint8_t parent, const char* keyword, uint8_t len){
+    uint8_t child = firstChild[parent == SCPI_ROOT ? nodeCount : parent];
+    while(child != SCPI_ROOT){
+        if(keywordMatch(nodes[child].keyword, keyword, len)){
+            return child;
+        }
+        child = nextSibling[child];
+    }
+    return SCPI_ROOT;
+}
+
+/**
+ * @brief      Compares a received keyword with a node's keyword, ignoring case. It must be the short form, the leading capitals, or the whole long form.
+ */
+bool SerialCheckerSCPI::keywordMatch(const char* keyword, const char* received, uint8_t len){
+    uint8_t shortLen = 0;
+    uint8_t i = 0;
+    for(; keyword[i]; i++){
+        char k = keyword[i];
+        if(k >= 'a' && k <= 'z'){
+            k -= 'a' - 'A';
+        }
+        else if(i == shortLen){
+            shortLen++; // still in the leading capitals, digits or '*'
+        }
+        if(i < len){
+            char r = received[i];
+            if(r >= 'a' && r <= 'z'){
+                r -= 'a' - 'A';
+            }
+            if(r != k){
+                return false;
+            }
+        }
+    }
+    return len == shortLen || len == i;
+}
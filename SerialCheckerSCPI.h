@@ -0,0 +1,90 @@
+#ifndef SERIALCHECKERSCPI_H
+#define SERIALCHECKERSCPI_H
+
+#include "SerialChecker.h"
+
+/**
+ * @brief      The most arguments one command can have. Extra ones are ignored.
+ */
+#ifndef SERIALCHECKERSCPI_MAX_ARGS
+#define SERIALCHECKERSCPI_MAX_ARGS 4
+#endif
+
+/**
+ * @brief      Parent of the nodes at the top of the command tree.
+ */
+#define SCPI_ROOT 0xFF
+
+/**
+ * @brief      The reasons handle() can stop, see getLastError().
+ */
+enum class scpiErrorEnum{ None, UndefinedHeader, NotAQuery, QueryOnly, BadParameter };
+
+class SerialCheckerSCPI;
+
+/**
+ * @brief      Called when a command or query reaches its node. Arguments are read with getArgCount(), getFloat() and friends.
+ *
+ * @return     False if the arguments were wrong, which handle() reports as scpiErrorEnum::BadParameter.
+ */
+typedef bool (*scpiHandler)(SerialCheckerSCPI& scpi, void* context);
+
+/**
+ * @brief      One keyword in the command tree. The capital letters at the start of the keyword are its short form and the whole keyword is its long form, so "VOLTage" matches "VOLT" and "VOLTAGE" in any case. command is called for "VOLT 12.5" and query for "VOLT?". Either can be nullptr.
+ */
+struct scpiNode{
+    const char* keyword;
+    uint8_t parent; // index of the parent node in the table, or SCPI_ROOT
+    scpiHandler command;
+    scpiHandler query;
+};
+
+/**
+ * @brief      Handles SCPI style messages such as "SOUR:VOLT 12.5" and "MEAS:CURR?" in the checker's message buffer. The tree comes from a table that the sketch keeps, where each node gives the index of its parent:
+ *
+ *              enum{ SOUR, SOUR_VOLT, MEAS, MEAS_CURR };
+ *              const scpiNode commands[] = {
+ *                  { "SOURce", SCPI_ROOT, nullptr, nullptr },
+ *                  { "VOLTage", SOUR, setVoltage, getVoltage },
+ *                  { "MEASure", SCPI_ROOT, nullptr, nullptr },
+ *                  { "CURRent", MEAS, nullptr, measureCurrent },
+ *              };
+ *              SerialCheckerSCPI scpi(sc, commands, 4, nullptr);
+ *              ...
+ *              if(sc.check()){
+ *                  scpi.handle();
+ *              }
+ *
+ *              The constructor links each node to its first child and next sibling once, so handle() only compares each keyword in the message against the children of the node before it, in one pass along the message. Several commands can be sent at once separated by ';'. As in SCPI, a command after a ';' starts from the same branch as the one before it unless it begins with ':'. Common commands that begin with '*', such as *IDN?, are top level nodes found from any branch, and the branch is left as it was, so "SOUR:VOLT 1;*IDN?;VOLT 2" sets the voltage twice. Arguments follow the header after a space and are separated by commas.
+ */
+class SerialCheckerSCPI{
+public:
+    SerialCheckerSCPI(SerialChecker& checker, const scpiNode* nodes, uint8_t nodeCount, void* context);
+    ~SerialCheckerSCPI();
+    uint8_t handle();
+    uint8_t handle(uint8_t startIndex);
+    scpiErrorEnum getLastError();
+    uint8_t getArgCount();
+    bool isNumber(uint8_t arg);
+    float getFloat(uint8_t arg);
+    int32_t getInt32(uint8_t arg);
+    int16_t getInt16(uint8_t arg);
+    char* getArg(uint8_t arg);
+    uint8_t getArgLen(uint8_t arg);
+    SerialChecker& getChecker();
+private:
+    SerialChecker* checker;
+    const scpiNode* nodes;
+    uint8_t nodeCount;
+    void* context;
+    uint8_t* firstChild; // SCPI_ROOT for none; entry nodeCount is the first top level node
+    uint8_t* nextSibling;
+    uint8_t argCount = 0;
+    uint8_t argStart[SERIALCHECKERSCPI_MAX_ARGS];
+    uint8_t argLen[SERIALCHECKERSCPI_MAX_ARGS];
+    scpiErrorEnum lastError = scpiErrorEnum::None;
+    uint8_t findChild(uint8_t parent, const char* keyword, uint8_t len);
+    static bool keywordMatch(const char* keyword, const char* received, uint8_t len);
+};
+
+#endif
@@ -0,0 +1,283 @@
+/**
+ * @brief      Cycle counts for SerialChecker on the AVR boards it is deployed on, run in simavr so no board is needed. See run_bench_avr.sh, which builds this sketch for an Uno (ATmega328P) and a Mega (ATmega2560) and runs it.
+ *
+ *              Timer1 runs at the CPU clock so it counts cycles, with an overflow count for the top 16 bits. Timer0, which runs millis(), is stopped while measuring. The same stream of frames, with a few damaged ones, is fed through checkChar() for each configuration, and the converters and checksums are timed one call at a time. The stack is painted before each measurement so the deepest point it reached can be found afterwards.
+ *
+ *              Each result is a line starting with "BENCH" so the runner can pick them out of simavr's output:
+ *              BENCH frame,<configuration>,<cycles per byte>,<cycles per accepted frame>,<accepted frames>,<stack bytes>,<heap bytes>
+ *              BENCH call,<function>,<cycles per call>,<stack bytes>
+ *              BENCH sram,<static bytes>,<heap bytes>,<lowest free bytes>
+ *
+ *              It also runs on a real board, printing the same lines to Serial.
+ */
+#include "SerialChecker.h"
+#include "SerialCheckerFraming.h"
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#define BENCH_REPEATS 20
+#define BENCH_PAINT 0xC5
+
+extern uint8_t __heap_start;
+extern uint8_t __bss_end;
+extern uint8_t* __brkval;
+
+volatile uint16_t overflows = 0;
+
+ISR(TIMER1_OVF_vect){
+    overflows++;
+}
+
+static uint32_t cycles(){
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t count = TCNT1;
+    uint16_t high = overflows;
+    if((TIFR1 & _BV(TOV1)) && count < 0x8000){
+        high++; // overflowed since interrupts were turned off
+    }
+    SREG = sreg;
+    return ((uint32_t)high << 16) | count;
+}
+
+static uint32_t overhead = 0; // of a measurement with nothing in it
+
+static void startTiming(){
+    Serial.flush(); // so the UART interrupt doesn't land in the measurement
+    TIMSK0 &= ~_BV(TOIE0);
+}
+
+static void stopTiming(){
+    TIMSK0 |= _BV(TOIE0);
+}
+
+static uint8_t* heapEnd(){
+    return __brkval ? __brkval : &__heap_start;
+}
+
+/**
+ * @brief      Fills the free RAM between the heap and the stack with BENCH_PAINT.
+ */
+static void __attribute__((noinline)) paintStack(){
+    uint8_t marker;
+    for(uint8_t* p = heapEnd(); p < &marker - 8; p++){
+        *p = BENCH_PAINT;
+    }
+}
+
+/**
+ * @brief      Finds the deepest point the stack has reached since paintStack().
+ *
+ * @return     Bytes of stack used, measured from the top of RAM.
+ */
+static uint16_t stackUsed(){
+    uint8_t* p = heapEnd();
+    while(p <= (uint8_t*)RAMEND && *p == BENCH_PAINT){
+        p++;
+    }
+    return (uint8_t*)RAMEND - p + 1;
+}
+
+static uint16_t lowestFree = 0xFFFF;
+
+static void noteStack(uint16_t used){
+    uint16_t free = (uint8_t*)RAMEND + 1 - used - heapEnd();
+    if(free < lowestFree){
+        lowestFree = free;
+    }
+}
+
+/**
+ * @brief      Builds the test stream in buf: readings such as "BV12345" for nodes 'A' to 'D', with an STX char and checksum if used. About 1 in 16 frames has a char changed.
+ *
+ * @return     The length of the stream.
+ */
+static uint16_t makeStream(char* buf, uint16_t size, bool useSTX, checksumTypeEnum type, bool useChecksum){
+    uint16_t len = 0;
+    uint16_t seed = 12345;
+    char frame[16];
+    while(true){
+        seed = seed * 25173 + 13849;
+        uint8_t frameLen = 0;
+        if(useSTX){
+            frame[frameLen++] = '$';
+        }
+        uint8_t start = frameLen;
+        frame[frameLen++] = 'A' + (seed >> 14);
+        frame[frameLen++] = 'V';
+        uint16_t reading = seed % 50000;
+        for(uint16_t place = 10000; place; place /= 10){
+            frame[frameLen++] = '0' + reading / place % 10;
+        }
+        if(useChecksum){
+            frame[frameLen] = type == checksumTypeEnum::SpellmanMPS ? SerialChecker::chksmSpellmanMPS(&frame[start], frameLen - start) : SerialChecker::chksm8bitAllReadableChars(&frame[start], frameLen - start);
+            frameLen++;
+        }
+        if((seed & 0x0F) == 0){
+            frame[start + 3] ^= 1;
+        }
+        frame[frameLen++] = '\n';
+        if(len + frameLen > size){
+            return len;
+        }
+        memcpy(&buf[len], frame, frameLen);
+        len += frameLen;
+    }
+}
+
+char stream[200];
+
+template<class Checker>
+static void benchFrames(const __FlashStringHelper* name, Checker& checker, uint16_t len, uint16_t heap){
+    paintStack();
+    startTiming();
+    uint16_t accepted = 0;
+    uint32_t start = cycles();
+    for(uint8_t repeat = 0; repeat < BENCH_REPEATS; repeat++){
+        for(uint16_t i = 0; i < len; i++){
+            if(checker.checkChar(stream[i])){
+                accepted++;
+            }
+        }
+    }
+    uint32_t total = cycles() - start - overhead;
+    stopTiming();
+    uint16_t stack = stackUsed();
+    noteStack(stack);
+    Serial.print(F("BENCH frame,"));
+    Serial.print(name);
+    Serial.print(',');
+    Serial.print((float)total / ((uint32_t)len * BENCH_REPEATS), 1);
+    Serial.print(',');
+    Serial.print(accepted ? total / accepted : 0);
+    Serial.print(',');
+    Serial.print(accepted / BENCH_REPEATS);
+    Serial.print(',');
+    Serial.print(stack);
+    Serial.print(',');
+    Serial.println(heap);
+}
+
+/**
+ * @brief      Runs a SerialChecker configured by setup over the stream, which is built to match.
+ */
+static void benchConfig(const __FlashStringHelper* name, bool useSTX, bool useChecksum, checksumTypeEnum type, bool filter){
+    uint16_t len = makeStream(stream, sizeof(stream), useSTX, type, useChecksum);
+    uint8_t* heapBefore = heapEnd();
+    SerialChecker checker(16);
+    checker.setAddressLen(1);
+    if(useSTX){
+        checker.enableSTX(true);
+    }
+    if(useChecksum){
+        checker.enableChecksum();
+        checker.setChecksumType(type);
+    }
+    #if SERIALCHECKER_ADDRESS_FILTER
+    if(filter){
+        checker.setAddressFilter((char*)"B");
+    }
+    #endif
+    benchFrames(name, checker, len, heapEnd() - heapBefore);
+}
+
+template<class Checker>
+static void benchFraming(const __FlashStringHelper* name, bool useSTX, bool useChecksum){
+    uint16_t len = makeStream(stream, sizeof(stream), useSTX, checksumTypeEnum::Readable8bitChars, useChecksum);
+    uint8_t* heapBefore = heapEnd();
+    Checker checker(16);
+    checker.setAddressLen(1);
+    benchFrames(name, checker, len, heapEnd() - heapBefore);
+}
+
+SerialChecker calls(16);
+volatile float floatResult;
+volatile int32_t intResult;
+volatile char charResult;
+
+/**
+ * @brief      Times one call of each converter and checksum on a message loaded with loadMsg().
+ */
+static void benchCall(const __FlashStringHelper* name, const char* message, uint8_t which){
+    calls.loadMsg(message, strlen(message));
+    paintStack();
+    startTiming();
+    uint32_t start = cycles();
+    switch(which){
+        case 0:
+            floatResult = calls.toFloat(1);
+            break;
+        case 1:
+            intResult = calls.toInt32(1);
+            break;
+        case 2:
+            intResult = calls.toScaled(1, 1000);
+            break;
+        case 3:
+            intResult = calls.toFixed<16>(1);
+            break;
+        case 4:
+            charResult = SerialChecker::chksm8bitAllReadableChars(message, strlen(message));
+            break;
+        case 5:
+            charResult = SerialChecker::chksmSpellmanMPS(message, strlen(message));
+            break;
+        default:
+            break;
+    }
+    uint32_t total = cycles() - start - overhead;
+    stopTiming();
+    uint16_t stack = stackUsed();
+    noteStack(stack);
+    Serial.print(F("BENCH call,"));
+    Serial.print(name);
+    Serial.print(',');
+    Serial.print(total);
+    Serial.print(',');
+    Serial.println(stack);
+}
+
+void setup(){
+    Serial.begin(115200);
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10); // no prescaler, one count per cycle
+    TIMSK1 = _BV(TOIE1);
+    startTiming();
+    uint32_t start = cycles();
+    overhead = cycles() - start;
+    stopTiming();
+
+    benchConfig(F("no STX, no checksum"), false, false, checksumTypeEnum::Readable8bitChars, false);
+    benchConfig(F("STX, readable checksum"), true, true, checksumTypeEnum::Readable8bitChars, false);
+    benchConfig(F("STX, SpellmanMPS checksum"), true, true, checksumTypeEnum::SpellmanMPS, false);
+    #if SERIALCHECKER_ADDRESS_FILTER
+    benchConfig(F("STX, readable, address filter"), true, true, checksumTypeEnum::Readable8bitChars, true);
+    #endif
+    benchFraming<Framing<STX::None, Checksum::None, AckNak::Off>>(F("Framing, no STX, no checksum"), false, false);
+    benchFraming<Framing<STX::Required, Checksum::Readable8bit, AckNak::Off>>(F("Framing, STX, readable"), true, true);
+
+    benchCall(F("toFloat() V12.345"), "AV12.345", 0);
+    benchCall(F("toInt32() V12345"), "AV12345", 1);
+    benchCall(F("toScaled() V12.345"), "AV12.345", 2);
+    benchCall(F("toFixed<16>() V12.345"), "AV12.345", 3);
+    benchCall(F("chksm8bitAllReadableChars() 16 chars"), "AV12345678901234", 4);
+    benchCall(F("chksmSpellmanMPS() 16 chars"), "AV12345678901234", 5);
+
+    Serial.print(F("BENCH sram,"));
+    Serial.print(&__bss_end - (uint8_t*)RAMSTART);
+    Serial.print(',');
+    Serial.print(heapEnd() - &__heap_start);
+    Serial.print(',');
+    Serial.println(lowestFree);
+    Serial.println(F("BENCH end"));
+    Serial.flush();
+    // simavr stops when the CPU sleeps with interrupts off.
+    cli();
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    sleep_cpu();
+}
+
+void loop(){
+}
@@ -0,0 +1,52 @@
+#!/bin/sh
+# Builds bench_avr.ino for an Uno and a Mega with arduino-cli, runs each in simavr at 16 MHz and prints the results as tables.
+# Then builds size_avr/size_avr.ino a few ways and prints the flash and static RAM each takes.
+# Needs arduino-cli with the arduino:avr core installed, and simavr.
+#
+# Usage: bench_avr/run_bench_avr.sh [uno] [mega]
+
+set -e
+cd "$(dirname "$0")"
+boards=${*:-uno mega}
+ALL_FEATURES="-DSERIALCHECKER_RECORDER=1 -DSERIALCHECKER_ACK_BATCHING=1 -DSERIALCHECKER_MESSAGE_HOOK=1 -DSERIALCHECKER_DUPLICATE_FILTER=1 -DSERIALCHECKER_REPLY_CACHE=1 -DSERIALCHECKER_TX_QUEUES=1 -DSERIALCHECKER_ADDRESS_FILTER=1"
+
+# Builds size_avr.ino with the flags given and prints its flash (text + data) and static RAM (data + bss).
+size_row(){
+    out="build/$board/size"
+    mkdir -p "$out"
+    arduino-cli compile --fqbn "$fqbn" --library .. --build-property "compiler.cpp.extra_flags=$2" --output-dir "$out" size_avr > "$out/compile.log" 2>&1 || { cat "$out/compile.log" >&2; exit 1; }
+    avr-size "$out/size_avr.ino.elf" | awk -v name="$1" 'NR == 2 { printf "%-44s %8d %8d\n", name, $1 + $2, $2 + $3 }'
+}
+
+for board in $boards; do
+    case $board in
+        uno) fqbn=arduino:avr:uno; mcu=atmega328p ;;
+        mega) fqbn=arduino:avr:mega:cpu=atmega2560; mcu=atmega2560 ;;
+        *) echo "unknown board $board, use uno or mega" >&2; exit 2 ;;
+    esac
+    # The library is the folder above this one. The address filter is switched on so that it is measured too.
+    mkdir -p "build/$board"
+    arduino-cli compile --fqbn "$fqbn" --library .. --build-property "compiler.cpp.extra_flags=-DSERIALCHECKER_ADDRESS_FILTER=1" --output-dir "build/$board" . > "build/$board/compile.log" 2>&1 || { cat "build/$board/compile.log" >&2; exit 1; }
+    echo "$board ($mcu, 16 MHz)"
+    avr-size -C --mcu="$mcu" "build/$board/bench_avr.ino.elf"
+    # simavr prints the UART output among its own messages, so only the BENCH lines are kept.
+    timeout 120 simavr -m "$mcu" -f 16000000 "build/$board/bench_avr.ino.elf" 2>&1 | sed -n 's/.*BENCH \(.*\)/\1/p' | awk -F, '
+        $1 == "frame" {
+            if(!frames++){ printf "%-32s %10s %10s %9s %7s %6s\n", "configuration", "cyc/byte", "cyc/frame", "accepted", "stack", "heap" }
+            printf "%-32s %10s %10s %9s %7s %6s\n", $2, $3, $4, $5, $6, $7
+        }
+        $1 == "call" {
+            if(!calls++){ printf "\n%-40s %10s %7s\n", "call", "cycles", "stack" }
+            printf "%-40s %10s %7s\n", $2, $3, $4
+        }
+        $1 == "sram" { printf "\nstatic RAM %s bytes, heap %s bytes, least free RAM %s bytes\n", $2, $3, $4 }
+        $1 == "end" { done = 1 }
+        END { if(!done){ print "simavr did not finish the run" > "/dev/stderr"; exit 1 } }'
+    printf "\n%-44s %8s %8s\n" "sketch" "flash" "RAM"
+    size_row "SerialChecker, STX and checksum" "-DBENCH_SIZE=0"
+    size_row "SerialChecker, every feature switched on" "-DBENCH_SIZE=0 $ALL_FEATURES"
+    size_row "Framing, STX and checksum" "-DBENCH_SIZE=1"
+    size_row "toFloat() and print a float" "-DBENCH_SIZE=2"
+    size_row "toScaled() and printlnScaled()" "-DBENCH_SIZE=3"
+    echo
+done
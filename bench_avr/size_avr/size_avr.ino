@@ -0,0 +1,42 @@
+/**
+ * @brief      The smallest sketches for the size comparisons in run_bench_avr.sh. It is built once for each BENCH_SIZE and avr-size gives the flash and static RAM each one takes.
+ *
+ *              0  SerialChecker with STX and a readable checksum, sending each message back
+ *              1  The same with Framing
+ *              2  SerialChecker reading a number with toFloat() and printing it as a float
+ *              3  The same with toScaled() and printlnScaled()
+ *
+ *              0 is also built with every feature switch at 1, to show what leaving them out saves on an arduino.
+ */
+#include "SerialChecker.h"
+#include "SerialCheckerFraming.h"
+
+#ifndef BENCH_SIZE
+#define BENCH_SIZE 0
+#endif
+
+#if BENCH_SIZE == 1
+Framing<STX::Required, Checksum::Readable8bit, AckNak::Off> sc(Serial);
+#else
+SerialChecker sc(Serial);
+#endif
+
+void setup(){
+    sc.init();
+    #if BENCH_SIZE == 0
+    sc.enableSTX(true);
+    sc.enableChecksum();
+    #endif
+}
+
+void loop(){
+    if(sc.check()){
+    #if BENCH_SIZE == 2
+        sc.println(sc.toFloat() * 2);
+    #elif BENCH_SIZE == 3
+        sc.printlnScaled(sc.toScaled(1000) * 2, 1000);
+    #else
+        sc.sendFrame(sc.getMsg());
+    #endif
+    }
+}
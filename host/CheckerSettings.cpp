@@ -0,0 +1,94 @@
+#include "CheckerSettings.h"
+
+#include<stdlib.h>
+#include<string.h>
+
+/**
+ * @brief      Applies one of the CHECKER_SETTINGS_OPTIONS command line options.
+ *
+ * @param[in]  opt   The option letter returned by getopt()
+ * @param[in]  arg   The option argument, optarg
+ *
+ * @return     False if the option is not one of CHECKER_SETTINGS_OPTIONS.
+ */
+bool CheckerSettings::parseOption(int opt, const char* arg){
+    switch(opt){
+        case 'c':
+            useChecksum = true;
+            checksumType = arg[0] == 's' ? checksumTypeEnum::SpellmanMPS : checksumTypeEnum::Readable8bitChars;
+            return true;
+        case 's':
+        case 'S':
+            useSTX = true;
+            requireSTX = opt == 'S';
+            STX = arg[0];
+            return true;
+        case 'e':
+            ETX = strcmp(arg, "\\r") == 0 ? '\r' : (strcmp(arg, "\\n") == 0 ? '\n' : arg[0]);
+            return true;
+        case 'a':
+            addressLen = atoi(arg);
+            return true;
+        case 'm':
+            msgMaxLen = atoi(arg);
+            return true;
+        case 'n':
+            msgMinLen = atoi(arg);
+            return true;
+        case 'r':
+            allowCR = true;
+            return true;
+        case 'N':
+            useSeqNum = true;
+            return true;
+        case 'f':
+            addressFilter = arg;
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief      Sets up a checker with these settings.
+ *
+ * @param      checker  The checker. It should have been constructed with msgMaxLen.
+ */
+void CheckerSettings::configure(SerialChecker& checker) const{
+    if(useChecksum){
+        checker.enableChecksum();
+        checker.setChecksumType(checksumType);
+    }
+    if(useSTX){
+        checker.enableSTX(requireSTX, STX);
+    }
+    checker.setETX(ETX);
+    checker.setAllowCR(allowCR);
+    checker.setMsgMinLen(msgMinLen);
+    if(useSeqNum){
+        checker.enableSeqNum();
+    }
+    if(addressLen){
+        checker.setAddressLen(addressLen);
+        if(addressFilter){
+            checker.setAddressFilter((char*)addressFilter);
+        }
+    }
+}
+
+/**
+ * @brief      Gets a printable name for a rejection reason.
+ *
+ * @param[in]  reason  The reason
+ *
+ * @return     The name.
+ */
+const char* CheckerSettings::reasonName(frameErrorEnum reason){
+    switch(reason){
+        case frameErrorEnum::TooShort: return "too short";
+        case frameErrorEnum::TooLong: return "too long";
+        case frameErrorEnum::BadChecksum: return "bad checksum";
+        case frameErrorEnum::MissingSTX: return "missing STX";
+        case frameErrorEnum::BadSeqNum: return "bad seq";
+        default: return "none";
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef CHECKERSETTINGS_H
+#define CHECKERSETTINGS_H
+
+#include "SerialChecker.h"
+
+/**
+ * @brief      The getopt() option letters understood by CheckerSettings::parseOption(), for the host tools that run captured traffic through a SerialChecker.
+ *                  -c r|s      use checksums, readable 8 bit (r) or Spellman MPS (s)
+ *                  -s C        optional STX char C
+ *                  -S C        required STX char C
+ *                  -e C        ETX char C, default '\n'. \n and \r can be written out.
+ *                  -a N        address length N
+ *                  -m N        message maximum length N, default 13
+ *                  -n N        message minimum length N, default 1
+ *                  -r          allow \r chars in messages
+ *                  -N          messages carry sequence numbers
+ *                  -f A        only look at messages for address A, skipping the rest as the arduino does with setAddressFilter()
+ */
+#define CHECKER_SETTINGS_OPTIONS "c:s:S:e:a:m:n:rNf:"
+
+/**
+ * @brief      The SerialChecker settings used by the arduino whose traffic is being looked at, so that the host tools treat the traffic exactly as the arduino did.
+ */
+struct CheckerSettings{
+    bool useChecksum = false;
+    checksumTypeEnum checksumType = checksumTypeEnum::Readable8bitChars;
+    bool useSTX = false;
+    bool requireSTX = false;
+    char STX = '$';
+    char ETX = '\n';
+    uint8_t addressLen = 0;
+    uint8_t msgMaxLen = 13;
+    uint8_t msgMinLen = 1;
+    bool allowCR = false;
+    bool useSeqNum = false;
+    const char* addressFilter = nullptr;
+
+    bool parseOption(int opt, const char* arg);
+    void configure(SerialChecker& checker) const;
+    static const char* reasonName(frameErrorEnum reason);
+};
+
+#endif
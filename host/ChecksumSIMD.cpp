@@ -0,0 +1,294 @@
+#include "ChecksumSIMD.h"
+#include "SerialChecker.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CHECKSUMSIMD_X86
+#include<immintrin.h>
+#endif
+
+namespace ChecksumSIMD{
+
+typedef uint8_t (*sumFunction)(const char* buffer, size_t len);
+typedef void (*batchFunction)(const char* messages, const int32_t* lengths, int32_t count, uint8_t* sums);
+
+// Loading 16 or 32 bytes from &sumMask[n] gives n 0xFF bytes followed by zeros, to mask off the chars past the end of a short message.
+static const uint8_t sumMask[64] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static uint8_t sum8Scalar(const char* buffer, size_t len){
+    uint8_t sum = 0;
+    for(size_t i = 0; i < len; i++){
+        sum += buffer[i];
+    }
+    return sum;
+}
+
+static void sum8BatchScalar(const char* messages, const int32_t* lengths, int32_t count, uint8_t* sums){
+    for(int32_t i = 0; i < count; i++){
+        sums[i] = sum8Scalar(messages, lengths[i]);
+        messages += lengths[i];
+    }
+}
+
+#ifdef CHECKSUMSIMD_X86
+__attribute__((target("sse2")))
+static uint8_t horizontalSum(__m128i acc){
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    return (uint8_t)(lanes[0] + lanes[1]);
+}
+
+__attribute__((target("sse2")))
+static uint8_t sum8SSE2(const char* buffer, size_t len){
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = zero;
+    __m128i acc1 = zero;
+    // psadbw against zero adds each group of 8 bytes in to a 64 bit lane, which can not overflow for any realistic buffer
+    while(len >= 64){
+        __m128i a = _mm_loadu_si128((const __m128i*)buffer);
+        __m128i b = _mm_loadu_si128((const __m128i*)(buffer + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(buffer + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(buffer + 48));
+        acc0 = _mm_add_epi64(acc0, _mm_add_epi64(_mm_sad_epu8(a, zero), _mm_sad_epu8(b, zero)));
+        acc1 = _mm_add_epi64(acc1, _mm_add_epi64(_mm_sad_epu8(c, zero), _mm_sad_epu8(d, zero)));
+        buffer += 64;
+        len -= 64;
+    }
+    while(len >= 16){
+        acc0 = _mm_add_epi64(acc0, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)buffer), zero));
+        buffer += 16;
+        len -= 16;
+    }
+    return horizontalSum(_mm_add_epi64(acc0, acc1)) + sum8Scalar(buffer, len);
+}
+
+__attribute__((target("sse2")))
+static void sum8BatchSSE2(const char* messages, const int32_t* lengths, int32_t count, uint8_t* sums){
+    const __m128i zero = _mm_setzero_si128();
+    const char* end = messages;
+    for(int32_t i = 0; i < count; i++){
+        end += lengths[i];
+    }
+    for(int32_t i = 0; i < count; i++){
+        const char* p = messages;
+        size_t len = lengths[i];
+        __m128i acc = zero;
+        while(len >= 16){
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)p), zero));
+            p += 16;
+            len -= 16;
+        }
+        uint8_t tail = 0;
+        if(len && end - p >= 16){
+            // Read a whole block and mask off the chars that belong to the next message.
+            __m128i block = _mm_and_si128(_mm_loadu_si128((const __m128i*)p), _mm_loadu_si128((const __m128i*)&sumMask[32 - len]));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(block, zero));
+        }
+        else{
+            tail = sum8Scalar(p, len);
+        }
+        sums[i] = horizontalSum(acc) + tail;
+        messages += lengths[i];
+    }
+}
+
+__attribute__((target("avx2")))
+static uint8_t horizontalSum256(__m256i acc){
+    return horizontalSum(_mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1)));
+}
+
+__attribute__((target("avx2")))
+static uint8_t sum8AVX2(const char* buffer, size_t len){
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = zero;
+    __m256i acc1 = zero;
+    while(len >= 128){
+        __m256i a = _mm256_loadu_si256((const __m256i*)buffer);
+        __m256i b = _mm256_loadu_si256((const __m256i*)(buffer + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(buffer + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(buffer + 96));
+        acc0 = _mm256_add_epi64(acc0, _mm256_add_epi64(_mm256_sad_epu8(a, zero), _mm256_sad_epu8(b, zero)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_add_epi64(_mm256_sad_epu8(c, zero), _mm256_sad_epu8(d, zero)));
+        buffer += 128;
+        len -= 128;
+    }
+    while(len >= 32){
+        acc0 = _mm256_add_epi64(acc0, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)buffer), zero));
+        buffer += 32;
+        len -= 32;
+    }
+    return horizontalSum256(_mm256_add_epi64(acc0, acc1)) + sum8Scalar(buffer, len);
+}
+
+__attribute__((target("avx2")))
+static void sum8BatchAVX2(const char* messages, const int32_t* lengths, int32_t count, uint8_t* sums){
+    const __m256i zero = _mm256_setzero_si256();
+    const char* end = messages;
+    for(int32_t i = 0; i < count; i++){
+        end += lengths[i];
+    }
+    for(int32_t i = 0; i < count; i++){
+        const char* p = messages;
+        size_t len = lengths[i];
+        __m256i acc = zero;
+        while(len >= 32){
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)p), zero));
+            p += 32;
+            len -= 32;
+        }
+        uint8_t tail = 0;
+        if(len && end - p >= 32){
+            __m256i block = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)p), _mm256_loadu_si256((const __m256i*)&sumMask[32 - len]));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(block, zero));
+        }
+        else{
+            tail = sum8Scalar(p, len);
+        }
+        sums[i] = horizontalSum256(acc) + tail;
+        messages += lengths[i];
+    }
+}
+#endif
+
+struct kernelTable{
+    kernelEnum kernel;
+    const char* name;
+    sumFunction sum;
+    batchFunction batch;
+};
+
+static kernelTable selected = { kernelEnum::Auto, nullptr, nullptr, nullptr };
+
+static bool selectKernel(kernelEnum kernel);
+
+static kernelTable& current(){
+    // A function local static is set up exactly once, even if the first calls come from several threads at once.
+    static bool autoSelected = selectKernel(kernelEnum::Auto);
+    (void)autoSelected;
+    return selected;
+}
+
+/**
+ * @brief      Chooses which implementation to use. Auto picks the fastest one the processor supports, which is what happens if this is never called. The others are mainly for benchmarking. Call it before any other threads start using the checksum functions.
+ *
+ * @param[in]  kernel  The kernel
+ *
+ * @return     False if the processor does not support the requested kernel, in which case nothing is changed.
+ */
+bool setKernel(kernelEnum kernel){
+    current(); // so that the automatic choice can't later replace this one
+    return selectKernel(kernel);
+}
+
+static bool selectKernel(kernelEnum kernel){
+#ifdef CHECKSUMSIMD_X86
+    __builtin_cpu_init();
+    bool hasSSE2 = __builtin_cpu_supports("sse2");
+    bool hasAVX2 = __builtin_cpu_supports("avx2");
+    if(kernel == kernelEnum::Auto){
+        kernel = hasAVX2 ? kernelEnum::AVX2 : (hasSSE2 ? kernelEnum::SSE2 : kernelEnum::Scalar);
+    }
+    if(kernel == kernelEnum::AVX2){
+        if(!hasAVX2){
+            return false;
+        }
+        selected = { kernel, "AVX2", sum8AVX2, sum8BatchAVX2 };
+        return true;
+    }
+    if(kernel == kernelEnum::SSE2){
+        if(!hasSSE2){
+            return false;
+        }
+        selected = { kernel, "SSE2", sum8SSE2, sum8BatchSSE2 };
+        return true;
+    }
+#else
+    if(kernel == kernelEnum::SSE2 || kernel == kernelEnum::AVX2){
+        return false;
+    }
+#endif
+    selected = { kernelEnum::Scalar, "Scalar", sum8Scalar, sum8BatchScalar };
+    return true;
+}
+
+/**
+ * @brief      Gets the kernel in use.
+ *
+ * @return     The kernel.
+ */
+kernelEnum getKernel(){
+    return current().kernel;
+}
+
+/**
+ * @brief      Gets the name of the kernel in use, for printing.
+ *
+ * @return     The kernel name.
+ */
+const char* getKernelName(){
+    return current().name;
+}
+
+/**
+ * @brief      Adds all of the chars in a buffer in to a byte, wrapping around at 256.
+ *
+ * @param[in]  buffer  The buffer
+ * @param[in]  len     The length of the buffer
+ *
+ * @return     The sum.
+ */
+uint8_t sum8(const char* buffer, size_t len){
+    return current().sum(buffer, len);
+}
+
+/**
+ * @brief      As sum8() but for many messages stored back to back, one sum per message. Short messages are read a whole vector at a time and masked, so the cost per message stays low.
+ *
+ * @param[in]  messages  The messages, back to back
+ * @param[in]  lengths   The length of each message
+ * @param[in]  count     The number of messages
+ * @param      sums      Filled with one sum per message
+ */
+void sum8Batch(const char* messages, const int32_t* lengths, int32_t count, uint8_t* sums){
+    current().batch(messages, lengths, count, sums);
+}
+
+/**
+ * @brief      Same result as SerialChecker::chksmSpellmanMPS().
+ */
+char chksmSpellmanMPS(const char* buffer, size_t len){
+    return SerialChecker::spellmanMPSFromSum(sum8(buffer, len));
+}
+
+/**
+ * @brief      Same result as SerialChecker::chksm8bitAllReadableChars().
+ */
+char chksm8bitAllReadableChars(const char* buffer, size_t len){
+    return SerialChecker::readable8bitCharsFromSum(sum8(buffer, len));
+}
+
+/**
+ * @brief      Spellman MPS checksum chars for many messages stored back to back. The checksums array is used to hold the sums on the way so no extra memory is needed.
+ */
+void chksmSpellmanMPSBatch(const char* messages, const int32_t* lengths, int32_t count, char* checksums){
+    sum8Batch(messages, lengths, count, (uint8_t*)checksums);
+    for(int32_t i = 0; i < count; i++){
+        checksums[i] = SerialChecker::spellmanMPSFromSum(checksums[i]);
+    }
+}
+
+/**
+ * @brief      Readable 8 bit checksum chars for many messages stored back to back. The checksums array is used to hold the sums on the way so no extra memory is needed.
+ */
+void chksm8bitAllReadableCharsBatch(const char* messages, const int32_t* lengths, int32_t count, char* checksums){
+    sum8Batch(messages, lengths, count, (uint8_t*)checksums);
+    for(int32_t i = 0; i < count; i++){
+        checksums[i] = SerialChecker::readable8bitCharsFromSum(checksums[i]);
+    }
+}
+
+}
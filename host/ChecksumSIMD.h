@@ -0,0 +1,32 @@
+#ifndef CHECKSUMSIMD_H
+#define CHECKSUMSIMD_H
+
+#include<stddef.h>
+#include<stdint.h>
+
+/**
+ * @brief      Vectorised versions of the SerialChecker checksums for checking large amounts of logged or replayed traffic on a PC.
+ *              Both checksum algorithms start by adding every char of the message in to a byte, so only that sum needs to be vectorised. It is done with SSE2 or AVX2 sum of absolute differences instructions where the processor has them and with a plain loop otherwise. The best version is picked the first time one of the functions is called. The results are identical to SerialChecker::chksmSpellmanMPS() and SerialChecker::chksm8bitAllReadableChars().
+ */
+namespace ChecksumSIMD{
+
+/**
+ * @brief      The implementations that can be chosen with setKernel().
+ */
+enum class kernelEnum{ Auto, Scalar, SSE2, AVX2 };
+
+bool setKernel(kernelEnum kernel);
+kernelEnum getKernel();
+const char* getKernelName();
+
+uint8_t sum8(const char* buffer, size_t len);
+void sum8Batch(const char* messages, const int32_t* lengths, int32_t count, uint8_t* sums);
+
+char chksmSpellmanMPS(const char* buffer, size_t len);
+char chksm8bitAllReadableChars(const char* buffer, size_t len);
+void chksmSpellmanMPSBatch(const char* messages, const int32_t* lengths, int32_t count, char* checksums);
+void chksm8bitAllReadableCharsBatch(const char* messages, const int32_t* lengths, int32_t count, char* checksums);
+
+}
+
+#endif
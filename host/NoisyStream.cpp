@@ -0,0 +1,142 @@
+#include "NoisyStream.h"
+
+#include<stdio.h>
+
+NoisyStream::NoisyStream(const NoisyStreamSettings& settings, uint32_t seed){
+    this->settings = settings;
+    this->seed = seed ? seed : 1; // xorshift gets stuck at zero
+}
+
+/**
+ * @brief      Appends frames to a stream, damaging some of them.
+ *
+ * @param[in]  frames  The number of frames
+ * @param      stream  The stream to add to
+ */
+void NoisyStream::generate(uint32_t frames, std::vector<char>& stream){
+    const char fill[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    std::vector<char> frame;
+    for(uint32_t n = 0; n < frames; n++){
+        char payload[256];
+        snprintf(payload, sizeof(payload), "%06X", (unsigned)(payloads.size() & 0xFFFFFF));
+        uint8_t len = settings.minPayload + random(settings.maxPayload - settings.minPayload + 1);
+        for(uint8_t i = 6; i < len; i++){
+            payload[i] = fill[random(sizeof(fill) - 1)];
+        }
+        payload[len < 6 ? 6 : len] = '\0';
+        payloads.push_back(payload);
+
+        frame.clear();
+        if(settings.useSTX){
+            frame.push_back(settings.STX);
+        }
+        frame.insert(frame.end(), payload, payload + payloads.back().size());
+        if(settings.useChecksum){
+            const std::string& p = payloads.back();
+            frame.push_back(settings.checksumType == checksumTypeEnum::SpellmanMPS ? SerialChecker::chksmSpellmanMPS(p.data(), p.size()) : SerialChecker::chksm8bitAllReadableChars(p.data(), p.size()));
+        }
+        frame.push_back(settings.ETX);
+
+        noiseEnum noise = pickNoise();
+        noiseCounts[(int)noise]++;
+        noises.push_back(noise);
+        switch(noise){
+            case noiseEnum::BitFlip:
+                frame[random(frame.size())] ^= 1 << random(8);
+                break;
+            case noiseEnum::DroppedByte:
+                frame.erase(frame.begin() + random(frame.size()));
+                break;
+            case noiseEnum::MissingETX:
+                frame.pop_back();
+                break;
+            case noiseEnum::SpuriousSTX:
+                frame.insert(frame.begin() + 1 + random(frame.size() - 1), settings.STX);
+                break;
+            case noiseEnum::CRLF:
+                // \r\n line endings from a terminal or a Windows program. check() drops the \r unless setAllowCR() is used, so these frames should still get through.
+                frame.insert(frame.end() - 1, '\r');
+                break;
+            case noiseEnum::OverLength:
+                // a run of chatter with no ETX, for example a device that was left streaming in a different format
+                for(uint8_t i = 0; i < settings.overLength; i++){
+                    stream.push_back(fill[random(sizeof(fill) - 1)]);
+                }
+                break;
+            default:
+                break;
+        }
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+}
+
+/**
+ * @brief      Gets the payloads of every frame generated so far, damaged or not, in order.
+ *
+ * @return     The payloads.
+ */
+const std::vector<std::string>& NoisyStream::getPayloads(){
+    return payloads;
+}
+
+/**
+ * @brief      Gets the kind of damage done to a frame.
+ *
+ * @param[in]  frame  The frame number, counting from 0
+ *
+ * @return     The damage.
+ */
+noiseEnum NoisyStream::getNoise(uint32_t frame){
+    return noises[frame];
+}
+
+/**
+ * @brief      Gets the number of frames that had a kind of damage.
+ *
+ * @param[in]  noise  The kind of damage, or noiseEnum::None for the number of undamaged frames
+ *
+ * @return     The count.
+ */
+uint32_t NoisyStream::getNoiseCount(noiseEnum noise){
+    return noiseCounts[(int)noise];
+}
+
+const char* NoisyStream::noiseName(noiseEnum noise){
+    switch(noise){
+        case noiseEnum::None: return "none";
+        case noiseEnum::BitFlip: return "bit flip";
+        case noiseEnum::DroppedByte: return "dropped byte";
+        case noiseEnum::MissingETX: return "missing ETX";
+        case noiseEnum::SpuriousSTX: return "spurious STX";
+        case noiseEnum::CRLF: return "CR LF";
+        case noiseEnum::OverLength: return "over length";
+        default: return "?";
+    }
+}
+
+// xorshift32, so the stream is the same on every platform
+uint32_t NoisyStream::random(){
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+uint32_t NoisyStream::random(uint32_t n){
+    return n ? random() % n : 0;
+}
+
+float NoisyStream::randomFloat(){
+    return (random() >> 8) / 16777216.0f;
+}
+
+noiseEnum NoisyStream::pickNoise(){
+    float r = randomFloat();
+    for(int i = 1; i < (int)noiseEnum::Count; i++){
+        if(r < settings.chance[i]){
+            return (noiseEnum)i;
+        }
+        r -= settings.chance[i];
+    }
+    return noiseEnum::None;
+}
@@ -0,0 +1,53 @@
+#ifndef NOISYSTREAM_H
+#define NOISYSTREAM_H
+
+#include "SerialChecker.h"
+
+#include<string>
+#include<vector>
+
+/**
+ * @brief      The kinds of damage NoisyStream can do to a frame.
+ */
+enum class noiseEnum{ None, BitFlip, DroppedByte, MissingETX, SpuriousSTX, CRLF, OverLength, Count };
+
+/**
+ * @brief      How frames are sent and how likely each kind of damage is. The chances are per frame and a frame gets at most one kind of damage. The defaults damage about a quarter of the frames.
+ */
+struct NoisyStreamSettings{
+    bool useSTX = true;
+    char STX = '$';
+    char ETX = '\n';
+    bool useChecksum = true;
+    checksumTypeEnum checksumType = checksumTypeEnum::Readable8bitChars;
+    uint8_t minPayload = 6; // every payload starts with a 6 hex digit frame number so that it can be told apart from the others
+    uint8_t maxPayload = 12;
+    uint8_t overLength = 24; // length of the garbage runs with no ETX
+    float chance[(int)noiseEnum::Count] = { 0.0f, 0.05f, 0.05f, 0.03f, 0.03f, 0.05f, 0.03f };
+};
+
+/**
+ * @brief      Generates a repeatable stream of frames with noise mixed in, to measure how well SerialChecker resyncs. The same seed always gives the same stream so results can be compared between builds. The payload of every frame is kept so that the messages the checker accepts can be sorted in to frames it got right and damaged frames it wrongly accepted.
+ */
+class NoisyStream{
+public:
+    NoisyStream(const NoisyStreamSettings& settings, uint32_t seed);
+    void generate(uint32_t frames, std::vector<char>& stream);
+    const std::vector<std::string>& getPayloads();
+    noiseEnum getNoise(uint32_t frame);
+    uint32_t getNoiseCount(noiseEnum noise);
+    static const char* noiseName(noiseEnum noise);
+private:
+    NoisyStreamSettings settings;
+    uint32_t seed;
+    std::vector<std::string> payloads;
+    std::vector<noiseEnum> noises;
+    uint32_t noiseCounts[(int)noiseEnum::Count] = {};
+
+    uint32_t random();
+    uint32_t random(uint32_t n);
+    float randomFloat();
+    noiseEnum pickNoise();
+};
+
+#endif
@@ -0,0 +1,284 @@
+#include "SerialCheckerBusMaster.h"
+
+#include<string.h>
+
+/**
+ * @brief      Constructs the bus master.
+ *
+ * @param      checker  The checker for the bus, set up with the framing, checksum and address length the nodes use. Replies must start with the address of the node that sends them.
+ * @param      port     The checker's port, used to wait for replies
+ * @param[in]  handler  The function called for every reply
+ * @param      context  Passed on to the handler
+ */
+SerialCheckerBusMaster::SerialCheckerBusMaster(SerialChecker& checker, PosixSerial& port, busMasterHandler handler, void* context){
+    this->checker = &checker;
+    this->port = &port;
+    this->handler = handler;
+    this->context = context;
+}
+
+/**
+ * @brief      Adds a node to poll. Nodes with a higher priority are polled first whenever several are due. A node that needs polling as often as possible can be given an interval of 0, but then lower priority nodes only get the line while it is waited for.
+ *
+ * @param      address         The node's address, checker.getAddressLen() chars long
+ * @param      pollMessage     The message sent to the node, without the address
+ * @param[in]  intervalMicros  How often to poll the node
+ * @param[in]  priority        The priority
+ *
+ * @return     The node number used by getStats() and passed to the handler, or -1 if the poll message is too long.
+ */
+int SerialCheckerBusMaster::addNode(char* address, char* pollMessage, uint32_t intervalMicros, uint8_t priority){
+    uint8_t addressLen = checker->getAddressLen();
+    if(addressLen + strlen(pollMessage) > SERIALCHECKERBUSMASTER_POLL_LEN){
+        return -1;
+    }
+    Node node = {};
+    memcpy(node.pollMessage, address, addressLen);
+    strcpy(&node.pollMessage[addressLen], pollMessage);
+    node.intervalMicros = intervalMicros;
+    node.priority = priority;
+    node.nextDue = micros();
+    node.stats.timeoutMicros = maxTimeout;
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+uint16_t SerialCheckerBusMaster::getNodeCount(){
+    return nodes.size();
+}
+
+/**
+ * @brief      Sets the range the per node timeouts are kept in. A node is waited for maxMicros until its first reply. Setting both to the same value gives every node that fixed timeout. The defaults are 2 ms and 50 ms.
+ *
+ * @param[in]  minMicros  The shortest timeout
+ * @param[in]  maxMicros  The longest timeout
+ */
+void SerialCheckerBusMaster::setTimeoutLimits(uint32_t minMicros, uint32_t maxMicros){
+    minTimeout = minMicros;
+    maxTimeout = maxMicros;
+    for(Node& node : nodes){
+        node.stats.timeoutMicros = timeoutFor(node);
+    }
+}
+
+/**
+ * @brief      Sets when a node counts as dead and how far its polls are spread out. The defaults are 3 misses and 1 s.
+ *
+ * @param[in]  misses             The number of timeouts in a row that make a node dead. 0 never marks nodes dead.
+ * @param[in]  maxIntervalMicros  The longest interval a dead node's polls are spread out to
+ */
+void SerialCheckerBusMaster::setDeadAfter(uint8_t misses, uint32_t maxIntervalMicros){
+    deadAfter = misses;
+    maxDeadInterval = maxIntervalMicros;
+}
+
+/**
+ * @brief      Makes a node due straight away, for example from the handler when a node's reply says it has more to send.
+ *
+ * @param[in]  node  The node
+ */
+void SerialCheckerBusMaster::pollSoon(uint16_t node){
+    nodes[node].nextDue = micros();
+}
+
+/**
+ * @brief      Does the next step of the polling: sends a poll if the line is free and a node is due, waits for up to maxWaitMs for a reply, hands any reply to the handler and deals with a timeout. A reply that arrives after its timeout is still handed to the handler, as long as no other poll has timed out since. Call it in a loop.
+ *
+ * @param[in]  maxWaitMs  The longest time to wait
+ */
+void SerialCheckerBusMaster::update(int maxWaitMs){
+    uint32_t now = micros();
+    if(waiting < 0){
+        int32_t next = pickNode(now);
+        if(next >= 0){
+            poll(next, now);
+        }
+    }
+    // Sleep until the reply arrives, the reply is late or the next node is due.
+    int32_t waitMicros = maxWaitMs * 1000;
+    if(waiting >= 0){
+        int32_t left = (int32_t)(sentMicros + nodes[waiting].stats.timeoutMicros - now);
+        waitMicros = left < waitMicros ? left : waitMicros;
+    }
+    else{
+        for(Node& node : nodes){
+            int32_t left = (int32_t)(node.nextDue - now);
+            waitMicros = left < waitMicros ? left : waitMicros;
+        }
+    }
+    if(waitMicros > 0){
+        port->waitReadable(waitMicros / 1000);
+    }
+    while(checker->check()){
+        now = micros();
+        if(waiting >= 0 && memcmp(checker->getRawMsg(), nodes[waiting].pollMessage, checker->getAddressLen()) == 0){
+            replied(now);
+        }
+        else if(late >= 0 && memcmp(checker->getRawMsg(), nodes[late].pollMessage, checker->getAddressLen()) == 0){
+            repliedLate(now);
+        }
+        else{
+            strays++;
+        }
+    }
+    now = micros();
+    if(waiting >= 0 && now - sentMicros >= nodes[waiting].stats.timeoutMicros){
+        timedOut(now);
+    }
+}
+
+/**
+ * @brief      Gets a node's counters and timings.
+ *
+ * @param[in]  node  The node
+ *
+ * @return     The stats.
+ */
+BusNodeStats SerialCheckerBusMaster::getStats(uint16_t node){
+    return nodes[node].stats;
+}
+
+/**
+ * @brief      Gets the number of messages that arrived from a node no reply was expected from, which are thrown away. Only the reply to the latest poll that timed out is still taken, so these are replies that came very late, or replies from two nodes with the same address.
+ *
+ * @return     The count.
+ */
+uint64_t SerialCheckerBusMaster::getStrayCount(){
+    return strays;
+}
+
+/**
+ * @brief      Gets the total time spent on polls that were answered, from sending the poll to receiving the reply.
+ *
+ * @return     The time in us.
+ */
+uint64_t SerialCheckerBusMaster::getReplyMicros(){
+    return replyMicros;
+}
+
+/**
+ * @brief      Gets the total time the line sat idle waiting for replies that never came.
+ *
+ * @return     The time in us.
+ */
+uint64_t SerialCheckerBusMaster::getTimeoutMicros(){
+    return timeoutMicros;
+}
+
+/**
+ * @brief      Chooses the node to poll next: the highest priority node that is due and, of those, the one that has been due the longest.
+ *
+ * @return     The node, or -1 if none are due.
+ */
+int32_t SerialCheckerBusMaster::pickNode(uint32_t now){
+    int32_t best = -1;
+    for(uint16_t i = 0; i < nodes.size(); i++){
+        Node& node = nodes[i];
+        if((int32_t)(now - node.nextDue) < 0){
+            continue;
+        }
+        if(best < 0 || node.priority > nodes[best].priority || (node.priority == nodes[best].priority && (int32_t)(node.nextDue - nodes[best].nextDue) < 0)){
+            best = i;
+        }
+    }
+    return best;
+}
+
+void SerialCheckerBusMaster::poll(uint16_t node, uint32_t now){
+    Node& n = nodes[node];
+    checker->sendFrame(n.pollMessage);
+    waiting = node;
+    sentMicros = now;
+    n.stats.polls++;
+    uint32_t interval = n.backoff ? deadInterval(n) : n.intervalMicros;
+    // Keep to the poll rate, but a node that fell well behind is not polled in a burst to catch up.
+    n.nextDue += interval;
+    if((int32_t)(now - n.nextDue) > 0){
+        n.nextDue = now;
+    }
+}
+
+void SerialCheckerBusMaster::replied(uint32_t now){
+    uint32_t rtt = now - sentMicros;
+    measured(nodes[waiting], rtt);
+    nodes[waiting].stats.replies++;
+    replyMicros += rtt;
+    uint16_t replyNode = waiting;
+    waiting = -1;
+    handler(*this, replyNode, *checker, context);
+}
+
+/**
+ * @brief      A reply after its timeout still shows how long the node takes. Leaving it out would only ever measure the quick replies, and the timeout would stay too short.
+ */
+void SerialCheckerBusMaster::repliedLate(uint32_t now){
+    uint16_t replyNode = late;
+    measured(nodes[late], now - lateSentMicros);
+    nodes[late].stats.lateReplies++;
+    late = -1;
+    handler(*this, replyNode, *checker, context);
+}
+
+/**
+ * @brief      Updates a node's smoothed response time and deviation the way TCP does, and its timeout.
+ */
+void SerialCheckerBusMaster::measured(Node& node, uint32_t rtt){
+    if(node.stats.replies + node.stats.lateReplies == 0){
+        node.srtt = rtt << 3;
+        node.rttvar = rtt << 1;
+    }
+    else{
+        int32_t error = rtt - (node.srtt >> 3);
+        node.srtt += error;
+        node.rttvar += (error < 0 ? -error : error) - (int32_t)(node.rttvar >> 2);
+    }
+    node.stats.responseMicros = node.srtt >> 3;
+    node.misses = 0;
+    node.backoff = 0;
+    node.stats.dead = false;
+    node.stats.timeoutMicros = timeoutFor(node);
+}
+
+void SerialCheckerBusMaster::timedOut(uint32_t now){
+    Node& node = nodes[waiting];
+    node.stats.timeouts++;
+    timeoutMicros += now - sentMicros;
+    if(node.misses < 255){
+        node.misses++;
+    }
+    node.stats.timeoutMicros = timeoutFor(node);
+    if(deadAfter && node.misses >= deadAfter){
+        node.stats.dead = true;
+        if(deadInterval(node) < maxDeadInterval){
+            node.backoff++;
+        }
+    }
+    late = waiting;
+    lateSentMicros = sentMicros;
+    waiting = -1;
+}
+
+/**
+ * @brief      A dead node's poll interval, doubled for each backoff step up to the limit. Nodes polled as often as possible start from the minimum timeout instead.
+ */
+uint32_t SerialCheckerBusMaster::deadInterval(const Node& node){
+    uint64_t interval = (uint64_t)(node.intervalMicros ? node.intervalMicros : minTimeout) << node.backoff;
+    return interval < maxDeadInterval ? interval : maxDeadInterval;
+}
+
+/**
+ * @brief      The smoothed response time plus four times its deviation, doubled for each reply missed in a row, as TCP does, kept within the timeout limits.
+ */
+uint32_t SerialCheckerBusMaster::timeoutFor(const Node& node){
+    if(node.stats.replies + node.stats.lateReplies == 0){
+        return maxTimeout;
+    }
+    uint32_t timeout = (node.srtt >> 3) + node.rttvar;
+    for(uint8_t i = 0; i < node.misses && timeout < maxTimeout; i++){
+        timeout <<= 1; // the reply may just have been slow, so wait longer next time
+    }
+    if(timeout < minTimeout){
+        return minTimeout;
+    }
+    return timeout > maxTimeout ? maxTimeout : timeout;
+}
@@ -0,0 +1,90 @@
+#ifndef SERIALCHECKERBUSMASTER_H
+#define SERIALCHECKERBUSMASTER_H
+
+#include "SerialChecker.h"
+
+#include<vector>
+
+/**
+ * @brief      Longest poll message, including the address, that the bus master keeps for each node.
+ */
+#ifndef SERIALCHECKERBUSMASTER_POLL_LEN
+#define SERIALCHECKERBUSMASTER_POLL_LEN 32
+#endif
+
+/**
+ * @brief      Per node counters and timings. The response times are smoothed the same way TCP smooths round trip times.
+ */
+struct BusNodeStats{
+    uint64_t polls;
+    uint64_t replies;
+    uint64_t timeouts;
+    uint64_t lateReplies; // replies that came after their timeout, also counted in timeouts
+    uint32_t responseMicros; // smoothed time from sending the poll to the reply arriving
+    uint32_t timeoutMicros; // how long the master waits for this node's reply at the moment
+    bool dead;
+};
+
+class SerialCheckerBusMaster;
+
+/**
+ * @brief      Called for every reply. checker has the reply loaded, so contains(), toFloat() etc can be used on it.
+ */
+typedef void (*busMasterHandler)(SerialCheckerBusMaster& master, uint16_t node, SerialChecker& checker, void* context);
+
+/**
+ * @brief      SerialCheckerBusMaster polls many addressed nodes that share one line, such as arduinos on an RS-485 bus. Only one node may talk at a time, so each transaction is a poll followed by a wait for that node's reply. Rather than polling the nodes in turn with one fixed timeout, each node has its own poll interval and priority, and the next poll goes out as soon as the line is free: to the highest priority node that is due, and of those to the one that has waited longest.
+ *              Each node's timeout is worked out from its measured response times, so a quick node that misses a reply costs little line time. A node that misses several replies in a row is marked dead and polled less and less often, doubling its interval each time up to a limit, until it replies again.
+ */
+class SerialCheckerBusMaster{
+public:
+    SerialCheckerBusMaster(SerialChecker& checker, PosixSerial& port, busMasterHandler handler, void* context);
+    int addNode(char* address, char* pollMessage, uint32_t intervalMicros, uint8_t priority);
+    uint16_t getNodeCount();
+    void setTimeoutLimits(uint32_t minMicros, uint32_t maxMicros);
+    void setDeadAfter(uint8_t misses, uint32_t maxIntervalMicros);
+    void pollSoon(uint16_t node);
+    void update(int maxWaitMs);
+    BusNodeStats getStats(uint16_t node);
+    uint64_t getStrayCount();
+    uint64_t getReplyMicros();
+    uint64_t getTimeoutMicros();
+private:
+    struct Node{
+        char pollMessage[SERIALCHECKERBUSMASTER_POLL_LEN + 1];
+        uint32_t intervalMicros;
+        uint8_t priority;
+        uint32_t nextDue;
+        uint32_t srtt; // smoothed response time in us times 8
+        uint32_t rttvar; // smoothed deviation in us times 4
+        uint8_t misses;
+        uint8_t backoff; // the interval is doubled this many times while the node is dead
+        BusNodeStats stats;
+    };
+    SerialChecker* checker;
+    PosixSerial* port;
+    busMasterHandler handler;
+    void* context;
+    std::vector<Node> nodes;
+    uint32_t minTimeout = 2000;
+    uint32_t maxTimeout = 50000;
+    uint8_t deadAfter = 3;
+    uint32_t maxDeadInterval = 1000000;
+    int32_t waiting = -1; // node whose reply is awaited, -1 when the line is free
+    uint32_t sentMicros = 0;
+    int32_t late = -1; // the node that last timed out, whose reply may still come
+    uint32_t lateSentMicros = 0;
+    uint64_t replyMicros = 0;
+    uint64_t timeoutMicros = 0;
+    uint64_t strays = 0;
+    int32_t pickNode(uint32_t now);
+    void poll(uint16_t node, uint32_t now);
+    void replied(uint32_t now);
+    void repliedLate(uint32_t now);
+    void measured(Node& node, uint32_t rtt);
+    void timedOut(uint32_t now);
+    uint32_t deadInterval(const Node& node);
+    uint32_t timeoutFor(const Node& node);
+};
+
+#endif
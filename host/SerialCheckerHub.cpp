@@ -0,0 +1,298 @@
+#include "SerialCheckerHub.h"
+
+#include<sys/epoll.h>
+#include<unistd.h>
+
+/**
+ * @brief      Constructs the hub. The worker threads are started by run().
+ *
+ * @param[in]  workers  The number of worker threads. 0 uses one per core.
+ * @param[in]  handler  The function called for every message
+ * @param      context  Passed on to the handler
+ */
+SerialCheckerHub::SerialCheckerHub(unsigned workers, hubHandler handler, void* context){
+    if(workers == 0){
+        workers = std::thread::hardware_concurrency();
+        if(workers == 0){
+            workers = 1;
+        }
+    }
+    for(unsigned i = 0; i < workers; i++){
+        this->workers.push_back(new Worker());
+    }
+    this->handler = handler;
+    this->context = context;
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    running = false;
+    pending = 0;
+    sleepers = 0;
+}
+
+/**
+ * @brief      Destroys the object. The ports themselves are left open.
+ */
+SerialCheckerHub::~SerialCheckerHub(){
+    for(Device* device : devices){
+        delete device->checker;
+        delete device;
+    }
+    for(Worker* worker : workers){
+        delete worker;
+    }
+    close(epollFd);
+}
+
+/**
+ * @brief      Adds a serial port to the hub and calls init() on its checker at the default baudrate of 250000.
+ *
+ * @param      port  The port. It must stay alive for as long as the hub.
+ *
+ * @return     The device number used by getChecker(), send() and getStats(), or -1 if the port could not be watched.
+ */
+int SerialCheckerHub::addDevice(PosixSerial& port){
+    return addDevice(port, 250000);
+}
+
+/**
+ * @brief      As above but lets user choose the baudrate.
+ *
+ * @param      port      The port. It must stay alive for as long as the hub.
+ * @param[in]  baudrate  The baudrate
+ *
+ * @return     The device number used by getChecker(), send() and getStats(), or -1 if the port could not be watched.
+ */
+int SerialCheckerHub::addDevice(PosixSerial& port, uint32_t baudrate){
+    Device* device = new Device();
+    device->port = &port;
+    device->checker = new SerialChecker(port, baudrate);
+    device->checker->init();
+    if(addressLen){
+        device->checker->setAddressLen(addressLen);
+    }
+    device->frames = 0;
+    device->bytes = 0;
+    device->latencySumMicros = 0;
+    device->latencyMaxMicros = 0;
+    device->tooLong = 0;
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u32 = devices.size();
+    if(epoll_ctl(epollFd, EPOLL_CTL_ADD, port.getFd(), &event) < 0){
+        delete device->checker;
+        delete device;
+        return -1;
+    }
+    devices.push_back(device);
+    return devices.size() - 1;
+}
+
+/**
+ * @brief      Gets the number of devices.
+ *
+ * @return     The device count.
+ */
+uint16_t SerialCheckerHub::getDeviceCount(){
+    return devices.size();
+}
+
+/**
+ * @brief      Gets the checker for a device so that checksums, STX, Ack/Nak etc can be set up. Do this before run(), as afterwards the epoll thread is using it. Acks, Naks and sequence numbers are safe to use, as run() holds the device's lock around check() and send() takes the same lock.
+ *
+ * @param[in]  device  The device number
+ *
+ * @return     The checker.
+ */
+SerialChecker& SerialCheckerHub::getChecker(uint16_t device){
+    return *devices[device]->checker;
+}
+
+/**
+ * @brief      Sets the address length used by every device and by the parsers handed to the handler. See SerialChecker::setAddressLen().
+ *
+ * @param[in]  len   The address length
+ */
+void SerialCheckerHub::setAddressLen(uint8_t len){
+    addressLen = len;
+    for(Device* device : devices){
+        device->checker->setAddressLen(len);
+    }
+}
+
+/**
+ * @brief      Sends a message to a device with SerialChecker::sendFrame(). Safe to call from the handler: the device's lock keeps it from running at the same time as another send() or as the epoll thread's check(), which sends Naks and batched Acks and keeps the sequence number state that sendFrame() uses.
+ *
+ * @param[in]  device   The device number
+ * @param      message  The message
+ */
+void SerialCheckerHub::send(uint16_t device, char* message){
+    std::lock_guard<std::mutex> lock(devices[device]->mutex);
+    devices[device]->checker->sendFrame(message);
+}
+
+/**
+ * @brief      Starts the workers and then waits for messages on all of the devices until stop() is called. Messages still queued when stop() is called are handled before this returns.
+ */
+void SerialCheckerHub::run(){
+    running = true;
+    for(unsigned i = 0; i < workers.size(); i++){
+        workers[i]->thread = std::thread(&SerialCheckerHub::workerLoop, this, i);
+    }
+    const int maxEvents = 64;
+    struct epoll_event events[maxEvents];
+    while(running){
+        int n = epoll_wait(epollFd, events, maxEvents, 100);
+        for(int i = 0; i < n; i++){
+            uint16_t d = events[i].data.u32;
+            Device* device = devices[d];
+            while(true){
+                HubFrame frame;
+                {
+                    std::lock_guard<std::mutex> lock(device->mutex);
+                    uint8_t len = device->checker->check();
+                    if(!len){
+                        break;
+                    }
+                    if(len >= SERIALCHECKERHUB_FRAME_LEN){
+                        // A worker would only see part of it, so it is dropped rather than handled as if it were whole.
+                        device->tooLong++;
+                        continue;
+                    }
+                    frame.device = d;
+                    frame.receivedMicros = micros();
+                    frame.len = len;
+                    memcpy(frame.rawMsg, device->checker->getRawMsg(), len);
+                    frame.rawMsg[len] = '\0';
+                }
+                dispatch(frame);
+            }
+            if(events[i].events & (EPOLLHUP | EPOLLERR)){
+                // The other end has gone away. Stop watching it so that epoll does not keep reporting it.
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, device->port->getFd(), nullptr);
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idle.notify_all();
+    }
+    for(Worker* worker : workers){
+        worker->thread.join();
+    }
+}
+
+/**
+ * @brief      Makes run() return. Can be called from any thread, including from the handler.
+ */
+void SerialCheckerHub::stop(){
+    running = false;
+}
+
+/**
+ * @brief      Gets the counters for a device.
+ *
+ * @param[in]  device  The device number
+ *
+ * @return     The stats.
+ */
+HubDeviceStats SerialCheckerHub::getStats(uint16_t device){
+    HubDeviceStats stats;
+    stats.frames = devices[device]->frames;
+    stats.bytes = devices[device]->bytes;
+    stats.latencySumMicros = devices[device]->latencySumMicros;
+    stats.latencyMaxMicros = devices[device]->latencyMaxMicros;
+    stats.tooLong = devices[device]->tooLong;
+    return stats;
+}
+
+/**
+ * @brief      Gets the number of messages handled across all devices.
+ *
+ * @return     The total frames.
+ */
+uint64_t SerialCheckerHub::getTotalFrames(){
+    uint64_t total = 0;
+    for(Device* device : devices){
+        total += device->frames;
+    }
+    return total;
+}
+
+/**
+ * @brief      Deals a message to the next worker's queue and wakes a worker if any are asleep.
+ */
+void SerialCheckerHub::dispatch(const HubFrame& frame){
+    Worker* worker = workers[nextWorker];
+    nextWorker = (nextWorker + 1) % workers.size();
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->queue.push_back(frame);
+    }
+    pending++;
+    if(sleepers){
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idle.notify_one();
+    }
+}
+
+/**
+ * @brief      Takes the oldest message from the worker's own queue or, if that is empty, the newest message from another worker's queue.
+ *
+ * @return     True if a message was taken.
+ */
+bool SerialCheckerHub::takeFrame(unsigned self, HubFrame& frame){
+    {
+        Worker* worker = workers[self];
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        if(!worker->queue.empty()){
+            frame = worker->queue.front();
+            worker->queue.pop_front();
+            pending--;
+            return true;
+        }
+    }
+    for(unsigned i = 1; i < workers.size(); i++){
+        Worker* victim = workers[(self + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if(!victim->queue.empty()){
+            frame = victim->queue.back();
+            victim->queue.pop_back();
+            pending--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SerialCheckerHub::workerLoop(unsigned self){
+    SerialChecker parser(SERIALCHECKERHUB_FRAME_LEN);
+    if(addressLen){
+        parser.setAddressLen(addressLen);
+    }
+    HubFrame frame;
+    while(true){
+        if(takeFrame(self, frame)){
+            parser.loadMsg(frame.rawMsg, frame.len);
+            handler(*this, frame, parser, context);
+            record(frame);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idleMutex);
+        if(!running && pending == 0){
+            break;
+        }
+        sleepers++;
+        idle.wait(lock, [this]{ return pending > 0 || !running; });
+        sleepers--;
+    }
+}
+
+void SerialCheckerHub::record(const HubFrame& frame){
+    Device* device = devices[frame.device];
+    uint32_t latency = micros() - frame.receivedMicros;
+    device->frames++;
+    device->bytes += frame.len;
+    device->latencySumMicros += latency;
+    uint32_t max = device->latencyMaxMicros;
+    while(latency > max && !device->latencyMaxMicros.compare_exchange_weak(max, latency)){
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef SERIALCHECKERHUB_H
+#define SERIALCHECKERHUB_H
+
+#include "SerialChecker.h"
+
+#include<atomic>
+#include<condition_variable>
+#include<deque>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+/**
+ * @brief      Room for a message, including the address and a null terminator, that the hub passes to the workers. Messages of this length or longer are dropped and counted in HubDeviceStats::tooLong.
+ */
+#ifndef SERIALCHECKERHUB_FRAME_LEN
+#define SERIALCHECKERHUB_FRAME_LEN 64
+#endif
+
+/**
+ * @brief      A complete, checked message from one device, queued for a worker.
+ */
+struct HubFrame{
+    uint16_t device;
+    uint8_t len;
+    uint32_t receivedMicros; // micros() when check() returned the message
+    char rawMsg[SERIALCHECKERHUB_FRAME_LEN];
+};
+
+/**
+ * @brief      Per device counters. Latency is measured from check() returning the message to the handler returning.
+ */
+struct HubDeviceStats{
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t latencySumMicros;
+    uint32_t latencyMaxMicros;
+    uint64_t tooLong; // messages dropped as they didn't fit in a HubFrame
+};
+
+class SerialCheckerHub;
+
+/**
+ * @brief      Called on a worker thread for every message. parser has the message loaded, see SerialChecker::loadMsg(), so contains(), toFloat() etc can be used on it. Messages from the same device can be handled by different workers at the same time, so handlers must not rely on the order of messages from one device.
+ */
+typedef void (*hubHandler)(SerialCheckerHub& hub, const HubFrame& frame, SerialChecker& parser, void* context);
+
+/**
+ * @brief      SerialCheckerHub looks after many serial devices from one PC. A single thread waits on all of the ports with epoll and splits the incoming bytes in to messages with one SerialChecker per device. Complete messages go to a pool of worker threads which call the handler.
+ *              Each worker has its own queue. The epoll thread deals new messages out to the queues in turn and a worker with nothing to do takes messages from the back of another worker's queue, so one slow handler does not hold up the rest.
+ */
+class SerialCheckerHub{
+public:
+    SerialCheckerHub(unsigned workers, hubHandler handler, void* context);
+    ~SerialCheckerHub();
+    int addDevice(PosixSerial& port);
+    int addDevice(PosixSerial& port, uint32_t baudrate);
+    uint16_t getDeviceCount();
+    SerialChecker& getChecker(uint16_t device);
+    void setAddressLen(uint8_t len);
+    void send(uint16_t device, char* message);
+    void run();
+    void stop();
+    HubDeviceStats getStats(uint16_t device);
+    uint64_t getTotalFrames();
+private:
+    struct Device{
+        PosixSerial* port;
+        SerialChecker* checker;
+        std::mutex mutex; // around the checker, which check() on the epoll thread and send() on the workers both use
+        std::atomic<uint64_t> frames;
+        std::atomic<uint64_t> bytes;
+        std::atomic<uint64_t> latencySumMicros;
+        std::atomic<uint32_t> latencyMaxMicros;
+        std::atomic<uint64_t> tooLong;
+    };
+    struct Worker{
+        std::mutex mutex;
+        std::deque<HubFrame> queue;
+        std::thread thread;
+    };
+
+    hubHandler handler;
+    void* context;
+    uint8_t addressLen = 0;
+    int epollFd;
+    std::atomic<bool> running;
+    std::vector<Device*> devices;
+    std::vector<Worker*> workers;
+    unsigned nextWorker = 0;
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    std::atomic<uint32_t> pending; // messages queued but not yet taken by a worker
+    std::atomic<uint32_t> sleepers; // workers waiting on idle
+
+    void dispatch(const HubFrame& frame);
+    bool takeFrame(unsigned self, HubFrame& frame);
+    void workerLoop(unsigned self);
+    void record(const HubFrame& frame);
+};
+
+#endif
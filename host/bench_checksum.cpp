@@ -0,0 +1,78 @@
+/**
+ * @brief      Benchmarks the ChecksumSIMD kernels against each other and against the firmware's SerialChecker::chksm8bitAllReadableChars() and checks that every kernel gives exactly the same checksums.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../PosixSerial.cpp ChecksumSIMD.cpp bench_checksum.cpp -o bench_checksum
+ *
+ *              Usage: bench_checksum [buffer MB] [short messages]
+ */
+#include "SerialChecker.h"
+#include "ChecksumSIMD.h"
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<vector>
+
+static double seconds(){
+    return micros() / 1e6;
+}
+
+int main(int argc, char** argv){
+    size_t bufferLen = (argc > 1 ? atoi(argv[1]) : 256) * 1024UL * 1024UL;
+    int32_t messageCount = argc > 2 ? atoi(argv[2]) : 4000000;
+
+    // Random bytes for the long buffer and random readable messages of 4 to 24 chars for the batch.
+    std::vector<char> buffer(bufferLen);
+    uint32_t seed = 12345;
+    for(size_t i = 0; i < bufferLen; i++){
+        seed = seed * 1664525 + 1013904223;
+        buffer[i] = seed >> 24;
+    }
+    std::vector<int32_t> lengths(messageCount);
+    std::vector<char> messages;
+    for(int32_t i = 0; i < messageCount; i++){
+        seed = seed * 1664525 + 1013904223;
+        lengths[i] = 4 + (seed >> 16) % 21;
+        for(int32_t j = 0; j < lengths[i]; j++){
+            seed = seed * 1664525 + 1013904223;
+            messages.push_back(33 + (seed >> 16) % 94);
+        }
+    }
+
+    // The firmware function is the reference.
+    double start = seconds();
+    char reference = SerialChecker::chksm8bitAllReadableChars(buffer.data(), bufferLen);
+    double firmwareTime = seconds() - start;
+    std::vector<char> referenceBatch(messageCount);
+    const char* p = messages.data();
+    start = seconds();
+    for(int32_t i = 0; i < messageCount; i++){
+        referenceBatch[i] = SerialChecker::chksm8bitAllReadableChars(p, lengths[i]);
+        p += lengths[i];
+    }
+    double firmwareBatchTime = seconds() - start;
+    printf("%-8s %8.2f GB/s %8.1f M messages/s\n", "firmware", bufferLen / firmwareTime / 1e9, messageCount / firmwareBatchTime / 1e6);
+
+    bool allMatch = true;
+    ChecksumSIMD::kernelEnum kernels[] = { ChecksumSIMD::kernelEnum::Scalar, ChecksumSIMD::kernelEnum::SSE2, ChecksumSIMD::kernelEnum::AVX2 };
+    std::vector<char> batch(messageCount);
+    for(ChecksumSIMD::kernelEnum kernel : kernels){
+        if(!ChecksumSIMD::setKernel(kernel)){
+            continue;
+        }
+        const int repeats = 4;
+        char checksum = 0;
+        start = seconds();
+        for(int r = 0; r < repeats; r++){
+            checksum = ChecksumSIMD::chksm8bitAllReadableChars(buffer.data(), bufferLen);
+        }
+        double time = (seconds() - start) / repeats;
+        start = seconds();
+        ChecksumSIMD::chksm8bitAllReadableCharsBatch(messages.data(), lengths.data(), messageCount, batch.data());
+        double batchTime = seconds() - start;
+        bool match = checksum == reference && batch == referenceBatch;
+        allMatch &= match;
+        printf("%-8s %8.2f GB/s %8.1f M messages/s %s\n", ChecksumSIMD::getKernelName(), bufferLen / time / 1e9, messageCount / batchTime / 1e6, match ? "match" : "MISMATCH");
+    }
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/**
+ * @brief      Compares reading and writing numbers as floats, with toFloat() and the arduino's way of printing a float, against the fixed point toScaled(), toFixed<Q>(), formatScaled() and formatFixed(). The same readings such as "V12.345" are converted both ways and written back as text with 3 decimals, and both must give the same text.
+ *
+ *              A PC has an FPU so the float path is cheap here. On an AVR every float operation is a soft-float library call, so the numbers here say nothing about an arduino. bench_avr/run_bench_avr.sh times toFloat() and toScaled() on an Uno and a Mega in simavr and compares the flash each takes.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../PosixSerial.cpp bench_fixed.cpp -o bench_fixed
+ *
+ *              Usage: bench_fixed [readings]
+ *
+ *              For code size on a PC, build the smallest program that uses each one and compare their text sizes.
+ *              g++ -Os -ffunction-sections -fdata-sections -Wl,--gc-sections -DBENCH_FIXED_SIZE_FLOAT -I.. ../SerialChecker.cpp ../PosixSerial.cpp bench_fixed.cpp -o size_float
+ *              g++ -Os -ffunction-sections -fdata-sections -Wl,--gc-sections -DBENCH_FIXED_SIZE_FIXED -I.. ../SerialChecker.cpp ../PosixSerial.cpp bench_fixed.cpp -o size_fixed
+ *              size size_float size_fixed
+ */
+#include "SerialChecker.h"
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#if defined(BENCH_FIXED_SIZE_FLOAT) || defined(BENCH_FIXED_SIZE_FIXED)
+int main(){
+    PosixSerial port(0);
+    SerialChecker sc(32, port, 115200);
+    sc.init();
+    while(port.waitReadable(100)){
+        while(sc.check()){
+        #ifdef BENCH_FIXED_SIZE_FLOAT
+            sc.println(sc.toFloat() * 2);
+        #else
+            sc.printlnScaled(sc.toScaled(1000) * 2, 1000);
+        #endif
+        }
+    }
+    return 0;
+}
+#else
+
+#include<vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include<x86intrin.h>
+static uint64_t cycles(){
+    return __rdtsc();
+}
+#else
+static uint64_t cycles(){
+    return 0;
+}
+#endif
+
+/**
+ * @brief      How the arduino's Print class writes a float: round, write the whole part, then multiply the remainder by 10 for each decimal.
+ */
+static uint8_t formatFloat(float n, uint8_t decimals, char* out){
+    uint8_t len = 0;
+    if(n < 0.0){
+        out[len++] = '-';
+        n = -n;
+    }
+    float rounding = 0.5;
+    for(uint8_t i = 0; i < decimals; i++){
+        rounding /= 10.0;
+    }
+    n += rounding;
+    uint32_t whole = (uint32_t)n;
+    float remainder = n - (float)whole;
+    char digits[10];
+    uint8_t count = 0;
+    do{
+        digits[count++] = '0' + whole % 10;
+        whole /= 10;
+    } while(whole);
+    while(count){
+        out[len++] = digits[--count];
+    }
+    if(decimals){
+        out[len++] = '.';
+    }
+    while(decimals-- > 0){
+        remainder *= 10.0;
+        uint8_t digit = (uint8_t)remainder;
+        out[len++] = '0' + digit;
+        remainder -= digit;
+    }
+    return len;
+}
+
+struct Result{
+    double nsPerReading;
+    double cyclesPerReading;
+    uint32_t textSum; // of the text written, as a cheap check that both agree
+};
+
+enum class Path{ Float, Scaled, Fixed };
+
+static Result run(Path path, SerialChecker& checker, const std::vector<char>& messages, uint32_t count){
+    Result result = {};
+    char text[SERIALCHECKER_NUMBER_BUFFER_LEN];
+    uint64_t startCycles = cycles();
+    uint32_t start = micros();
+    const char* message = messages.data();
+    for(uint32_t i = 0; i < count; i++){
+        uint8_t len = strlen(message);
+        checker.loadMsg(message, len);
+        message += len + 1;
+        uint8_t textLen;
+        switch(path){
+            case Path::Float:
+                textLen = formatFloat(checker.toFloat(1), 3, text);
+                break;
+            case Path::Scaled:
+                textLen = SerialChecker::formatScaled(checker.toScaled(1, 1000), 1000, text);
+                break;
+            default:
+                textLen = SerialChecker::formatFixed(checker.toFixed<16>(1), 16, 3, text);
+                break;
+        }
+        for(uint8_t j = 0; j < textLen; j++){
+            result.textSum += text[j] * (j + 1);
+        }
+    }
+    result.nsPerReading = (micros() - start) * 1e3 / count;
+    result.cyclesPerReading = (double)(cycles() - startCycles) / count;
+    return result;
+}
+
+int main(int argc, char** argv){
+    uint32_t count = argc > 1 ? atoi(argv[1]) : 2000000;
+    // Readings between -99.999 and 99.999 with 3 decimals, so that floats hold them exactly enough to print the same text.
+    std::vector<char> messages;
+    uint32_t seed = 12345;
+    char message[16];
+    for(uint32_t i = 0; i < count; i++){
+        seed = seed * 1664525 + 1013904223;
+        uint32_t value = (seed >> 8) % 100000;
+        int len = snprintf(message, sizeof(message), "V%s%u.%03u", seed & 1 ? "-" : "", value / 1000, value % 1000);
+        messages.insert(messages.end(), message, message + len + 1);
+    }
+    SerialChecker checker(16);
+    Result floats = run(Path::Float, checker, messages, count);
+    Result scaled = run(Path::Scaled, checker, messages, count);
+    Result fixed = run(Path::Fixed, checker, messages, count);
+    printf("%-36s %12s %12s\n", "read and write one reading", "ns", "cycles");
+    printf("%-36s %12.1f %12.1f\n", "toFloat() and print as a float", floats.nsPerReading, floats.cyclesPerReading);
+    printf("%-36s %12.1f %12.1f\n", "toScaled() and formatScaled()", scaled.nsPerReading, scaled.cyclesPerReading);
+    printf("%-36s %12.1f %12.1f\n", "toFixed<16>() and formatFixed()", fixed.nsPerReading, fixed.cyclesPerReading);
+    bool match = floats.textSum == scaled.textSum && floats.textSum == fixed.textSum;
+    if(!match){
+        printf("MISMATCH: the paths wrote different text\n");
+    }
+    return match ? 0 : 1;
+}
+#endif
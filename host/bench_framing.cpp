@@ -0,0 +1,140 @@
+/**
+ * @brief      Compares Framing, whose framing is fixed at compile time, with the run time configured SerialChecker. The same stream of messages, with a few damaged ones, is fed through both with checkChar() for several combinations of STX and checksum. Both must accept exactly the same messages.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../PosixSerial.cpp bench_framing.cpp -o bench_framing
+ *
+ *              Usage: bench_framing [messages]
+ *
+ *              For code size, build the smallest program that uses each one and compare their text sizes.
+ *              g++ -Os -ffunction-sections -fdata-sections -Wl,--gc-sections -DBENCH_FRAMING_SIZE_RUNTIME -I.. ../SerialChecker.cpp ../PosixSerial.cpp bench_framing.cpp -o size_runtime
+ *              g++ -Os -ffunction-sections -fdata-sections -Wl,--gc-sections -DBENCH_FRAMING_SIZE_FIXED -I.. ../SerialChecker.cpp ../PosixSerial.cpp bench_framing.cpp -o size_fixed
+ *              size size_runtime size_fixed
+ */
+#include "SerialCheckerFraming.h"
+
+#include<stdio.h>
+#include<stdlib.h>
+
+#if defined(BENCH_FRAMING_SIZE_RUNTIME) || defined(BENCH_FRAMING_SIZE_FIXED)
+int main(){
+    PosixSerial port(0);
+#ifdef BENCH_FRAMING_SIZE_RUNTIME
+    SerialChecker sc(32, port, 115200);
+    sc.enableSTX(true);
+    sc.enableChecksum();
+    sc.setChecksumType(checksumTypeEnum::Readable8bitChars);
+    sc.enableAckNak();
+#else
+    Framing<STX::Required, Checksum::Readable8bit, AckNak::On> sc(32, port, 115200);
+#endif
+    sc.init();
+    uint32_t count = 0;
+    while(port.waitReadable(100)){
+        while(sc.check()){
+            count++;
+        }
+    }
+    return count;
+}
+#else
+
+#include<vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include<x86intrin.h>
+static uint64_t cycles(){
+    return __rdtsc();
+}
+#else
+static uint64_t cycles(){
+    return 0;
+}
+#endif
+
+struct Result{
+    uint32_t accepted;
+    uint32_t lengthSum; // of the accepted messages, as a cheap check that both agree
+    double nsPerByte;
+    double cyclesPerByte;
+};
+
+template<class Checker>
+static Result run(Checker& checker, const std::vector<char>& stream){
+    Result result = {};
+    uint64_t startCycles = cycles();
+    uint32_t start = micros();
+    for(char in : stream){
+        uint8_t len = checker.checkChar(in);
+        if(len){
+            result.accepted++;
+            result.lengthSum += len + checker.getRawMsg()[0];
+        }
+    }
+    result.nsPerByte = (micros() - start) * 1e3 / stream.size();
+    result.cyclesPerByte = (double)(cycles() - startCycles) / stream.size();
+    return result;
+}
+
+/**
+ * @brief      Readings such as "V12345" from nodes 'A' to 'H' with an STX char and checksum if used. About 1 in 50 messages has a char changed.
+ */
+static std::vector<char> makeStream(uint32_t messages, bool useSTX, bool useChecksum){
+    std::vector<char> stream;
+    uint32_t seed = 12345;
+    char frame[32];
+    for(uint32_t i = 0; i < messages; i++){
+        seed = seed * 1664525 + 1013904223;
+        int len = 0;
+        if(useSTX){
+            frame[len++] = '$';
+        }
+        int start = len;
+        len += snprintf(&frame[len], 16, "%cV%u", 'A' + (seed >> 28) % 8, (seed >> 8) % 100000);
+        if(useChecksum){
+            frame[len] = SerialChecker::chksm8bitAllReadableChars(&frame[start], len - start);
+            len++;
+        }
+        if((seed & 0xFF) < 5){
+            frame[start + 2] ^= 1;
+        }
+        frame[len++] = '\n';
+        stream.insert(stream.end(), frame, frame + len);
+    }
+    return stream;
+}
+
+template<class FixedChecker>
+static bool compare(const char* name, uint32_t messages, bool useSTX, bool useChecksum){
+    std::vector<char> stream = makeStream(messages, useSTX, useChecksum);
+    SerialChecker runtime(32);
+    runtime.setAddressLen(1);
+    if(useSTX){
+        runtime.enableSTX(true);
+    }
+    if(useChecksum){
+        runtime.enableChecksum();
+        runtime.setChecksumType(checksumTypeEnum::Readable8bitChars);
+    }
+    FixedChecker fixed(32);
+    fixed.setAddressLen(1);
+    Result a = run(runtime, stream);
+    Result b = run(fixed, stream);
+    bool match = a.accepted == b.accepted && a.lengthSum == b.lengthSum;
+    printf("%-28s %10u %10.2f %10.1f %10.2f %10.1f %8.1fx %s\n", name, a.accepted, a.nsPerByte, a.cyclesPerByte, b.nsPerByte, b.cyclesPerByte,
+        a.nsPerByte / b.nsPerByte, match ? "" : "MISMATCH");
+    return match;
+}
+
+int main(int argc, char** argv){
+    uint32_t messages = argc > 1 ? atoi(argv[1]) : 2000000;
+    printf("%-28s %10s %21s %21s\n", "", "", "SerialChecker", "Framing");
+    printf("%-28s %10s %10s %10s %10s %10s %9s\n", "", "accepted", "ns/byte", "cyc/byte", "ns/byte", "cyc/byte", "speed up");
+    bool ok = true;
+    ok &= compare<Framing<STX::None, Checksum::None, AckNak::Off>>("no STX, no checksum", messages, false, false);
+    ok &= compare<Framing<STX::None, Checksum::Readable8bit, AckNak::Off>>("no STX, readable checksum", messages, false, true);
+    ok &= compare<Framing<STX::Required, Checksum::None, AckNak::Off>>("required STX, no checksum", messages, true, false);
+    ok &= compare<Framing<STX::Required, Checksum::Readable8bit, AckNak::Off>>("required STX, readable", messages, true, true);
+    return ok ? 0 : 1;
+}
+#endif
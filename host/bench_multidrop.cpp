@@ -0,0 +1,145 @@
+/**
+ * @brief      Measures what each node on a shared bus spends on other nodes' messages. A stream of checksummed messages to a number of addressed nodes is generated, as seen on an RS-485 line, and fed through one node's checker twice: once checking every message and then calling addressMatch() as was needed before, and once with addAddress() so that other nodes' messages are dropped as soon as their address has arrived. Some messages go to one of 4 groups of nodes or to every node, so the node answers to its own address, its group's address and the broadcast address. Both must find the same messages.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../PosixSerial.cpp bench_multidrop.cpp -o bench_multidrop
+ *
+ *              Usage: bench_multidrop [nodes] [messages] [address length]
+ */
+#include "SerialChecker.h"
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#include<vector>
+
+static double seconds(){
+    return micros() / 1e6;
+}
+
+static void makeAddress(uint32_t node, uint8_t len, char* address){
+    const char chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    for(uint8_t i = len; i-- > 0;){
+        address[i] = chars[node % 62];
+        node /= 62;
+    }
+    address[len] = '\0';
+}
+
+/**
+ * @brief      Group addresses use chars that node addresses never do. The broadcast address is all '*' chars.
+ */
+static void makeGroupAddress(uint32_t group, uint8_t len, char* address){
+    memset(address, '#', len);
+    address[0] = "#%&+"[group];
+    address[len] = '\0';
+}
+
+static void makeBroadcastAddress(uint8_t len, char* address){
+    memset(address, '*', len);
+    address[len] = '\0';
+}
+
+static SerialChecker* makeChecker(uint8_t addressLen){
+    SerialChecker* checker = new SerialChecker(32);
+    checker->enableSTX(true);
+    checker->enableChecksum();
+    checker->setChecksumType(checksumTypeEnum::SpellmanMPS); // never '$', see host/bench_noisy.cpp
+    checker->setAddressLen(addressLen);
+    return checker;
+}
+
+int main(int argc, char** argv){
+    uint32_t nodes = argc > 1 ? atoi(argv[1]) : 30;
+    uint32_t messages = argc > 2 ? atoi(argv[2]) : 2000000;
+    uint8_t addressLen = argc > 3 ? atoi(argv[3]) : 2;
+    if(addressLen < 1 || addressLen > 4){
+        fprintf(stderr, "the address length must be between 1 and 4\n");
+        return 2;
+    }
+
+    // 85% of messages go to one node, 10% to a group and 5% to every node. Node n is in group n % 4.
+    std::vector<char> stream;
+    std::vector<uint32_t> perNode(nodes);
+    uint32_t perGroup[4] = {};
+    uint32_t broadcasts = 0;
+    uint32_t seed = 12345;
+    char frame[40];
+    char address[8];
+    for(uint32_t i = 0; i < messages; i++){
+        seed = seed * 1664525 + 1013904223;
+        uint32_t kind = (seed >> 4) % 20;
+        if(kind < 17){
+            uint32_t node = (seed >> 8) % nodes;
+            perNode[node]++;
+            makeAddress(node, addressLen, address);
+        }
+        else if(kind < 19){
+            uint32_t group = (seed >> 8) % 4;
+            perGroup[group]++;
+            makeGroupAddress(group, addressLen, address);
+        }
+        else{
+            broadcasts++;
+            makeBroadcastAddress(addressLen, address);
+        }
+        int len = snprintf(frame, sizeof(frame), "$%sV%u", address, (seed >> 12) % 100000);
+        frame[len] = SerialChecker::chksmSpellmanMPS(&frame[1], len - 1);
+        frame[len + 1] = '\n';
+        stream.insert(stream.end(), frame, frame + len + 2);
+    }
+
+    const uint32_t node = 0;
+    char groupAddress[8];
+    char broadcastAddress[8];
+    makeAddress(node, addressLen, address);
+    makeGroupAddress(node % 4, addressLen, groupAddress);
+    makeBroadcastAddress(addressLen, broadcastAddress);
+    uint32_t expected[3] = { perNode[node], perGroup[node % 4], broadcasts };
+    printf("%u nodes, %u messages, %.1f MB, node %s has %u of them, group %s %u and broadcast %s %u\n\n", nodes, messages, stream.size() / 1e6,
+        address, expected[0], groupAddress, expected[1], broadcastAddress, expected[2]);
+
+    SerialChecker* everything = makeChecker(addressLen);
+    uint32_t found[3] = {};
+    double start = seconds();
+    for(char in : stream){
+        if(everything->checkChar(in)){
+            if(everything->addressMatch(address)){
+                found[0]++;
+            }
+            else if(everything->addressMatch(groupAddress)){
+                found[1]++;
+            }
+            else if(everything->addressMatch(broadcastAddress)){
+                found[2]++;
+            }
+        }
+    }
+    double timeEverything = seconds() - start;
+
+    SerialChecker* filtered = makeChecker(addressLen);
+    filtered->addAddress(address, addressKindEnum::Unicast);
+    filtered->addAddress(groupAddress, addressKindEnum::Group);
+    filtered->addAddress(broadcastAddress, addressKindEnum::Broadcast);
+    uint32_t foundFiltered[3] = {};
+    start = seconds();
+    for(char in : stream){
+        if(filtered->checkChar(in)){
+            foundFiltered[(int)filtered->getAddressKind() - 1]++;
+        }
+    }
+    double timeFiltered = seconds() - start;
+
+    printf("%-24s %10s %10s %10s %12s\n", "", "own", "group", "broadcast", "ns per byte");
+    printf("%-24s %10u %10u %10u %12.2f\n", "check all + addressMatch", found[0], found[1], found[2], timeEverything / stream.size() * 1e9);
+    printf("%-24s %10u %10u %10u %12.2f\n", "addAddress", foundFiltered[0], foundFiltered[1], foundFiltered[2], timeFiltered / stream.size() * 1e9);
+    printf("\n%.1fx less time per byte, %u messages skipped\n", timeEverything / timeFiltered, filtered->getSkippedCount());
+    delete everything;
+    delete filtered;
+    bool match = true;
+    for(int k = 0; k < 3; k++){
+        match &= found[k] == expected[k] && foundFiltered[k] == expected[k];
+    }
+    return match ? 0 : 1;
+}
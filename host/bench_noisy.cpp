@@ -0,0 +1,158 @@
+/**
+ * @brief      Measures how well SerialChecker copes with noise for each combination of enableSTX(), enableChecksum() and setChecksumType(). A repeatable stream of frames from NoisyStream, with bit flips, dropped bytes, missing ETX chars, spurious STX chars, \r\n line endings and over length runs mixed in, is fed through checkChar() and every accepted message is compared with what was sent. For each combination it prints:
+ *                  recovered   the percentage of all frames that were accepted with the right payload
+ *                  undamaged   the percentage of the frames that were sent undamaged that were accepted, which shows how often damage to one frame loses its neighbours too
+ *                  false       the number of accepted messages that were not sent, per 1000 frames
+ *                  MB/s        how fast checkChar() gets through the stream, timed on its own
+ *              followed by the percentage of frames recovered for each kind of damage.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../PosixSerial.cpp NoisyStream.cpp bench_noisy.cpp -o bench_noisy
+ *
+ *              Usage: bench_noisy [-f frames] [-s seed] [-p noise scale] [-w file prefix]
+ *                  -w saves each stream to <prefix>_<combination>.bin so that it can be run through capture_validate as well
+ */
+#include "NoisyStream.h"
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+
+#include<string>
+#include<unordered_map>
+#include<vector>
+
+#define BENCH_NOISY_MSG_MAX_LEN 16
+
+struct Combination{
+    const char* name;
+    bool useSTX;
+    bool requireSTX;
+    bool useChecksum;
+    checksumTypeEnum checksumType;
+};
+
+static double seconds(){
+    return micros() / 1e6;
+}
+
+int main(int argc, char** argv){
+    uint32_t frames = 200000;
+    uint32_t seed = 12345;
+    float scale = 1.0f;
+    const char* prefix = nullptr;
+    int opt;
+    while((opt = getopt(argc, argv, "f:s:p:w:")) != -1){
+        switch(opt){
+            case 'f': frames = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, nullptr, 10); break;
+            case 'p': scale = atof(optarg); break;
+            case 'w': prefix = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-f frames] [-s seed] [-p noise scale] [-w file prefix]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    const Combination combinations[] = {
+        { "none", false, false, false, checksumTypeEnum::Readable8bitChars },
+        { "spellman", false, false, true, checksumTypeEnum::SpellmanMPS },
+        { "readable", false, false, true, checksumTypeEnum::Readable8bitChars },
+        { "stx", true, false, false, checksumTypeEnum::Readable8bitChars },
+        { "stx_spellman", true, false, true, checksumTypeEnum::SpellmanMPS },
+        { "stx_readable", true, false, true, checksumTypeEnum::Readable8bitChars },
+        { "STX", true, true, false, checksumTypeEnum::Readable8bitChars },
+        { "STX_spellman", true, true, true, checksumTypeEnum::SpellmanMPS },
+        { "STX_readable", true, true, true, checksumTypeEnum::Readable8bitChars },
+    };
+
+    printf("%u frames, seed %u, noise scale %.2f (stx = optional STX, STX = required STX)\n\n", frames, seed, scale);
+    printf("%-14s %10s %10s %10s %10s ", "combination", "recovered", "undamaged", "false", "MB/s");
+    for(int i = 1; i < (int)noiseEnum::Count; i++){
+        printf(" %13s", NoisyStream::noiseName((noiseEnum)i));
+    }
+    printf("\n");
+    for(const Combination& c : combinations){
+        NoisyStreamSettings settings;
+        settings.useSTX = c.useSTX;
+        settings.useChecksum = c.useChecksum;
+        settings.checksumType = c.checksumType;
+        for(int i = 1; i < (int)noiseEnum::Count; i++){
+            settings.chance[i] *= scale;
+        }
+        NoisyStream generator(settings, seed);
+        std::vector<char> stream;
+        generator.generate(frames, stream);
+        if(prefix){
+            std::string path = std::string(prefix) + "_" + c.name + ".bin";
+            FILE* file = fopen(path.c_str(), "wb");
+            if(!file || fwrite(stream.data(), 1, stream.size(), file) != stream.size()){
+                perror(path.c_str());
+                return 2;
+            }
+            fclose(file);
+        }
+
+        // Payloads are unique apart from the frame number wrapping at 0xFFFFFF, so each one maps to the frames that carried it, oldest first.
+        std::unordered_map<std::string, std::vector<uint32_t>> sent;
+        const std::vector<std::string>& payloads = generator.getPayloads();
+        for(uint32_t n = payloads.size(); n-- > 0;){
+            sent[payloads[n]].push_back(n);
+        }
+
+        SerialChecker checker(BENCH_NOISY_MSG_MAX_LEN);
+        if(c.useSTX){
+            checker.enableSTX(c.requireSTX, settings.STX);
+        }
+        if(c.useChecksum){
+            checker.enableChecksum();
+            checker.setChecksumType(c.checksumType);
+        }
+        uint32_t accepted = 0;
+        double start = seconds();
+        for(char in : stream){
+            accepted += checker.checkChar(in) != 0;
+        }
+        double time = seconds() - start;
+
+        // Same again on a fresh checker, this time sorting out what was accepted.
+        SerialChecker sorter(BENCH_NOISY_MSG_MAX_LEN);
+        if(c.useSTX){
+            sorter.enableSTX(c.requireSTX, settings.STX);
+        }
+        if(c.useChecksum){
+            sorter.enableChecksum();
+            sorter.setChecksumType(c.checksumType);
+        }
+        uint32_t recovered = 0;
+        uint32_t falseAccepts = 0;
+        uint32_t recoveredByNoise[(int)noiseEnum::Count] = {};
+        for(char in : stream){
+            uint8_t len = sorter.checkChar(in);
+            if(len){
+                auto found = sent.find(std::string(sorter.getRawMsg(), len));
+                if(found != sent.end() && !found->second.empty()){
+                    recoveredByNoise[(int)generator.getNoise(found->second.back())]++;
+                    found->second.pop_back();
+                    recovered++;
+                }
+                else{
+                    falseAccepts++;
+                }
+            }
+        }
+        uint32_t undamaged = generator.getNoiseCount(noiseEnum::None);
+        printf("%-14s %9.2f%% %9.2f%% %10.2f %10.1f ", c.name, 100.0 * recovered / frames, undamaged ? 100.0 * recoveredByNoise[(int)noiseEnum::None] / undamaged : 0.0,
+            1000.0 * falseAccepts / frames, time > 0 ? stream.size() / time / 1e6 : 0.0);
+        for(int i = 1; i < (int)noiseEnum::Count; i++){
+            uint32_t count = generator.getNoiseCount((noiseEnum)i);
+            printf(" %12.1f%%", count ? 100.0 * recoveredByNoise[i] / count : 0.0);
+        }
+        printf("\n");
+        if(accepted != recovered + falseAccepts){
+            fprintf(stderr, "%s: the two passes accepted different numbers of messages\n", c.name);
+            return 1;
+        }
+    }
+    return 0;
+}
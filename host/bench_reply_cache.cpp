@@ -0,0 +1,151 @@
+/**
+ * @brief      Compares three ways of answering a status query that is polled over and over: printing the answer piece by piece with several print() calls, formatting it in to a buffer and sending it with sendFrame(), and sending the reply kept by sendFrameCached() with sendCachedReply(). The framing has an STX char, sequence numbers and a checksum, so a cached reply has its sequence number and checksum char changed each time it is sent.
+ *
+ *              First the replies are sent down a pipe and read back, and the cached ones must be exactly what sendFrame() sends. Then each way is timed with the replies going to /dev/null, so the time includes the write() calls, one per print() on a PC.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../PosixSerial.cpp bench_reply_cache.cpp -o bench_reply_cache
+ *
+ *              Usage: bench_reply_cache [replies]
+ */
+#include "SerialChecker.h"
+
+#include<fcntl.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include<x86intrin.h>
+static uint64_t cycles(){
+    return __rdtsc();
+}
+#else
+static uint64_t cycles(){
+    return 0;
+}
+#endif
+
+static int32_t temperature = 2250; // hundredths of a degree
+static int32_t pressure = 1013250; // tenths of a pascal
+static uint16_t statusVersion = 0; // bumped whenever the status changes
+
+static void setup(SerialChecker& sc){
+    sc.init();
+    sc.enableSTX(true);
+    sc.enableSeqNum();
+    sc.enableChecksum();
+    sc.setChecksumType(checksumTypeEnum::SpellmanMPS);
+    sc.enableReplyCache();
+    sc.loadMsg("00STATUS?", 9);
+}
+
+/**
+ * @brief      The status formatted in to a buffer.
+ */
+static void formatStatus(char* reply){
+    uint8_t len = 0;
+    memcpy(reply, "RUN,T=", 6);
+    len += 6;
+    len += SerialChecker::formatScaled(temperature, 100, &reply[len]);
+    memcpy(&reply[len], ",P=", 3);
+    len += 3;
+    len += SerialChecker::formatScaled(pressure, 10, &reply[len]);
+    reply[len] = '\0';
+}
+
+/**
+ * @brief      The status printed a piece at a time, the way a sketch without sendFrame() answers.
+ */
+static void printStatus(SerialChecker& sc){
+    sc.print((char*)"RUN,T=");
+    sc.printScaled(temperature, 100);
+    sc.print((char*)",P=");
+    sc.printScaled(pressure, 10);
+    sc.println();
+}
+
+static void answerFormatted(SerialChecker& sc){
+    char reply[40];
+    formatStatus(reply);
+    sc.sendFrame(reply);
+}
+
+static void answerCached(SerialChecker& sc){
+    if(!sc.sendCachedReply(statusVersion)){
+        char reply[40];
+        formatStatus(reply);
+        sc.sendFrameCached(reply, statusVersion);
+    }
+}
+
+/**
+ * @brief      Sends replies both ways down a pipe, with the status changing every so often, and checks they are the same.
+ */
+static bool compare(uint32_t replies){
+    int formattedPipe[2];
+    int cachedPipe[2];
+    if(pipe(formattedPipe) || pipe(cachedPipe)){
+        perror("pipe");
+        exit(1);
+    }
+    PosixSerial formattedPort(formattedPipe[1]);
+    PosixSerial cachedPort(cachedPipe[1]);
+    SerialChecker formatted(32, formattedPort, 115200);
+    SerialChecker cached(32, cachedPort, 115200);
+    setup(formatted);
+    setup(cached);
+    fcntl(formattedPipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(cachedPipe[0], F_SETFL, O_NONBLOCK);
+    bool same = true;
+    for(uint32_t i = 0; i < replies && same; i++){
+        if(i % 7 == 0){
+            temperature += 3;
+            statusVersion++;
+        }
+        answerFormatted(formatted);
+        answerCached(cached);
+        char a[64];
+        char b[64];
+        ssize_t aLen = read(formattedPipe[0], a, sizeof(a));
+        ssize_t bLen = read(cachedPipe[0], b, sizeof(b));
+        same = aLen > 0 && aLen == bLen && memcmp(a, b, aLen) == 0;
+        if(!same){
+            printf("reply %u differs: %.*s against %.*s\n", i, (int)aLen, a, (int)bLen, b);
+        }
+    }
+    printf("%u replies, %u from the cache, %s\n", replies, cached.getReplyCacheHits(), same ? "the same as sendFrame()" : "DIFFERENT");
+    return same;
+}
+
+int main(int argc, char** argv){
+    uint32_t replies = argc > 1 ? atoi(argv[1]) : 100000;
+    bool ok = compare(1000);
+
+    int devNull = open("/dev/null", O_WRONLY);
+    PosixSerial port(devNull);
+    SerialChecker sc(32, port, 0); // no baudrate, so write() doesn't keep count of chars still being sent
+    setup(sc);
+    const char* names[] = { "print() calls", "sendFrame()", "sendCachedReply()" };
+    printf("%-20s %16s\n", "", "cycles/reply");
+    for(uint8_t way = 0; way < 3; way++){
+        uint64_t start = cycles();
+        for(uint32_t i = 0; i < replies; i++){
+            switch(way){
+                case 0:
+                    printStatus(sc);
+                    break;
+                case 1:
+                    answerFormatted(sc);
+                    break;
+                default:
+                    answerCached(sc);
+                    break;
+            }
+        }
+        printf("%-20s %16.0f\n", names[way], (double)(cycles() - start) / replies);
+    }
+    close(devNull);
+    return ok ? 0 : 1;
+}
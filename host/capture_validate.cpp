@@ -0,0 +1,197 @@
+/**
+ * @brief      Checks recorded serial captures for bad messages. The capture file is memory mapped and split in to one chunk per core, with each chunk boundary moved to just after an ETX char so that every chunk starts at the beginning of a message. Each thread runs its chunk through SerialChecker::checkChar() with the same settings as the arduino and counts good and rejected messages per address. The byte offset and reason of each rejected message are kept so that they can be lined up with other logs.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -pthread -I.. ../SerialChecker.cpp ../PosixSerial.cpp CheckerSettings.cpp capture_validate.cpp -o capture_validate
+ *
+ *              Usage: capture_validate [options] capture_file
+ *                  -c r|s      use checksums, readable 8 bit (r) or Spellman MPS (s)
+ *                  -s C        optional STX char C
+ *                  -S C        required STX char C
+ *                  -e C        ETX char C, default '\n'
+ *                  -a N        address length N
+ *                  -m N        message maximum length N, default 13
+ *                  -n N        message minimum length N, default 1
+ *                  -r          allow \r chars in messages
+ *                  -N          messages carry sequence numbers
+ *                  -f A        only look at messages for address A
+ *                  -t N        use N threads, default one per core
+ *                  -l N        list the first N rejected messages, default 20
+ */
+#include "CheckerSettings.h"
+
+#include<fcntl.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+#include<algorithm>
+#include<map>
+#include<string>
+#include<thread>
+#include<unordered_map>
+#include<vector>
+
+struct AddressStats{
+    uint64_t good = 0;
+    uint64_t rejected[6] = {}; // indexed by frameErrorEnum
+};
+
+struct Rejection{
+    uint64_t offset; // offset of the char that caused the rejection
+    frameErrorEnum reason;
+    std::string address;
+};
+
+struct ChunkResult{
+    std::unordered_map<uint64_t, AddressStats> stats; // keyed by the address chars packed in to an integer, see packAddress()
+    std::vector<Rejection> rejections;
+};
+
+/**
+ * @brief      Packs up to 8 address chars in to an integer so that looking up the stats for every message does not need a string. Addresses longer than 8 chars share stats with any other address that starts with the same 8 chars.
+ */
+static uint64_t packAddress(const char* address, uint8_t len){
+    uint64_t key = 0;
+    memcpy(&key, address, len < 8 ? len : 8);
+    return key;
+}
+
+static std::string unpackAddress(uint64_t key, uint8_t len){
+    char chars[8];
+    memcpy(chars, &key, 8);
+    return std::string(chars, len < 8 ? len : 8);
+}
+
+static void validateChunk(const char* data, uint64_t begin, uint64_t end, const CheckerSettings& settings, size_t maxRejections, ChunkResult* result){
+    SerialChecker checker(settings.msgMaxLen);
+    settings.configure(checker);
+    const uint64_t unknownAddress = packAddress("?", 1);
+    for(uint64_t i = begin; i < end; i++){
+        if(checker.checkChar(data[i])){
+            result->stats[packAddress(checker.getRawMsg(), settings.addressLen)].good++;
+        }
+        else if(checker.getLastError() != frameErrorEnum::None){
+            frameErrorEnum reason = checker.getLastError();
+            checker.clearLastError();
+            // The buffer still holds the start of a message that was too long or had a bad checksum, so the address is known. Otherwise it can not be trusted.
+            uint64_t address = unknownAddress;
+            if(reason == frameErrorEnum::BadChecksum || reason == frameErrorEnum::TooLong){
+                address = packAddress(&checker.getRawMsg()[settings.useSeqNum ? 2 : 0], settings.addressLen); // the sequence number is only taken off messages that are accepted
+            }
+            result->stats[address].rejected[(int)reason]++;
+            if(result->rejections.size() < maxRejections){
+                result->rejections.push_back({ i, reason, address == unknownAddress ? std::string("?") : unpackAddress(address, settings.addressLen) });
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    CheckerSettings settings;
+    unsigned threads = std::thread::hardware_concurrency();
+    size_t listRejections = 20;
+    int opt;
+    while((opt = getopt(argc, argv, CHECKER_SETTINGS_OPTIONS "t:l:")) != -1){
+        switch(opt){
+            case 't': threads = atoi(optarg); break;
+            case 'l': listRejections = atoi(optarg); break;
+            default:
+                if(settings.parseOption(opt, optarg)){
+                    break;
+                }
+                fprintf(stderr, "usage: %s [-c r|s] [-s C | -S C] [-e C] [-a N] [-m N] [-n N] [-r] [-N] [-f A] [-t N] [-l N] capture_file\n", argv[0]);
+                return 2;
+        }
+    }
+    if(optind >= argc){
+        fprintf(stderr, "no capture file given\n");
+        return 2;
+    }
+    if(threads == 0){
+        threads = 1;
+    }
+
+    int fd = open(argv[optind], O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) < 0){
+        perror(argv[optind]);
+        return 2;
+    }
+    uint64_t size = st.st_size;
+    const char* data = nullptr;
+    if(size){
+        data = (const char*)mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED){
+            perror("mmap");
+            return 2;
+        }
+        madvise((void*)data, size, MADV_SEQUENTIAL);
+    }
+
+    // Split in to chunks that each start just after an ETX char.
+    std::vector<uint64_t> bounds(1, 0);
+    uint64_t chunkLen = std::max<uint64_t>(size / threads, 1 << 20);
+    while(bounds.back() + chunkLen < size){
+        const char* etx = (const char*)memchr(data + bounds.back() + chunkLen, settings.ETX, size - bounds.back() - chunkLen);
+        if(!etx){
+            break;
+        }
+        bounds.push_back(etx - data + 1);
+    }
+    bounds.push_back(size);
+
+    uint32_t start = micros();
+    std::vector<ChunkResult> results(bounds.size() - 1);
+    std::vector<std::thread> workers;
+    for(size_t c = 0; c + 1 < bounds.size(); c++){
+        workers.push_back(std::thread(validateChunk, data, bounds[c], bounds[c + 1], std::cref(settings), listRejections, &results[c]));
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    double elapsed = (micros() - start) / 1e6;
+
+    std::map<std::string, AddressStats> stats;
+    std::vector<Rejection> rejections;
+    for(ChunkResult& result : results){
+        for(auto& entry : result.stats){
+            AddressStats& total = stats[entry.first == packAddress("?", 1) ? std::string("?") : unpackAddress(entry.first, settings.addressLen)];
+            total.good += entry.second.good;
+            for(int r = 0; r < 6; r++){
+                total.rejected[r] += entry.second.rejected[r];
+            }
+        }
+        rejections.insert(rejections.end(), result.rejections.begin(), result.rejections.end());
+    }
+
+    uint64_t good = 0;
+    uint64_t rejected = 0;
+    printf("%-10s %12s %12s %12s %12s %12s %12s\n", "address", "good", "too short", "too long", "checksum", "no STX", "bad seq");
+    for(auto& entry : stats){
+        const AddressStats& s = entry.second;
+        printf("%-10s %12llu %12llu %12llu %12llu %12llu %12llu\n", entry.first.empty() ? "-" : entry.first.c_str(), (unsigned long long)s.good,
+            (unsigned long long)s.rejected[(int)frameErrorEnum::TooShort], (unsigned long long)s.rejected[(int)frameErrorEnum::TooLong],
+            (unsigned long long)s.rejected[(int)frameErrorEnum::BadChecksum], (unsigned long long)s.rejected[(int)frameErrorEnum::MissingSTX],
+            (unsigned long long)s.rejected[(int)frameErrorEnum::BadSeqNum]);
+        good += s.good;
+        for(int r = 0; r < 6; r++){
+            rejected += s.rejected[r];
+        }
+    }
+    printf("\n%llu good, %llu rejected, %.1f MB in %.3f s (%.0f MB/s, %zu chunks)\n", (unsigned long long)good, (unsigned long long)rejected,
+        size / 1e6, elapsed, elapsed > 0 ? size / 1e6 / elapsed : 0.0, bounds.size() - 1);
+
+    std::sort(rejections.begin(), rejections.end(), [](const Rejection& a, const Rejection& b){ return a.offset < b.offset; });
+    for(size_t i = 0; i < rejections.size() && i < listRejections; i++){
+        printf("offset %12llu  address %-6s %s\n", (unsigned long long)rejections[i].offset, rejections[i].address.c_str(), CheckerSettings::reasonName(rejections[i].reason));
+    }
+    if(size){
+        munmap((void*)data, size);
+    }
+    close(fd);
+    return rejected ? 1 : 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * @brief      Runs SerialCheckerKeyValue's parse() over a list of messages and checks what it sets and counts. Each message is loaded in to a checker with loadMsg(), as check() would leave it, so no port is needed.
+ *
+ *              It checks several keys in one message, values out of range, values that aren't numbers, unknown keys and getUnknownKey(), read only keys, the int16_t limits, and the int32_t limits including numbers with leading zeros.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../SerialCheckerKeyValue.cpp ../PosixSerial.cpp check_keyvalue.cpp -o check_keyvalue
+ *
+ *              Usage: check_keyvalue
+ */
+#include "SerialCheckerKeyValue.h"
+
+#include<stdio.h>
+#include<string.h>
+
+static float temperature = 0;
+static int16_t rampRate = 0;
+static int32_t position = 0;
+static int16_t small = 0;
+static int32_t large = 0;
+static int32_t serial = 1234;
+
+static uint32_t failures = 0;
+
+/**
+ * @brief      One message and what parse() should make of it. Variables not named in the message must stay as they were.
+ */
+struct Case{
+    const char* message;
+    uint8_t startIndex;
+    uint8_t stored;
+    uint8_t unknown;
+    uint8_t rejected;
+    const char* unknownKey;
+};
+
+static void expectValue(const char* name, bool ok){
+    printf("%-4s %s\n", ok ? "ok" : "FAIL", name);
+    if(!ok){
+        failures++;
+    }
+}
+
+static void run(SerialChecker& sc, SerialCheckerKeyValue& settings, const Case& c){
+    sc.loadMsg(c.message, strlen(c.message));
+    uint8_t stored = settings.parse(c.startIndex);
+    bool ok = stored == c.stored && settings.getUnknownCount() == c.unknown && settings.getRejectedCount() == c.rejected && strcmp(settings.getUnknownKey(), c.unknownKey) == 0;
+    printf("%-4s %-44s stored %u, unknown %u, rejected %u%s%s\n", ok ? "ok" : "FAIL", c.message, stored, settings.getUnknownCount(), settings.getRejectedCount(),
+        settings.getUnknownKey()[0] ? ", first unknown " : "", settings.getUnknownKey());
+    if(!ok){
+        printf("     expected stored %u, unknown %u, rejected %u, first unknown \"%s\"\n", c.stored, c.unknown, c.rejected, c.unknownKey);
+        failures++;
+    }
+}
+
+int main(){
+    SerialChecker sc(64);
+    SerialCheckerKeyValue settings(sc, 6);
+    expectValue("keys added", settings.add("T", &temperature, -20.0, 80.0)
+        && settings.add("RAMP", &rampRate, 0, 100)
+        && settings.add("POS", &position, -100000, 100000)
+        && settings.add("S", &small, -32768, 32767)
+        && settings.add("L", &large, INT32_MIN, INT32_MAX)
+        && settings.add("SN", &serial, 0, 9999));
+    expectValue("a key added twice is refused", !settings.add("T", &temperature, 0.0, 1.0));
+    expectValue("a key past maxKeys is refused", !settings.add("X", &large, 0, 1));
+    expectValue("read only set", settings.setReadOnly("SN") && !settings.setReadOnly("NOPE"));
+
+    run(sc, settings, { "T=22.5,RAMP=10,POS=-300", 0, 3, 0, 0, "" });
+    expectValue("T, RAMP and POS set", temperature == 22.5f && rampRate == 10 && position == -300);
+    run(sc, settings, { "ST=-4.25,RAMP=0", 1, 2, 0, 0, "" });
+    expectValue("parsed from index 1", temperature == -4.25f && rampRate == 0);
+
+    // Out of range, each one left alone.
+    run(sc, settings, { "T=80.1,RAMP=-1,POS=100001", 0, 0, 0, 3, "" });
+    run(sc, settings, { "T=-20,RAMP=101", 0, 1, 0, 1, "" });
+    expectValue("in range values set, out of range ones left alone", temperature == -20.0f && rampRate == 0 && position == -300);
+
+    // Not numbers.
+    run(sc, settings, { "T=abc,RAMP=1x,POS=", 0, 0, 0, 3, "" });
+    run(sc, settings, { "T=1.2.3,RAMP=1.5,POS=-,T=--1", 0, 0, 0, 4, "" });
+    expectValue("values that aren't numbers left alone", temperature == -20.0f && rampRate == 0 && position == -300);
+
+    // Unknown keys and keys without a value.
+    run(sc, settings, { "X=1,T=20,Y=2", 0, 1, 2, 0, "X" });
+    run(sc, settings, { "NOEQUALS,RAMP=5", 0, 1, 1, 0, "NOEQUALS" });
+    run(sc, settings, { "AVERYLONGUNKNOWNKEY=1", 0, 0, 1, 0, "AVERYLONGUNKNOW" });
+    run(sc, settings, { "RAMP=6", 0, 1, 0, 0, "" });
+    expectValue("known keys set beside unknown ones", temperature == 20.0f && rampRate == 6);
+
+    // Read only.
+    run(sc, settings, { "SN=1,RAMP=7", 0, 1, 0, 1, "" });
+    expectValue("read only SN left alone", serial == 1234 && rampRate == 7);
+
+    // int16_t limits.
+    run(sc, settings, { "S=32767", 0, 1, 0, 0, "" });
+    expectValue("S=32767", small == 32767);
+    run(sc, settings, { "S=-32768", 0, 1, 0, 0, "" });
+    expectValue("S=-32768", small == -32768);
+    run(sc, settings, { "S=32768,S=-32769,S=65536", 0, 0, 0, 3, "" });
+    expectValue("S left at -32768", small == -32768);
+
+    // int32_t limits, and numbers too big for one that would wrap round.
+    run(sc, settings, { "L=2147483647", 0, 1, 0, 0, "" });
+    expectValue("L=2147483647", large == INT32_MAX);
+    run(sc, settings, { "L=-2147483648", 0, 1, 0, 0, "" });
+    expectValue("L=-2147483648", large == INT32_MIN);
+    run(sc, settings, { "L=2147483648,L=-2147483649,L=4294967301,L=99999999999", 0, 0, 0, 4, "" });
+    expectValue("L left at -2147483648", large == INT32_MIN);
+    run(sc, settings, { "L=00000000005", 0, 1, 0, 0, "" });
+    expectValue("leading zeros, L=5", large == 5);
+    run(sc, settings, { "L=-0000002147483648", 0, 1, 0, 0, "" });
+    expectValue("leading zeros, L=-2147483648", large == INT32_MIN);
+    run(sc, settings, { "L=00000000000", 0, 1, 0, 0, "" });
+    expectValue("all zeros, L=0", large == 0);
+    run(sc, settings, { "L=0002147483648", 0, 0, 0, 1, "" });
+    expectValue("leading zeros don't hide an overflow", large == 0);
+
+    printf("%s\n", failures ? "FAILED" : "all messages parsed as expected");
+    return failures ? 1 : 0;
+}
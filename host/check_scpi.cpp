@@ -0,0 +1,163 @@
+/**
+ * @brief      Runs SerialCheckerSCPI's handle() over a list of messages and checks which handlers ran, with which arguments, and the error it stopped with. Each message is loaded in to a checker with loadMsg(), as check() would leave it, so no port is needed.
+ *
+ *              It checks short and long forms in any case, the '?' suffix, commands chained with ';' with and without a leading ':', common commands such as *IDN? in the middle of a chain, the split of the arguments and a leading '+' on them, and every scpiErrorEnum value.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../SerialCheckerSCPI.cpp ../PosixSerial.cpp check_scpi.cpp -o check_scpi
+ *
+ *              Usage: check_scpi
+ */
+#include "SerialCheckerSCPI.h"
+
+#include<stdarg.h>
+#include<stdio.h>
+#include<string.h>
+
+static char calls[256]; // what the handlers were called with, one entry per call
+static uint32_t failures = 0;
+
+/**
+ * @brief      Adds an entry to calls, after a space if it isn't the first.
+ */
+static void __attribute__((format(printf, 1, 2))) note(const char* format, ...){
+    size_t len = strlen(calls);
+    if(len){
+        calls[len++] = ' ';
+    }
+    va_list args;
+    va_start(args, format);
+    vsnprintf(&calls[len], sizeof(calls) - len, format, args);
+    va_end(args);
+}
+
+static bool setVoltage(SerialCheckerSCPI& scpi, void*){
+    if(scpi.getArgCount() != 1 || !scpi.isNumber(0)){
+        return false;
+    }
+    note("V=%g", scpi.getFloat(0));
+    return true;
+}
+
+static bool getVoltage(SerialCheckerSCPI&, void*){
+    note("V?");
+    return true;
+}
+
+static bool setCurrent(SerialCheckerSCPI& scpi, void*){
+    note("I=%d", scpi.getInt16(0));
+    return true;
+}
+
+static bool measureCurrent(SerialCheckerSCPI&, void*){
+    note("MEAS:I?");
+    return true;
+}
+
+static bool identify(SerialCheckerSCPI&, void*){
+    note("IDN?");
+    return true;
+}
+
+static bool reset(SerialCheckerSCPI&, void*){
+    note("RST");
+    return true;
+}
+
+/**
+ * @brief      Notes every argument: numbers as getInt32() and getFloat() see them, anything else as text.
+ */
+static bool configure(SerialCheckerSCPI& scpi, void*){
+    note("CONF[%u]", scpi.getArgCount());
+    for(uint8_t arg = 0; arg < scpi.getArgCount(); arg++){
+        if(scpi.isNumber(arg)){
+            note("%ld/%g", (long)scpi.getInt32(arg), scpi.getFloat(arg));
+        }
+        else{
+            note("'%.*s'", scpi.getArgLen(arg), scpi.getArg(arg));
+        }
+    }
+    return true;
+}
+
+enum{ SOUR, SOUR_VOLT, SOUR_CURR, MEAS, MEAS_CURR, IDN, RST, CONF };
+static const scpiNode commands[] = {
+    { "SOURce", SCPI_ROOT, nullptr, nullptr },
+    { "VOLTage", SOUR, setVoltage, getVoltage },
+    { "CURRent", SOUR, setCurrent, nullptr },
+    { "MEASure", SCPI_ROOT, nullptr, nullptr },
+    { "CURRent", MEAS, nullptr, measureCurrent },
+    { "*IDN", SCPI_ROOT, nullptr, identify },
+    { "*RST", SCPI_ROOT, reset, nullptr },
+    { "CONFigure", SCPI_ROOT, configure, nullptr },
+};
+
+/**
+ * @brief      One message and what handle() should do with it.
+ */
+struct Case{
+    const char* message;
+    uint8_t startIndex;
+    uint8_t run;
+    scpiErrorEnum error;
+    const char* calls;
+};
+
+static const char* errorNames[] = { "None", "UndefinedHeader", "NotAQuery", "QueryOnly", "BadParameter" };
+
+int main(){
+    SerialChecker sc(64);
+    SerialCheckerSCPI scpi(sc, commands, sizeof(commands) / sizeof(commands[0]), nullptr);
+    const Case cases[] = {
+        // Short and long forms, in any case.
+        { "SOUR:VOLT 1", 0, 1, scpiErrorEnum::None, "V=1" },
+        { "source:voltage 2", 0, 1, scpiErrorEnum::None, "V=2" },
+        { "Sour:Volt 3", 0, 1, scpiErrorEnum::None, "V=3" },
+        { "SOURC:VOLT 4", 0, 0, scpiErrorEnum::UndefinedHeader, "" },
+        { "SOUR:VOLTAGES 5", 0, 0, scpiErrorEnum::UndefinedHeader, "" },
+        { "VOLT 6", 0, 0, scpiErrorEnum::UndefinedHeader, "" },
+        { "*idn?", 0, 1, scpiErrorEnum::None, "IDN?" },
+        // The '?' suffix picks the query handler.
+        { "SOUR:VOLT?", 0, 1, scpiErrorEnum::None, "V?" },
+        { "MEAS:CURR?", 0, 1, scpiErrorEnum::None, "MEAS:I?" },
+        // Chains stay on the branch unless a command begins with ':'.
+        { "SOUR:VOLT 1;CURR 2", 0, 2, scpiErrorEnum::None, "V=1 I=2" },
+        { "SOUR:VOLT 1; VOLT?", 0, 2, scpiErrorEnum::None, "V=1 V?" },
+        { "SOUR:VOLT 1;:MEAS:CURR?", 0, 2, scpiErrorEnum::None, "V=1 MEAS:I?" },
+        { "SOUR:VOLT 1;MEAS:CURR?", 0, 1, scpiErrorEnum::UndefinedHeader, "V=1" },
+        { "MEAS:CURR?;:SOUR:CURR 3;VOLT 4", 0, 3, scpiErrorEnum::None, "MEAS:I? I=3 V=4" },
+        // Common commands are found from any branch and leave it alone.
+        { "SOUR:VOLT 1;*IDN?;VOLT 2", 0, 3, scpiErrorEnum::None, "V=1 IDN? V=2" },
+        { "SOUR:VOLT 1;*RST;*IDN?;CURR 7", 0, 4, scpiErrorEnum::None, "V=1 RST IDN? I=7" },
+        { "*RST;SOUR:VOLT 5", 0, 2, scpiErrorEnum::None, "RST V=5" },
+        // Arguments are split at commas with the spaces around them dropped, and a leading '+' is skipped.
+        { "CONF 1, 2.5 ,-3,+4", 0, 1, scpiErrorEnum::None, "CONF[4] 1/1 2/2.5 -3/-3 4/4" },
+        { "CONF ON,+,-,+1.5", 0, 1, scpiErrorEnum::None, "CONF[4] 'ON' '+' '-' 1/1.5" },
+        { "CONF 1,2,3,4,5,6", 0, 1, scpiErrorEnum::None, "CONF[4] 1/1 2/2 3/3 4/4" },
+        { "CONF", 0, 1, scpiErrorEnum::None, "CONF[0]" },
+        { "SOUR:CURR +12", 0, 1, scpiErrorEnum::None, "I=12" },
+        { "SOUR:VOLT +7.25", 0, 1, scpiErrorEnum::None, "V=7.25" },
+        { "#SOUR:VOLT 8", 1, 1, scpiErrorEnum::None, "V=8" },
+        // Each error.
+        { "SOUR:CURR?", 0, 0, scpiErrorEnum::NotAQuery, "" },
+        { "MEAS:CURR 1", 0, 0, scpiErrorEnum::QueryOnly, "" },
+        { "*IDN", 0, 0, scpiErrorEnum::QueryOnly, "" },
+        { "SOUR:VOLT x", 0, 0, scpiErrorEnum::BadParameter, "" },
+        { "SOUR:VOLT 1,2", 0, 0, scpiErrorEnum::BadParameter, "" },
+        { "SOUR:VOLT 1;VOLT +;VOLT 3", 0, 1, scpiErrorEnum::BadParameter, "V=1" },
+        { "SOUR:POW 1", 0, 0, scpiErrorEnum::UndefinedHeader, "" },
+    };
+    for(const Case& c : cases){
+        calls[0] = '\0';
+        sc.loadMsg(c.message, strlen(c.message));
+        uint8_t run = scpi.handle(c.startIndex);
+        bool ok = run == c.run && scpi.getLastError() == c.error && strcmp(calls, c.calls) == 0;
+        printf("%-4s %-32s run %u, %-15s %s\n", ok ? "ok" : "FAIL", c.message, run, errorNames[(int)scpi.getLastError()], calls);
+        if(!ok){
+            printf("     expected run %u, %s, %s\n", c.run, errorNames[(int)c.error], c.calls);
+            failures++;
+        }
+    }
+    printf("%s\n", failures ? "FAILED" : "all messages handled as expected");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * @brief      Runs SerialCheckerHub against simulated devices on pty pairs to measure how many messages per second it can handle. Each simulated device streams checksummed "V<n>" messages as fast as the pty allows. The handler parses the number and then does a configurable amount of extra work to stand in for real message handling, so the effect of more workers can be seen.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -pthread -I.. ../SerialChecker.cpp ../PosixSerial.cpp SerialCheckerHub.cpp hub_pty_demo.cpp -o hub_pty_demo
+ *
+ *              Usage: hub_pty_demo [devices] [workers] [messages per device] [work per message]
+ */
+#include "SerialCheckerHub.h"
+
+#include<fcntl.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+
+struct DemoState{
+    uint64_t expected;
+    uint32_t workPerMessage;
+    std::atomic<uint64_t> handled;
+    std::atomic<uint64_t> badValues;
+};
+
+static void handleMessage(SerialCheckerHub& hub, const HubFrame&, SerialChecker& parser, void* context){
+    DemoState* state = (DemoState*)context;
+    uint32_t value = parser.toInt32();
+    // stand in for real work done with the message
+    volatile uint32_t x = value;
+    for(uint32_t i = 0; i < state->workPerMessage; i++){
+        x = x * 1664525 + 1013904223;
+    }
+    if(!parser.contains('V')){
+        state->badValues++;
+    }
+    if(++state->handled == state->expected){
+        hub.stop();
+    }
+}
+
+static void simulateDevices(std::vector<PosixSerial*>* ports, uint32_t messages){
+    std::vector<SerialChecker*> devices;
+    for(PosixSerial* port : *ports){
+        SerialChecker* device = new SerialChecker(*port);
+        device->init();
+        device->enableChecksum();
+        devices.push_back(device);
+    }
+    char message[16];
+    for(uint32_t n = 0; n < messages; n++){
+        snprintf(message, sizeof(message), "V%u", n);
+        for(SerialChecker* device : devices){
+            device->sendFrame(message);
+        }
+    }
+    for(SerialChecker* device : devices){
+        delete device;
+    }
+}
+
+int main(int argc, char** argv){
+    unsigned deviceCount = argc > 1 ? atoi(argv[1]) : 200;
+    unsigned workerCount = argc > 2 ? atoi(argv[2]) : 0;
+    uint32_t messages = argc > 3 ? atoi(argv[3]) : 2000;
+    DemoState state;
+    state.expected = (uint64_t)deviceCount * messages;
+    state.workPerMessage = argc > 4 ? atoi(argv[4]) : 2000;
+    state.handled = 0;
+    state.badValues = 0;
+
+    SerialCheckerHub hub(workerCount, handleMessage, &state);
+    std::vector<PosixSerial*> hubPorts;
+    const unsigned simulatorThreads = 4;
+    std::vector<PosixSerial*> devicePorts[simulatorThreads];
+    for(unsigned i = 0; i < deviceCount; i++){
+        int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+        if(masterFd < 0 || grantpt(masterFd) || unlockpt(masterFd)){
+            perror("posix_openpt");
+            return 1;
+        }
+        PosixSerial* devicePort = new PosixSerial(ptsname(masterFd));
+        PosixSerial* hubPort = new PosixSerial(masterFd);
+        hubPorts.push_back(hubPort);
+        devicePorts[i % simulatorThreads].push_back(devicePort);
+        int d = hub.addDevice(*hubPort);
+        hub.getChecker(d).enableChecksum();
+    }
+
+    uint32_t start = micros();
+    std::vector<std::thread> simulators;
+    for(unsigned i = 0; i < simulatorThreads; i++){
+        simulators.push_back(std::thread(simulateDevices, &devicePorts[i], messages));
+    }
+    hub.run();
+    uint32_t elapsed = micros() - start;
+    for(std::thread& simulator : simulators){
+        simulator.join();
+    }
+
+    uint64_t latencySum = 0;
+    uint32_t latencyMax = 0;
+    uint64_t tooLong = 0;
+    uint64_t slowest = UINT64_MAX;
+    for(unsigned d = 0; d < hub.getDeviceCount(); d++){
+        HubDeviceStats stats = hub.getStats(d);
+        latencySum += stats.latencySumMicros;
+        tooLong += stats.tooLong;
+        if(stats.latencyMaxMicros > latencyMax){
+            latencyMax = stats.latencyMaxMicros;
+        }
+        if(stats.frames < slowest){
+            slowest = stats.frames;
+        }
+    }
+    uint64_t total = hub.getTotalFrames();
+    printf("devices %u, workers %u, messages %llu, bad %llu, too long %llu\n", deviceCount, workerCount, (unsigned long long)total, (unsigned long long)state.badValues, (unsigned long long)tooLong);
+    printf("%.0f messages/s, mean latency %.1f us, max latency %u us, fewest from one device %llu\n",
+        total * 1e6 / elapsed, total ? (double)latencySum / total : 0.0, latencyMax, (unsigned long long)slowest);
+
+    for(unsigned i = 0; i < simulatorThreads; i++){
+        for(PosixSerial* port : devicePorts[i]){
+            delete port;
+        }
+    }
+    for(PosixSerial* port : hubPorts){
+        close(port->getFd());
+        delete port;
+    }
+    return total == state.expected ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+/**
+ * @brief      Runs SerialCheckerARQ over a simulated lossy serial link. Two pty pairs are joined by a relay thread that paces the bytes to a baud rate, adds a fixed delay each way and drops or corrupts bytes at random. Only the bottom 7 bits are ever flipped because the readable checksum only covers those; see host/bench_noisy.cpp for how often other damage gets through. No STX char is used because a readable checksum char can match it, and then the message would be lost every time it was sent again. The sender streams numbered messages through the link and the receiver checks that every one arrives, in order and once. Stop-and-wait (a window of 1) is run first for comparison, and a window of 5 last, which is rounded down to 4 so that the sequence numbers, wrapping at 128, still land in different slots.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -pthread -I.. ../SerialChecker.cpp ../SerialCheckerARQ.cpp ../PosixSerial.cpp pty_arq.cpp -o pty_arq
+ *
+ *              Usage: pty_arq [messages] [window] [byte error rate] [delay us] [baud]
+ */
+#include "SerialCheckerARQ.h"
+
+#include<fcntl.h>
+#include<poll.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<unistd.h>
+
+#include<atomic>
+#include<deque>
+#include<thread>
+
+#define PTY_ARQ_MSG_MAX_LEN 16
+
+struct DelayedByte{
+    char c;
+    uint32_t due;
+};
+
+struct LinkSettings{
+    double errorRate;
+    uint32_t delay;
+    uint32_t byteTime;
+};
+
+static int openMaster(){
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(fd < 0 || grantpt(fd) || unlockpt(fd)){
+        perror("posix_openpt");
+        exit(1);
+    }
+    return fd;
+}
+
+/**
+ * @brief      Moves bytes between the two pty masters. Each byte is dropped or has a bit flipped with a chance of errorRate, half and half, and is otherwise passed on after the delay, no faster than the baud rate allows.
+ */
+static void relay(int fdA, int fdB, LinkSettings link, std::atomic<bool>* running){
+    PosixSerial portA(fdA);
+    PosixSerial portB(fdB);
+    PosixSerial* ports[2] = { &portA, &portB };
+    portA.begin(115200); // raw and non-blocking
+    portB.begin(115200);
+    std::deque<DelayedByte> queues[2]; // queues[0] goes from A to B
+    uint32_t lastDue[2] = { 0, 0 };
+    uint32_t seed = 2463534242u;
+    while(*running){
+        struct pollfd fds[2] = { { fdA, POLLIN, 0 }, { fdB, POLLIN, 0 } };
+        poll(fds, 2, queues[0].empty() && queues[1].empty() ? 10 : 0);
+        uint32_t now = micros();
+        for(int d = 0; d < 2; d++){
+            while(ports[d]->available()){
+                char c = ports[d]->read();
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                double r = seed / 4294967296.0;
+                if(r < link.errorRate / 2){
+                    continue;
+                }
+                if(r < link.errorRate){
+                    c ^= 1 << (seed % 7); // not the top bit, which the checksum ignores, so that every damaged message is caught and this only tests the ARQ
+                }
+                uint32_t due = now + link.delay;
+                if((int32_t)(due - lastDue[d]) < (int32_t)link.byteTime){
+                    due = lastDue[d] + link.byteTime;
+                }
+                lastDue[d] = due;
+                queues[d].push_back({ c, due });
+            }
+            char out[256];
+            size_t len = 0;
+            while(!queues[d].empty() && (int32_t)(now - queues[d].front().due) >= 0 && len < sizeof(out)){
+                out[len++] = queues[d].front().c;
+                queues[d].pop_front();
+            }
+            if(len){
+                ports[1 - d]->write(out, len);
+            }
+        }
+        if(!queues[0].empty() || !queues[1].empty()){
+            usleep(100);
+        }
+    }
+}
+
+static void drain(PosixSerial& port){
+    while(port.waitReadable(50)){
+        while(port.available()){
+            port.read();
+        }
+    }
+}
+
+/**
+ * @brief      Sends the messages with the given window and checks what arrives.
+ *
+ * @return     True if every message arrived once and in order.
+ */
+static bool run(PosixSerial& senderPort, PosixSerial& receiverPort, uint32_t messages, uint8_t window, uint16_t timeout, double lineRate){
+    SerialChecker sender(PTY_ARQ_MSG_MAX_LEN + 3, senderPort, 115200);
+    SerialChecker receiver(PTY_ARQ_MSG_MAX_LEN + 3, receiverPort, 115200);
+    SerialChecker* checkers[2] = { &sender, &receiver };
+    for(SerialChecker* checker : checkers){
+        checker->init();
+        checker->enableChecksum();
+        checker->enableAckNak();
+    }
+    SerialCheckerARQ senderARQ(sender, window, PTY_ARQ_MSG_MAX_LEN);
+    SerialCheckerARQ receiverARQ(receiver, window, PTY_ARQ_MSG_MAX_LEN);
+    senderARQ.setTimeout(timeout);
+    receiverARQ.setTimeout(timeout);
+
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t wrong = 0;
+    uint32_t start = micros();
+    uint32_t lastProgress = millis();
+    char message[PTY_ARQ_MSG_MAX_LEN + 1];
+    while(received < messages && millis() - lastProgress < 5000){
+        while(sent < messages && senderARQ.canSend()){
+            snprintf(message, sizeof(message), "W%u", sent);
+            senderARQ.send(message);
+            sent++;
+        }
+        while(receiverARQ.check()){
+            if(!receiver.contains('W') || receiver.toInt32() != received){
+                wrong++;
+            }
+            received++;
+            lastProgress = millis();
+        }
+        senderARQ.check();
+        struct pollfd fds[2] = { { senderPort.getFd(), POLLIN, 0 }, { receiverPort.getFd(), POLLIN, 0 } };
+        poll(fds, 2, 1);
+    }
+    double elapsed = (micros() - start) / 1e6;
+    printf("window %2u (%2u used): %u of %u received, %u wrong, %.0f messages/s (%.0f%% of line rate), %u retransmits, %u duplicates\n", window, senderARQ.getWindow(), received, messages, wrong,
+        received / elapsed, 100.0 * received / elapsed / lineRate, senderARQ.getRetransmitCount(), receiverARQ.getDuplicateCount());
+    // let the last Acks and retransmits die away before the next run
+    while(senderARQ.getInFlight() && millis() - lastProgress < 5000){
+        senderARQ.check();
+        receiverARQ.check();
+        senderPort.waitReadable(1);
+    }
+    drain(senderPort);
+    drain(receiverPort);
+    return received == messages && wrong == 0;
+}
+
+int main(int argc, char** argv){
+    uint32_t messages = argc > 1 ? atoi(argv[1]) : 1000;
+    uint8_t window = argc > 2 ? atoi(argv[2]) : 16;
+    LinkSettings link;
+    link.errorRate = argc > 3 ? atof(argv[3]) : 0.001;
+    link.delay = argc > 4 ? atoi(argv[4]) : 5000;
+    uint32_t baud = argc > 5 ? atoi(argv[5]) : 115200;
+    link.byteTime = 10000000 / baud;
+
+    int masterA = openMaster();
+    int masterB = openMaster();
+    PosixSerial senderPort(ptsname(masterA));
+    PosixSerial receiverPort(ptsname(masterB));
+    if(!senderPort.isOpen() || !receiverPort.isOpen()){
+        perror("open pty slave");
+        return 1;
+    }
+    std::atomic<bool> running(true);
+    std::thread relayThread(relay, masterA, masterB, link, &running);
+
+    // A frame is two sequence digits, the message, checksum and ETX.
+    double frameBytes = 2 + 5 + 1 + 1;
+    double lineRate = baud / 10.0 / frameBytes;
+    // Enough time to send a whole window and get its Acks back.
+    uint16_t timeout = (2 * link.delay + window * frameBytes * 2 * link.byteTime) / 1000 + 20;
+    printf("%u messages, byte error rate %g, %u us each way, %u baud, %u ms timeout\n", messages, link.errorRate, link.delay, baud, timeout);
+    bool ok = run(senderPort, receiverPort, messages / 10, 1, timeout, lineRate);
+    ok &= run(senderPort, receiverPort, messages, window, timeout, lineRate);
+    ok &= run(senderPort, receiverPort, messages, 5, timeout, lineRate);
+    running = false;
+    relayThread.join();
+    return ok ? 0 : 1;
+}
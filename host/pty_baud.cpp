@@ -0,0 +1,232 @@
+/**
+ * @brief      Runs SerialCheckerBaud between a host and a node over a simulated cable. Each end has its own pty pair and a relay thread joins them. The relay reads each end's line speed from its pty, so bytes only get through when both ends are at the same rate, and they take one byte time each at that rate. Above the cable's limit, 1 Mbaud, bytes are corrupted. The node streams readings at whatever rate it is at, and the host steps the rate up, measuring the throughput at each one.
+ *
+ *              The node accepts every rate up to 2 Mbaud apart from 500000, so the run shows rates that work, one that is refused and one the probe finds too fast for the cable, after which both ends go back to the rate before.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -pthread -I.. ../SerialChecker.cpp ../PosixSerial.cpp ../SerialCheckerBaud.cpp pty_baud.cpp -o pty_baud
+ *
+ *              Usage: pty_baud [seconds per rate]
+ */
+#include "SerialCheckerBaud.h"
+
+#include<fcntl.h>
+#include<poll.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<termios.h>
+#include<unistd.h>
+
+#include<atomic>
+#include<deque>
+#include<thread>
+
+#define PTY_BAUD_CABLE_LIMIT 1000000
+
+static int openMaster(char* path, size_t pathLen){
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(fd < 0 || grantpt(fd) || unlockpt(fd)){
+        perror("posix_openpt");
+        exit(1);
+    }
+    snprintf(path, pathLen, "%s", ptsname(fd));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+/**
+ * @brief      The line speed one end has set on its pty, read through the master side.
+ */
+static uint32_t lineSpeed(int masterFd){
+    struct termios tio;
+    if(tcgetattr(masterFd, &tio) != 0){
+        return 0;
+    }
+    switch(cfgetospeed(&tio)){
+        case B9600: return 9600;
+        case B19200: return 19200;
+        case B38400: return 38400;
+        case B57600: return 57600;
+        case B115200: return 115200;
+        case B230400: return 230400;
+        case B460800: return 460800;
+        case B500000: return 500000;
+        case B921600: return 921600;
+        case B1000000: return 1000000;
+        case B2000000: return 2000000;
+        default: return 0;
+    }
+}
+
+struct Lane{
+    int from;
+    int to;
+    struct Pending{
+        char c;
+        uint32_t rate; // the sender's rate when it was sent
+        uint32_t due;
+    };
+    std::deque<Pending> line;
+    uint32_t lineFree;
+    uint32_t rate; // the sender's rate when the relay last looked
+};
+
+/**
+ * @brief      Moves bytes from one end to the other at the sender's rate. A byte arrives as sent only if the receiver is at the same rate, and above the cable limit 1 in 4 is corrupted.
+ */
+static void relayLane(Lane& lane, uint32_t& seed){
+    char buffer[256];
+    uint32_t now = micros();
+    // A pty has no transmit time, so flush() returns at once and an end can change its rate before the relay has read what it sent at the old rate. Bytes waiting when a change is first seen are taken as sent at the old rate.
+    uint32_t rate = lane.rate;
+    lane.rate = lineSpeed(lane.from);
+    ssize_t len = read(lane.from, buffer, sizeof(buffer));
+    if(len > 0){
+        uint32_t byteTime = rate ? 10000000 / rate : 100;
+        for(ssize_t i = 0; i < len; i++){
+            if((int32_t)(now - lane.lineFree) > 0){
+                lane.lineFree = now;
+            }
+            lane.lineFree += byteTime;
+            lane.line.push_back({ buffer[i], rate, lane.lineFree });
+        }
+    }
+    while(!lane.line.empty() && (int32_t)(now - lane.line.front().due) >= 0){
+        char c = lane.line.front().c;
+        uint32_t sent = lane.line.front().rate;
+        seed = seed * 1664525 + 1013904223;
+        if(sent != lineSpeed(lane.to)){
+            c = seed >> 24; // framing errors at the wrong rate
+        }
+        else if(sent > PTY_BAUD_CABLE_LIMIT && (seed >> 16) % 4 == 0){
+            c ^= 1 << ((seed >> 8) % 8);
+        }
+        if(write(lane.to, &c, 1) < 0){
+            perror("write");
+        }
+        lane.line.pop_front();
+    }
+}
+
+static void relay(int hostFd, int nodeFd, std::atomic<bool>* running){
+    Lane toNode = { hostFd, nodeFd, {}, micros(), lineSpeed(hostFd) };
+    Lane toHost = { nodeFd, hostFd, {}, micros(), lineSpeed(nodeFd) };
+    uint32_t seed = 1;
+    struct pollfd fds[2] = { { hostFd, POLLIN, 0 }, { nodeFd, POLLIN, 0 } };
+    while(*running){
+        poll(fds, 2, toNode.line.empty() && toHost.line.empty() ? 5 : 0);
+        relayLane(toNode, seed);
+        relayLane(toHost, seed);
+        if(!toNode.line.empty() || !toHost.line.empty()){
+            usleep(20);
+        }
+    }
+}
+
+static void setupChecker(SerialChecker& checker){
+    checker.init();
+    checker.enableSTX(true);
+    checker.enableChecksum();
+    checker.setChecksumType(checksumTypeEnum::SpellmanMPS); // never '$', see host/bench_noisy.cpp
+}
+
+/**
+ * @brief      The node: answers negotiations and streams readings at about 90% of whatever rate it is at.
+ */
+static void simulateNode(const char* path, std::atomic<bool>* running){
+    static const uint32_t rates[] = { 115200, 230400, 460800, 921600, 1000000, 2000000 };
+    PosixSerial port(path);
+    SerialChecker checker(48, port, 115200);
+    setupChecker(checker);
+    SerialCheckerBaud baud(checker);
+    baud.setRates(rates, sizeof(rates) / sizeof(rates[0]));
+    baud.setTimeouts(100, 10, 3, 2000);
+    char reading[40];
+    uint32_t count = 0;
+    uint32_t nextSend = micros();
+    while(*running){
+        port.waitReadable(0);
+        while(checker.check()){
+            baud.handle();
+        }
+        baud.update();
+        if((int32_t)(micros() - nextSend) >= 0){
+            int len = snprintf(reading, sizeof(reading), "R%08u,0123456789ABCDEFGHIJKLMNOP", count++);
+            checker.sendFrame(reading);
+            // STX, checksum and ETX on top of the message, 10 bits a byte.
+            nextSend += (len + 3) * 10000000ull / checker.getBaudrate() * 10 / 9;
+            if((int32_t)(micros() - nextSend) > 100000){
+                nextSend = micros();
+            }
+        }
+        usleep(20);
+    }
+}
+
+static const char* resultName(baudResultEnum result){
+    switch(result){
+        case baudResultEnum::Switched: return "switched";
+        case baudResultEnum::Refused: return "refused";
+        case baudResultEnum::NoAnswer: return "no answer";
+        case baudResultEnum::ProbeFailed: return "probe failed, back to the old rate";
+        case baudResultEnum::LinkLost: return "link lost";
+        default: return "";
+    }
+}
+
+/**
+ * @brief      Runs the host side for a while, handing every message to baud.
+ */
+static void runHost(PosixSerial& port, SerialChecker& checker, SerialCheckerBaud& baud, uint32_t millisToRun){
+    uint32_t start = millis();
+    while(millis() - start < millisToRun){
+        port.waitReadable(1);
+        while(checker.check()){
+            baud.handle();
+        }
+        baud.update();
+    }
+}
+
+int main(int argc, char** argv){
+    uint32_t seconds = argc > 1 ? atoi(argv[1]) : 1;
+    char hostPath[64];
+    char nodePath[64];
+    int hostFd = openMaster(hostPath, sizeof(hostPath));
+    int nodeFd = openMaster(nodePath, sizeof(nodePath));
+    std::atomic<bool> running(true);
+    PosixSerial port(hostPath);
+    SerialChecker checker(48, port, 115200);
+    setupChecker(checker);
+    std::thread node(simulateNode, nodePath, &running);
+    std::thread line(relay, hostFd, nodeFd, &running);
+    SerialCheckerBaud baud(checker);
+    baud.setTimeouts(100, 10, 3, 2000);
+    runHost(port, checker, baud, 200); // let the node start
+
+    static const uint32_t proposals[] = { 230400, 460800, 500000, 921600, 2000000 };
+    bool ok = true;
+    printf("%-10s %-36s %10s %12s %12s\n", "proposed", "result", "now at", "bytes/s", "line bytes/s");
+    for(uint32_t proposed : proposals){
+        baud.propose(proposed);
+        while(baud.getState() != baudStateEnum::Idle){
+            runHost(port, checker, baud, 1);
+        }
+        baudResultEnum result = baud.getLastResult();
+        runHost(port, checker, baud, seconds * 1000);
+        uint32_t rate = checker.getBaudrate();
+        printf("%-10u %-36s %10u %12u %12u\n", proposed, resultName(result), rate, baud.getBytesPerSecond(), rate / 10);
+        bool expected = proposed == 500000 ? result == baudResultEnum::Refused : proposed > PTY_BAUD_CABLE_LIMIT ? result == baudResultEnum::ProbeFailed : result == baudResultEnum::Switched;
+        ok &= expected && baud.getBytesPerSecond() > 0;
+    }
+    BaudStats stats = baud.getStats();
+    printf("\n%u proposals, %u switched, %u refused, %u fallbacks, %u link lost\n", stats.proposals, stats.switched, stats.refused, stats.fallbacks, stats.linkLost);
+
+    running = false;
+    node.join();
+    line.join();
+    close(hostFd);
+    close(nodeFd);
+    return ok ? 0 : 1;
+}
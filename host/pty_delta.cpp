@@ -0,0 +1,141 @@
+/**
+ * @brief      Streams four slowly changing readings over a pty pair, once as full ASCII numbers and once with SerialCheckerDeltaEncoder, and compares the bytes each takes per sample. The readings are scaled integers: a temperature in hundredths of a degree, a pressure in tenths of a pascal, a flow in thousandths and a level in tenths that now and then jumps.
+ *
+ *              Every so often a delta frame is dropped before it is sent, to show the decoder noticing the gap and picking up again at the next keyframe. Every set of readings the decoder gives back must match the one sent.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../PosixSerial.cpp ../SerialCheckerDelta.cpp pty_delta.cpp -o pty_delta
+ *
+ *              Usage: pty_delta [samples] [keyframe interval]
+ */
+#include "SerialCheckerDelta.h"
+
+#include<fcntl.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#define PTY_DELTA_CHANNELS 4
+#define PTY_DELTA_DROP_EVERY 97
+
+static const int32_t scales[PTY_DELTA_CHANNELS] = { 100, 10, 1000, 10 };
+
+/**
+ * @brief      The next set of readings, each a small random walk.
+ */
+static void nextReadings(int32_t* readings, uint32_t& seed){
+    static const int32_t steps[PTY_DELTA_CHANNELS] = { 3, 20, 5, 2 };
+    for(uint8_t i = 0; i < PTY_DELTA_CHANNELS; i++){
+        seed = seed * 1664525 + 1013904223;
+        readings[i] += (int32_t)((seed >> 16) % (2 * steps[i] + 1)) - steps[i];
+    }
+    if((seed >> 8) % 200 == 0){
+        readings[3] += 5000; // a tank being filled
+    }
+}
+
+/**
+ * @brief      The readings as they were sent before: T then the numbers with their decimals, separated by commas.
+ */
+static uint8_t formatAscii(const int32_t* readings, char* out){
+    uint8_t len = 0;
+    out[len++] = 'T';
+    for(uint8_t i = 0; i < PTY_DELTA_CHANNELS; i++){
+        if(i){
+            out[len++] = ',';
+        }
+        len += SerialChecker::formatScaled(readings[i], scales[i], &out[len]);
+    }
+    out[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief      Waits for the frame just sent and decodes it if it is telemetry. Returns its bytes, counting STX, checksum and ETX.
+ */
+static uint32_t receiveFrame(PosixSerial& port, SerialChecker& host, SerialCheckerDeltaDecoder& decoder, const int32_t* sent, uint32_t& decoded, bool& ok){
+    while(port.waitReadable(100)){
+        if(host.check()){
+            int32_t readings[PTY_DELTA_CHANNELS];
+            if(decoder.isTelemetry(host.getMsg()) && decoder.receive(host, readings)){
+                decoded++;
+                ok &= memcmp(readings, sent, sizeof(readings)) == 0;
+            }
+            return host.getRawMsgLen() + 2;
+        }
+    }
+    ok = false; // timed out
+    return 0;
+}
+
+int main(int argc, char** argv){
+    uint32_t samples = argc > 1 ? atoi(argv[1]) : 2000;
+    uint8_t keyframeInterval = argc > 2 ? atoi(argv[2]) : 50;
+    int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(masterFd < 0 || grantpt(masterFd) || unlockpt(masterFd)){
+        perror("posix_openpt");
+        return 1;
+    }
+    PosixSerial hostPort(masterFd);
+    PosixSerial nodePort(ptsname(masterFd));
+    if(!nodePort.isOpen()){
+        perror("open pty slave");
+        return 1;
+    }
+    SerialChecker host(64, hostPort, 115200);
+    SerialChecker node(64, nodePort, 115200);
+    host.init();
+    node.init();
+    host.enableSTX(true);
+    node.enableSTX(true);
+    host.enableChecksum();
+    node.enableChecksum();
+    host.setChecksumType(checksumTypeEnum::SpellmanMPS); // never '$', see host/bench_noisy.cpp
+    node.setChecksumType(checksumTypeEnum::SpellmanMPS);
+
+    SerialCheckerDeltaEncoder encoder(PTY_DELTA_CHANNELS, keyframeInterval);
+    SerialCheckerDeltaDecoder decoder(PTY_DELTA_CHANNELS);
+    int32_t readings[PTY_DELTA_CHANNELS] = { 2250, 1013250, 1234, 4560 };
+    uint32_t seed = 1;
+    uint32_t asciiBytes = 0;
+    uint32_t deltaBytes = 0;
+    uint32_t asciiDecoded = 0; // not telemetry, so never decoded
+    uint32_t decoded = 0;
+    uint32_t dropped = 0;
+    bool ok = true;
+    char frame[SERIALCHECKER_FRAME_BUFFER_LEN];
+    char deltaFrame[SERIALCHECKERDELTA_MAX_LEN(PTY_DELTA_CHANNELS) + 1];
+
+    // Full ASCII numbers first.
+    uint32_t start = micros();
+    for(uint32_t i = 0; i < samples; i++){
+        nextReadings(readings, seed);
+        formatAscii(readings, frame);
+        node.sendFrame(frame);
+        asciiBytes += receiveFrame(hostPort, host, decoder, readings, asciiDecoded, ok);
+    }
+    uint32_t asciiMicros = micros() - start;
+
+    // Then the same kind of readings as deltas.
+    start = micros();
+    for(uint32_t i = 1; i <= samples; i++){
+        nextReadings(readings, seed);
+        encoder.encode(readings, deltaFrame);
+        if(i % PTY_DELTA_DROP_EVERY == 0){
+            dropped++; // lost on the way
+            continue;
+        }
+        node.sendFrame(deltaFrame);
+        deltaBytes += receiveFrame(hostPort, host, decoder, readings, decoded, ok);
+    }
+    uint32_t deltaMicros = micros() - start;
+
+    printf("%u samples of %u channels, keyframe every %u frames\n", samples, PTY_DELTA_CHANNELS, keyframeInterval);
+    printf("%-8s %12s %16s %12s\n", "", "bytes", "bytes/sample", "us");
+    printf("%-8s %12u %16.2f %12u\n", "ascii", asciiBytes, (double)asciiBytes / samples, asciiMicros);
+    printf("%-8s %12u %16.2f %12u\n", "delta", deltaBytes, (double)deltaBytes / (samples - dropped), deltaMicros);
+    printf("%.2f times fewer bytes\n", (double)asciiBytes / samples / ((double)deltaBytes / (samples - dropped)));
+    printf("%u frames dropped, %u lost as seen by the decoder, %u decoded, %u skipped until a keyframe\n", dropped, decoder.getLostCount(), decoded, samples - dropped - decoded);
+    printf("%s\n", ok && decoder.getLostCount() == dropped ? "all decoded readings match" : "MISMATCH");
+    return ok && decoder.getLostCount() == dropped ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+/**
+ * @brief      Example of the PosixSerial host backend. A pty pair stands in for a USB serial cable: one SerialChecker plays the arduino on the slave end and another plays the PC on the master end. No hardware is needed.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../PosixSerial.cpp pty_loopback.cpp -o pty_loopback
+ */
+#include "SerialChecker.h"
+
+#include<fcntl.h>
+#include<stdio.h>
+#include<stdlib.h>
+
+int main(){
+    int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(masterFd < 0 || grantpt(masterFd) || unlockpt(masterFd)){
+        perror("posix_openpt");
+        return 1;
+    }
+    PosixSerial pcPort(masterFd);
+    PosixSerial arduinoPort(ptsname(masterFd));
+    if(!arduinoPort.isOpen()){
+        perror("open pty slave");
+        return 1;
+    }
+
+    SerialChecker pc(pcPort);
+    SerialChecker arduino(arduinoPort);
+    pc.init();
+    arduino.init();
+    pc.enableChecksum();
+    arduino.enableChecksum();
+    arduino.enableAckNak();
+    arduino.setMsgMaxLen(32);
+    pc.setMsgMaxLen(32);
+
+    const int frames = 10000;
+    int acked = 0;
+    char command[16];
+    for(int i = 0; i < frames; i++){
+        snprintf(command, sizeof(command), "V%d", i % 1000);
+        pc.sendFrame(command);
+        while(!arduino.check()){
+            arduinoPort.waitReadable(1000);
+        }
+        if(arduino.contains('V') && arduino.toInt16() == i % 1000){
+            arduino.sendAck();
+        }
+        else{
+            arduino.sendNak();
+        }
+        // The arduino replies with println() so the \r is dropped by the pc's checker.
+        pc.disableChecksum();
+        while(!pc.check()){
+            pcPort.waitReadable(1000);
+        }
+        pc.enableChecksum();
+        if(pc.contains('A')){
+            acked++;
+        }
+    }
+    printf("%d of %d frames acknowledged\n", acked, frames);
+    return acked == frames ? 0 : 1;
+}
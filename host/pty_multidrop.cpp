@@ -0,0 +1,260 @@
+/**
+ * @brief      Runs SerialCheckerBusMaster against a simulated RS-485 bus. Every node is a thread with its own pty pair and a SerialChecker filtering on its address, see SerialChecker::setAddressFilter(). A relay thread joins the master's pty to all of the nodes' as one half duplex line: whatever the master sends reaches every node, replies reach the master, and only one byte is on the line at a time at the baud rate. Each node answers after its own processing time, a few nodes never answer and one only starts answering half way through.
+ *              The same traffic is run twice: first polling the nodes in turn with one fixed timeout, then with per node poll intervals and priorities, timeouts from the measured response times and backoff for dead nodes.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -pthread -I.. ../SerialChecker.cpp ../PosixSerial.cpp SerialCheckerBusMaster.cpp pty_multidrop.cpp -o pty_multidrop
+ *
+ *              Usage: pty_multidrop [nodes] [seconds] [baud]
+ */
+#include "SerialCheckerBusMaster.h"
+
+#include<fcntl.h>
+#include<poll.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+
+#include<atomic>
+#include<deque>
+#include<thread>
+#include<vector>
+
+#define PTY_MULTIDROP_ADDRESS_LEN 2
+
+struct SimNode{
+    char address[PTY_MULTIDROP_ADDRESS_LEN + 1];
+    uint32_t responseMicros; // 0 never answers
+    uint32_t wakeMillis; // answers only after this long
+    int relayFd;
+    char path[64]; // of the node's end of its pty pair
+    std::thread thread;
+};
+
+struct PollResults{
+    std::vector<uint64_t> replies;
+    uint64_t wrong = 0;
+};
+
+static int openMaster(){
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(fd < 0 || grantpt(fd) || unlockpt(fd)){
+        perror("posix_openpt");
+        exit(1);
+    }
+    return fd;
+}
+
+static void makeAddress(uint32_t node, char* address){
+    snprintf(address, PTY_MULTIDROP_ADDRESS_LEN + 1, "%02u", node);
+}
+
+static void setupChecker(SerialChecker& checker){
+    checker.init();
+    checker.enableSTX(true);
+    checker.enableChecksum();
+    checker.setChecksumType(checksumTypeEnum::SpellmanMPS); // never '$', see host/bench_noisy.cpp
+    checker.setAddressLen(PTY_MULTIDROP_ADDRESS_LEN);
+}
+
+/**
+ * @brief      A node: answers each poll with its address and a reading after its response time, plus up to 25% jitter.
+ */
+static void simulateNode(SimNode* node, uint32_t start, std::atomic<bool>* running){
+    PosixSerial port(node->path);
+    SerialChecker checker(32, port, 115200);
+    setupChecker(checker);
+    checker.setAddressFilter(node->address);
+    uint32_t seed = node->address[0] * 31 + node->address[1];
+    uint32_t due = 0;
+    bool pending = false;
+    uint32_t reading = 0;
+    char reply[16];
+    while(*running){
+        port.waitReadable(pending ? 0 : 5);
+        while(checker.check()){
+            if(node->responseMicros && millis() - start >= node->wakeMillis){
+                seed = seed * 1664525 + 1013904223;
+                due = micros() + node->responseMicros + (seed >> 8) % (node->responseMicros / 4 + 1);
+                pending = true;
+            }
+        }
+        if(pending && (int32_t)(micros() - due) >= 0){
+            snprintf(reply, sizeof(reply), "%sV%u", node->address, reading++);
+            checker.sendFrame(reply);
+            pending = false;
+        }
+        if(pending){
+            usleep(50);
+        }
+    }
+}
+
+/**
+ * @brief      The shared line. Bytes from the master go to every node and bytes from any node go to the master, one byte time each, in the order they were written.
+ */
+static void relay(int masterFd, std::vector<SimNode*>* nodes, uint32_t byteTime, std::atomic<bool>* running){
+    std::vector<struct pollfd> fds;
+    fds.push_back({ masterFd, POLLIN, 0 });
+    for(SimNode* node : *nodes){
+        fds.push_back({ node->relayFd, POLLIN, 0 });
+    }
+    struct Pending{
+        char c;
+        bool toNodes;
+        uint32_t due;
+    };
+    std::deque<Pending> line;
+    uint32_t lineFree = micros();
+    char buffer[256];
+    while(*running){
+        poll(fds.data(), fds.size(), line.empty() ? 5 : 0);
+        uint32_t now = micros();
+        for(size_t i = 0; i < fds.size(); i++){
+            if(!(fds[i].revents & POLLIN)){
+                continue;
+            }
+            ssize_t len = read(fds[i].fd, buffer, sizeof(buffer));
+            for(ssize_t j = 0; j < len; j++){
+                if((int32_t)(now - lineFree) > 0){
+                    lineFree = now;
+                }
+                lineFree += byteTime;
+                line.push_back({ buffer[j], i == 0, lineFree });
+            }
+        }
+        while(!line.empty() && (int32_t)(now - line.front().due) >= 0){
+            if(line.front().toNodes){
+                for(SimNode* node : *nodes){
+                    if(write(node->relayFd, &line.front().c, 1) < 0){
+                        perror("write");
+                    }
+                }
+            }
+            else if(write(masterFd, &line.front().c, 1) < 0){
+                perror("write");
+            }
+            line.pop_front();
+        }
+        if(!line.empty()){
+            usleep(20);
+        }
+    }
+}
+
+static void handleReply(SerialCheckerBusMaster&, uint16_t node, SerialChecker& checker, void* context){
+    PollResults* results = (PollResults*)context;
+    if(!checker.contains('V')){
+        results->wrong++;
+    }
+    results->replies[node]++;
+}
+
+/**
+ * @brief      Polls the nodes for the given time and prints what each one got.
+ *
+ * @return     The number of replies.
+ */
+static uint64_t run(const char* name, PosixSerial& port, std::vector<SimNode*>& nodes, uint32_t seconds, bool scheduled){
+    SerialChecker checker(32, port, 115200);
+    setupChecker(checker);
+    PollResults results;
+    results.replies.resize(nodes.size());
+    SerialCheckerBusMaster master(checker, port, handleReply, &results);
+    std::vector<uint32_t> intervals(nodes.size());
+    for(size_t i = 0; i < nodes.size(); i++){
+        // Node 00 is the important one, polled every 10 ms. The rest want polling every 60 ms.
+        intervals[i] = i == 0 ? 10000 : 60000;
+        if(scheduled){
+            master.addNode(nodes[i]->address, (char*)"R", intervals[i], i == 0 ? 1 : 0);
+        }
+        else{
+            master.addNode(nodes[i]->address, (char*)"R", 0, 0);
+        }
+    }
+    if(scheduled){
+        master.setTimeoutLimits(2000, 20000);
+        master.setDeadAfter(3, 250000);
+    }
+    else{
+        master.setTimeoutLimits(20000, 20000);
+        master.setDeadAfter(0, 0);
+    }
+
+    uint32_t start = millis();
+    while(millis() - start < seconds * 1000){
+        master.update(5);
+    }
+    double elapsed = (millis() - start) / 1000.0;
+
+    uint64_t total = 0;
+    printf("%s\n%-6s %10s %10s %12s %10s %10s %10s %10s %s\n", name, "node", "polls/s", "replies/s", "wanted/s", "timeouts", "late", "resp us", "timeout us", "");
+    for(size_t i = 0; i < nodes.size(); i++){
+        BusNodeStats stats = master.getStats(i);
+        printf("%-6s %10.1f %10.1f %12.1f %10llu %10llu %10u %10u %s\n", nodes[i]->address, stats.polls / elapsed, results.replies[i] / elapsed, 1e6 / intervals[i],
+            (unsigned long long)stats.timeouts, (unsigned long long)stats.lateReplies, stats.responseMicros, stats.timeoutMicros, nodes[i]->responseMicros == 0 ? "dead" : (nodes[i]->wakeMillis ? "wakes late" : ""));
+        total += results.replies[i];
+    }
+    printf("%.0f replies/s, line waiting for answered polls %.0f%% of the time and for timeouts %.0f%%, %llu stray, %llu wrong\n\n", total / elapsed,
+        master.getReplyMicros() / 1e4 / elapsed, master.getTimeoutMicros() / 1e4 / elapsed, (unsigned long long)master.getStrayCount(), (unsigned long long)results.wrong);
+    return results.wrong ? 0 : total;
+}
+
+int main(int argc, char** argv){
+    uint32_t nodeCount = argc > 1 ? atoi(argv[1]) : 12;
+    uint32_t seconds = argc > 2 ? atoi(argv[2]) : 3;
+    uint32_t baud = argc > 3 ? atoi(argv[3]) : 115200;
+    if(nodeCount < 4 || nodeCount > 99){
+        fprintf(stderr, "the number of nodes must be between 4 and 99\n");
+        return 2;
+    }
+
+    int masterFd = openMaster();
+    PosixSerial masterPort(ptsname(masterFd));
+    if(!masterPort.isOpen()){
+        perror("open pty slave");
+        return 1;
+    }
+    std::atomic<bool> running(true);
+    std::vector<SimNode*> nodes;
+    std::vector<PosixSerial*> relayPorts;
+    uint32_t start = millis();
+    for(uint32_t i = 0; i < nodeCount; i++){
+        SimNode* node = new SimNode();
+        makeAddress(i, node->address);
+        node->responseMicros = 200 + (i * 397) % 1800; // 0.2 to 2 ms
+        node->wakeMillis = 0;
+        if(i == nodeCount - 1 || i == nodeCount - 3){
+            node->responseMicros = 0;
+        }
+        if(i == nodeCount - 2){
+            node->wakeMillis = seconds * 1000 * 3 / 2; // half way through the second run
+        }
+        node->relayFd = openMaster();
+        relayPorts.push_back(new PosixSerial(node->relayFd));
+        relayPorts.back()->begin(baud); // raw
+        snprintf(node->path, sizeof(node->path), "%s", ptsname(node->relayFd)); // ptsname() reuses its buffer
+        node->thread = std::thread(simulateNode, node, start, &running);
+        nodes.push_back(node);
+    }
+    PosixSerial relayPort(masterFd);
+    relayPort.begin(baud);
+    std::thread line(relay, masterFd, &nodes, 10000000 / baud, &running);
+    usleep(100000); // let the nodes open their ports
+
+    printf("%u nodes at %u baud, %u s per run\n\n", nodeCount, baud, seconds);
+    uint64_t inTurn = run("polling in turn, 20 ms timeout", masterPort, nodes, seconds, false);
+    uint64_t scheduled = run("scheduled", masterPort, nodes, seconds, true);
+
+    running = false;
+    line.join();
+    for(SimNode* node : nodes){
+        node->thread.join();
+        delete node;
+    }
+    for(PosixSerial* port : relayPorts){
+        delete port;
+    }
+    return inTurn && scheduled ? 0 : 1;
+}
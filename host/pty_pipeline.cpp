@@ -0,0 +1,162 @@
+/**
+ * @brief      Example of sequence numbers, see SerialChecker::enableSeqNum(). The pc sends commands over a pty pair to a simulated arduino that answers each one after a delay, standing in for the round trip time of a USB serial link and the time taken to carry out the command. Every fourth command takes longer so the replies come back out of order. With a window of 1 the pc waits for every reply, which is what the bare Ack/Nak replies used to force. With a bigger window several commands are in flight at once and replies are matched to commands by their sequence numbers.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -pthread -I.. ../SerialChecker.cpp ../PosixSerial.cpp pty_pipeline.cpp -o pty_pipeline
+ *
+ *              With a batch size above 1 the simulated arduino uses enableAckBatching() so that one Ack frame covers the commands answered within 1 ms of each other, and the reply bytes per command go down.
+ *
+ *              Usage: pty_pipeline [commands] [delay us] [window] [Ack batch size]
+ */
+#include "SerialChecker.h"
+
+#include<fcntl.h>
+#include<stdio.h>
+#include<stdlib.h>
+
+#include<atomic>
+#include<deque>
+#include<thread>
+#include<vector>
+
+struct PendingReply{
+    uint8_t seqNum;
+    bool ack;
+    uint32_t due;
+};
+
+static void simulateArduino(PosixSerial* port, uint32_t delay, uint8_t batch, std::atomic<bool>* running){
+    SerialChecker arduino(32, *port, 115200);
+    arduino.init();
+    arduino.enableChecksum();
+    arduino.enableSeqNum();
+    arduino.enableAckNak();
+    if(batch > 1){
+        arduino.enableAckBatching(batch, 1000); // hold Acks back for up to 1 ms
+    }
+    std::vector<PendingReply> pending;
+    while(*running){
+        port->waitReadable(pending.empty() ? 1 : 0);
+        while(arduino.check()){
+            bool ack = arduino.contains('V');
+            uint32_t extra = arduino.toInt32() % 4 == 3 ? 3 * delay : 0;
+            pending.push_back({ arduino.getSeqNum(), ack, micros() + delay + extra });
+        }
+        uint32_t now = micros();
+        for(size_t i = 0; i < pending.size();){
+            if((int32_t)(now - pending[i].due) >= 0){
+                if(pending[i].ack){
+                    arduino.sendAck(pending[i].seqNum);
+                }
+                else{
+                    arduino.sendNak(pending[i].seqNum);
+                }
+                pending.erase(pending.begin() + i);
+            }
+            else{
+                i++;
+            }
+        }
+    }
+}
+
+/**
+ * @brief      Sends the commands keeping up to window of them in flight.
+ *
+ * @return     The number of commands acknowledged.
+ */
+static uint32_t runCommands(SerialChecker& pc, PosixSerial& port, uint32_t commands, uint32_t window, uint32_t& outOfOrder, uint32_t& replyBytes){
+    bool inFlight[SERIALCHECKER_SEQ_COUNT] = {};
+    uint32_t flying = 0;
+    uint32_t sent = 0;
+    uint32_t acked = 0;
+    std::deque<uint8_t> order; // sequence numbers in the order they were sent
+    char command[16];
+    outOfOrder = 0;
+    replyBytes = 0;
+    while(acked < commands){
+        while(sent < commands && flying < window){
+            snprintf(command, sizeof(command), "V%u", sent++);
+            uint8_t seqNum = pc.sendFrame(command);
+            inFlight[seqNum] = true;
+            order.push_back(seqNum);
+            flying++;
+        }
+        if(!port.waitReadable(1000)){
+            fprintf(stderr, "timed out with %u commands in flight\n", flying);
+            break;
+        }
+        while(pc.check()){
+            replyBytes += pc.getRawMsgLen() + 4; // the sequence number, checksum and ETX too
+            uint8_t first = pc.getSeqNum();
+            if(first == SERIALCHECKER_SEQ_NONE){
+                continue;
+            }
+            // A batched Ack is for every message in its bitmap, a Nak just for one.
+            uint32_t bitmap = pc.isAck() ? pc.getAckBitmap() : 1;
+            for(uint8_t i = 0; bitmap; i++, bitmap >>= 1){
+                uint8_t seqNum = (first + i) & (SERIALCHECKER_SEQ_COUNT - 1);
+                if(!(bitmap & 1) || !inFlight[seqNum]){
+                    continue;
+                }
+                inFlight[seqNum] = false;
+                flying--;
+                if(pc.isAck()){
+                    acked++;
+                }
+                if(seqNum != order.front()){
+                    outOfOrder++;
+                }
+                while(!order.empty() && !inFlight[order.front()]){
+                    order.pop_front();
+                }
+            }
+        }
+    }
+    return acked;
+}
+
+int main(int argc, char** argv){
+    uint32_t commands = argc > 1 ? atoi(argv[1]) : 2000;
+    uint32_t delay = argc > 2 ? atoi(argv[2]) : 500;
+    uint32_t window = argc > 3 ? atoi(argv[3]) : 32;
+    uint8_t batch = argc > 4 ? atoi(argv[4]) : 1;
+    if(window < 1 || window > SERIALCHECKER_SEQ_COUNT / 2){
+        fprintf(stderr, "the window must be between 1 and %d\n", SERIALCHECKER_SEQ_COUNT / 2);
+        return 2;
+    }
+
+    int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(masterFd < 0 || grantpt(masterFd) || unlockpt(masterFd)){
+        perror("posix_openpt");
+        return 1;
+    }
+    PosixSerial pcPort(masterFd);
+    PosixSerial arduinoPort(ptsname(masterFd));
+    if(!arduinoPort.isOpen()){
+        perror("open pty slave");
+        return 1;
+    }
+    std::atomic<bool> running(true);
+    std::thread arduino(simulateArduino, &arduinoPort, delay, batch, &running);
+
+    SerialChecker pc(32, pcPort, 115200);
+    pc.init();
+    pc.enableChecksum();
+    pc.enableSeqNum();
+
+    bool allAcked = true;
+    uint32_t windows[] = { 1, window };
+    for(uint32_t w : windows){
+        uint32_t outOfOrder;
+        uint32_t replyBytes;
+        uint32_t start = micros();
+        uint32_t acked = runCommands(pc, pcPort, commands, w, outOfOrder, replyBytes);
+        double elapsed = (micros() - start) / 1e6;
+        printf("window %3u: %u of %u commands acknowledged in %.3f s (%.0f commands/s, %u replies out of order, %.1f reply bytes per command)\n", w, acked, commands, elapsed, commands / elapsed, outOfOrder, (double)replyBytes / commands);
+        allAcked &= acked == commands;
+    }
+    running = false;
+    arduino.join();
+    return allAcked ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+/**
+ * @brief      Shows an urgent frame getting through while bulk data streams faster than the line can carry it. A node thread streams bulk readings at twice what a 115200 baud line carries, sends a control frame every 20 ms and an "HV TRIP" frame every 50 ms. The host end of the pty is read at the line rate, so whatever the node writes beyond that piles up in the kernel's buffer, as it would in a USB adapter's.
+ *
+ *              The run is done twice. First every frame goes straight to the port with sendFrame(), so each HV TRIP waits behind all of the bulk data already written. Then with priority queues, see SerialChecker::enableTxQueue(), bulk frames only go to the port when nothing else is waiting and there is room, so HV TRIP waits behind no more than a buffer's worth. The host times each HV TRIP from when the node sent it to when it arrived.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -pthread -I.. ../SerialChecker.cpp ../PosixSerial.cpp pty_priority.cpp -o pty_priority
+ *
+ *              Usage: pty_priority [seconds per run]
+ */
+#include "SerialChecker.h"
+
+#include<fcntl.h>
+#include<poll.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+
+#include<atomic>
+#include<thread>
+
+#define PTY_PRIORITY_BAUDRATE 115200
+
+struct Latency{
+    uint32_t count;
+    uint32_t totalMicros;
+    uint32_t maxMicros;
+};
+
+/**
+ * @brief      The node: bulk readings as fast as it can make them, which is twice the line rate, with control and HV TRIP frames between them.
+ */
+static void simulateNode(const char* path, bool queued, std::atomic<bool>* running){
+    static uint8_t criticalQueue[128];
+    static uint8_t controlQueue[128];
+    static uint8_t bulkQueue[256];
+    PosixSerial port(path);
+    SerialChecker checker(48, port, PTY_PRIORITY_BAUDRATE);
+    checker.init();
+    checker.enableChecksum();
+    checker.setChecksumType(checksumTypeEnum::SpellmanMPS);
+    if(queued){
+        checker.enableTxQueue(txPriorityEnum::Critical, criticalQueue, sizeof(criticalQueue));
+        checker.enableTxQueue(txPriorityEnum::Control, controlQueue, sizeof(controlQueue));
+        checker.enableTxQueue(txPriorityEnum::Bulk, bulkQueue, sizeof(bulkQueue));
+    }
+    char frame[48];
+    uint32_t count = 0; // bulk frames
+    uint32_t controlCount = 0;
+    uint32_t tripCount = 0;
+    uint32_t start = micros();
+    uint32_t nextBulk = start;
+    uint32_t nextControl = start;
+    uint32_t nextTrip = start + 25000;
+    while(*running){
+        uint32_t now = micros();
+        if((int32_t)(now - nextTrip) >= 0){
+            snprintf(frame, sizeof(frame), "HV TRIP,%u", (unsigned)micros());
+            queued ? checker.sendFrame(frame, txPriorityEnum::Critical) : checker.sendFrame(frame);
+            nextTrip += 50000;
+            tripCount++;
+        }
+        if((int32_t)(now - nextControl) >= 0){
+            snprintf(frame, sizeof(frame), "RAMP,%u", (unsigned)controlCount++);
+            queued ? checker.sendFrame(frame, txPriorityEnum::Control) : checker.sendFrame(frame);
+            nextControl += 20000;
+        }
+        if((int32_t)(now - nextBulk) >= 0){
+            int len = snprintf(frame, sizeof(frame), "D%08u,0123456789ABCDEFGHIJKLMNOPQRSTUV", (unsigned)count++);
+            queued ? checker.sendFrame(frame, txPriorityEnum::Bulk) : checker.sendFrame(frame);
+            nextBulk += (len + 2) * 10000000ull / PTY_PRIORITY_BAUDRATE / 2;
+        }
+        checker.check();
+        usleep(50);
+    }
+    if(!queued){
+        // Nothing is queued or dropped, every frame goes to the port as it is made.
+        printf("%u HV TRIP, %u control and %u bulk frames written, none dropped\n", tripCount, controlCount, count);
+    }
+    else{
+        static const char* names[] = { "critical", "control", "bulk" };
+        printf("%-10s %8s %8s %12s %12s %12s\n", "class", "frames", "dropped", "mean us", "max us", "max queued");
+        for(uint8_t i = 0; i < SERIALCHECKER_TX_CLASSES; i++){
+            TxStats stats = checker.getTxStats((txPriorityEnum)i);
+            printf("%-10s %8u %8u %12u %12u %12u\n", names[i], stats.frames, stats.dropped, stats.frames ? stats.totalMicros / stats.frames : 0, stats.maxMicros, stats.maxQueued);
+        }
+    }
+    checker.disableTxQueues();
+}
+
+/**
+ * @brief      The host: reads the pty at the line rate and times every HV TRIP.
+ */
+static Latency runHost(int fd, uint32_t seconds, bool queued, const char* nodePath){
+    Latency latency = {};
+    SerialChecker checker(48);
+    checker.enableChecksum();
+    checker.setChecksumType(checksumTypeEnum::SpellmanMPS);
+    std::atomic<bool> running(true);
+    std::thread node(simulateNode, nodePath, queued, &running);
+    uint32_t start = micros();
+    uint64_t received = 0; // chars the line has carried
+    while(micros() - start < seconds * 1000000){
+        usleep(500);
+        uint64_t carried = (uint64_t)(micros() - start) * PTY_PRIORITY_BAUDRATE / 10000000;
+        char buffer[256];
+        ssize_t len = read(fd, buffer, carried - received < sizeof(buffer) ? carried - received : sizeof(buffer));
+        if(len <= 0){
+            received = carried; // the line was idle
+            continue;
+        }
+        received += len;
+        for(ssize_t i = 0; i < len; i++){
+            if(checker.checkChar(buffer[i]) && checker.contains((char*)"HV TRIP", 0)){
+                uint32_t waited = micros() - checker.toInt32(8);
+                latency.count++;
+                latency.totalMicros += waited;
+                if(waited > latency.maxMicros){
+                    latency.maxMicros = waited;
+                }
+            }
+        }
+    }
+    running = false;
+    // Let the node finish writing.
+    while(node.joinable()){
+        char buffer[4096];
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if(poll(&pfd, 1, 10) > 0 && read(fd, buffer, sizeof(buffer)) > 0){
+            continue;
+        }
+        node.join();
+    }
+    return latency;
+}
+
+int main(int argc, char** argv){
+    uint32_t seconds = argc > 1 ? atoi(argv[1]) : 3;
+    Latency results[2];
+    for(uint8_t queued = 0; queued < 2; queued++){
+        int fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if(fd < 0 || grantpt(fd) || unlockpt(fd)){
+            perror("posix_openpt");
+            return 1;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        char nodePath[64];
+        snprintf(nodePath, sizeof(nodePath), "%s", ptsname(fd));
+        printf("%s\n", queued ? "\nWith priority queues" : "Straight to the port");
+        results[queued] = runHost(fd, seconds, queued, nodePath);
+        close(fd);
+    }
+    printf("\n%-22s %8s %12s %12s\n", "HV TRIP", "frames", "mean us", "max us");
+    printf("%-22s %8u %12u %12u\n", "straight to the port", results[0].count, results[0].count ? results[0].totalMicros / results[0].count : 0, results[0].maxMicros);
+    printf("%-22s %8u %12u %12u\n", "priority queues", results[1].count, results[1].count ? results[1].totalMicros / results[1].count : 0, results[1].maxMicros);
+    return results[1].count && results[1].maxMicros < results[0].maxMicros ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/**
+ * @brief      Drives SerialCheckerRegisters over a pty pair and checks every reply. The node on the slave end has a register table with address N, group address G and broadcast address *, and answers get and set messages through check(). The host on the master end sends the messages and reads the replies. Both use sequence numbers, so Acks and Naks come back as frames that isAck() and isNak() pick out.
+ *
+ *              It checks gets by name, by several names, by number and of every register, a reply cut short at SERIALCHECKER_FRAME_BUFFER_LEN, sets that are Acked, sets to read only, out of range and unknown registers that are Naked, group and broadcast messages that are acted on without a reply, and sketch messages still being returned by check().
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../SerialCheckerKeyValue.cpp ../SerialCheckerRegisters.cpp ../PosixSerial.cpp pty_registers.cpp -o pty_registers
+ *
+ *              Usage: pty_registers
+ */
+#include "SerialCheckerRegisters.h"
+
+#include<fcntl.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#define PTY_REGISTERS_MSG_MAX_LEN 64
+
+static float temperature = 22.5;
+static int16_t rampRate = 10;
+static int32_t reading = 512;
+static float offset = 0;
+static float pressureLimit = 1013.25;
+
+static uint32_t failures = 0;
+
+/**
+ * @brief      What came back for one message.
+ */
+struct Exchange{
+    char reply[PTY_REGISTERS_MSG_MAX_LEN + 1]; // "ACK", "NAK", the reply frame's message, or "" if there was no reply
+    uint8_t sketchMessages; // messages check() returned to the sketch
+    char sketchMessage[PTY_REGISTERS_MSG_MAX_LEN + 1];
+};
+
+/**
+ * @brief      Sends a message from the host, lets the node's check() deal with it, and reads back what the node sent.
+ */
+static Exchange transact(SerialChecker& host, PosixSerial& hostPort, SerialChecker& node, PosixSerial& nodePort, const char* message){
+    Exchange exchange = {};
+    char copy[PTY_REGISTERS_MSG_MAX_LEN + 1];
+    snprintf(copy, sizeof(copy), "%s", message);
+    host.sendFrame(copy);
+    while(nodePort.waitReadable(50)){
+        while(node.check()){
+            if(!exchange.sketchMessages++){
+                snprintf(exchange.sketchMessage, sizeof(exchange.sketchMessage), "%s", node.getRawMsg());
+            }
+        }
+    }
+    while(hostPort.waitReadable(50)){
+        if(host.check()){
+            if(host.isAck()){
+                strcpy(exchange.reply, "ACK");
+            }
+            else if(host.isNak()){
+                strcpy(exchange.reply, "NAK");
+            }
+            else{
+                snprintf(exchange.reply, sizeof(exchange.reply), "%s", host.getRawMsg());
+            }
+            break;
+        }
+    }
+    return exchange;
+}
+
+static void expect(const char* message, const Exchange& exchange, const char* reply, uint8_t sketchMessages){
+    bool ok = strcmp(exchange.reply, reply) == 0 && exchange.sketchMessages == sketchMessages;
+    printf("%-4s %-24s -> %s%s\n", ok ? "ok" : "FAIL", message, exchange.reply[0] ? exchange.reply : "(no reply)", exchange.sketchMessages ? " (returned to the sketch)" : "");
+    if(!ok){
+        printf("     expected %s, %u returned to the sketch\n", reply[0] ? reply : "no reply", sketchMessages);
+        failures++;
+    }
+}
+
+static void expectValue(const char* name, bool ok){
+    printf("%-4s %s\n", ok ? "ok" : "FAIL", name);
+    if(!ok){
+        failures++;
+    }
+}
+
+int main(){
+    int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if(masterFd < 0 || grantpt(masterFd) || unlockpt(masterFd)){
+        perror("posix_openpt");
+        return 1;
+    }
+    PosixSerial hostPort(masterFd);
+    PosixSerial nodePort(ptsname(masterFd));
+    if(!nodePort.isOpen()){
+        perror("open pty slave");
+        return 1;
+    }
+    SerialChecker host(PTY_REGISTERS_MSG_MAX_LEN, hostPort, 115200);
+    SerialChecker node(PTY_REGISTERS_MSG_MAX_LEN, nodePort, 115200);
+    SerialChecker* checkers[2] = { &host, &node };
+    for(SerialChecker* checker : checkers){
+        checker->init();
+        checker->enableChecksum();
+        checker->enableAckNak();
+        checker->enableSeqNum();
+    }
+    node.setAddressLen(1);
+    node.addAddress((char*)"N", addressKindEnum::Unicast);
+    node.addAddress((char*)"G", addressKindEnum::Group);
+    node.addAddress((char*)"*", addressKindEnum::Broadcast);
+
+    SerialCheckerRegisters registers(node, 5);
+    registers.add("T", &temperature, -20.0, 80.0);
+    registers.add("RAMP", &rampRate, 0, 100);
+    registers.add("V", &reading, 0, 1023);
+    registers.add("OFFSET_CALIBRATION", &offset, -10.0, 10.0);
+    registers.add("PRESSURE_LIMIT_HIGH", &pressureLimit, 0.0, 2000.0);
+    registers.setReadOnly("V");
+
+    const char* gets[][2] = {
+        { "N?T", "NT=22.500" },
+        { "N?T,RAMP", "NT=22.500,RAMP=10" },
+        { "N?1", "NRAMP=10" },
+        { "N?4", "NPRESSURE_LIMIT_HIGH=1013.250" },
+        // All five would take 77 chars, more than the 59 that fit in SERIALCHECKER_FRAME_BUFFER_LEN with the framing, so the last one is left off.
+        { "N?", "NT=22.500,RAMP=10,V=512,OFFSET_CALIBRATION=0.000" },
+        { "N?V,OFFSET_CALIBRATION,PRESSURE_LIMIT_HIGH", "NV=512,OFFSET_CALIBRATION=0.000" },
+        { "N?X", "NAK" },
+        { "N?5", "NAK" },
+        { "N?T,X", "NAK" },
+    };
+    for(auto& get : gets){
+        expect(get[0], transact(host, hostPort, node, nodePort, get[0]), get[1], 0);
+    }
+
+    expect("N!T=25.5,RAMP=4", transact(host, hostPort, node, nodePort, "N!T=25.5,RAMP=4"), "ACK", 0);
+    expectValue("T and RAMP set", temperature == 25.5f && rampRate == 4);
+    expect("N!1=7", transact(host, hostPort, node, nodePort, "N!1=7"), "ACK", 0);
+    expectValue("RAMP set by number", rampRate == 7);
+    expect("N!V=3", transact(host, hostPort, node, nodePort, "N!V=3"), "NAK", 0);
+    expectValue("read only V left alone", reading == 512);
+    expect("N!RAMP=101", transact(host, hostPort, node, nodePort, "N!RAMP=101"), "NAK", 0);
+    expectValue("out of range RAMP left alone", rampRate == 7);
+    expect("N!Q=1", transact(host, hostPort, node, nodePort, "N!Q=1"), "NAK", 0);
+    expect("N!T=30,Q=1", transact(host, hostPort, node, nodePort, "N!T=30,Q=1"), "NAK", 0);
+    expectValue("T still set beside an unknown register", temperature == 30.0f);
+
+    expect("G!RAMP=9", transact(host, hostPort, node, nodePort, "G!RAMP=9"), "", 0);
+    expectValue("RAMP set by a group message", rampRate == 9);
+    expect("*!RAMP=500", transact(host, hostPort, node, nodePort, "*!RAMP=500"), "", 0);
+    expectValue("out of range RAMP left alone by a broadcast", rampRate == 9);
+    expect("G?T", transact(host, hostPort, node, nodePort, "G?T"), "", 0);
+    expect("*?", transact(host, hostPort, node, nodePort, "*?"), "", 0);
+    expect("M?T", transact(host, hostPort, node, nodePort, "M?T"), "", 0);
+
+    Exchange sketch = transact(host, hostPort, node, nodePort, "NHELLO");
+    expect("NHELLO", sketch, "", 1);
+    expectValue("sketch message is NHELLO", strcmp(sketch.sketchMessage, "NHELLO") == 0);
+    expect("GSTOP", transact(host, hostPort, node, nodePort, "GSTOP"), "", 1);
+
+    printf("%s\n", failures ? "FAILED" : "all replies as expected");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+/**
+ * @brief      Replays a recording made with SerialChecker::dumpRecorder(). The dump is read from a text file saved from the serial monitor (anything before the REC line and after REC END is ignored) and every recorded char is fed through a SerialChecker with the given settings. A timeline of the messages is printed and each accepted or rejected message is checked against what the arduino recorded, so a fault can be looked at on the PC with the same code that saw it.
+ *
+ *              The ring buffer may have overwritten the start of the first message, so the recorded and replayed events are only compared after the first recorded event.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -I.. ../SerialChecker.cpp ../PosixSerial.cpp CheckerSettings.cpp replay_dump.cpp -o replay_dump
+ *
+ *              Usage: replay_dump [options] dump_file
+ *                  the -c -s -S -e -a -m -n -r -N -f options of capture_validate, which should match the arduino's settings
+ *                  -q          only print mismatches, not the whole timeline
+ */
+#include "CheckerSettings.h"
+
+#include<ctype.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+
+#include<string>
+#include<vector>
+
+static const char* eventName(uint8_t event){
+    if(event == (uint8_t)recorderEventEnum::Accepted){
+        return "accepted";
+    }
+    return CheckerSettings::reasonName((frameErrorEnum)event);
+}
+
+static void printable(std::string& text, char c){
+    if(c >= 32 && c < 127){
+        text += c;
+    }
+    else{
+        char escaped[8];
+        snprintf(escaped, sizeof(escaped), c == '\n' ? "\\n" : (c == '\r' ? "\\r" : "\\x%02X"), (uint8_t)c);
+        text += escaped;
+    }
+}
+
+/**
+ * @brief      Reads the recorded bytes out of a dump.
+ *
+ * @return     False if the file does not hold a whole dump.
+ */
+static bool readDump(FILE* file, uint32_t& startMicros, int& tickShift, std::vector<uint8_t>& bytes){
+    char line[256];
+    bool started = false;
+    unsigned used = 0;
+    while(fgets(line, sizeof(line), file)){
+        if(!started){
+            unsigned long start;
+            if(sscanf(line, "REC %lu %d %u", &start, &tickShift, &used) == 3){
+                startMicros = start;
+                started = true;
+            }
+            continue;
+        }
+        if(strncmp(line, "REC END", 7) == 0){
+            return bytes.size() == used;
+        }
+        for(char* p = line; isxdigit((unsigned char)p[0]) && isxdigit((unsigned char)p[1]); p += 2){
+            char hex[3] = { p[0], p[1], '\0' };
+            bytes.push_back(strtoul(hex, nullptr, 16));
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv){
+    CheckerSettings settings;
+    bool quiet = false;
+    int opt;
+    while((opt = getopt(argc, argv, CHECKER_SETTINGS_OPTIONS "q")) != -1){
+        if(opt == 'q'){
+            quiet = true;
+        }
+        else if(!settings.parseOption(opt, optarg)){
+            fprintf(stderr, "usage: %s [-c r|s] [-s C | -S C] [-e C] [-a N] [-m N] [-n N] [-r] [-N] [-f A] [-q] dump_file\n", argv[0]);
+            return 2;
+        }
+    }
+    if(optind >= argc){
+        fprintf(stderr, "no dump file given\n");
+        return 2;
+    }
+    FILE* file = fopen(argv[optind], "r");
+    if(!file){
+        perror(argv[optind]);
+        return 2;
+    }
+    uint32_t startMicros = 0;
+    int tickShift = 0;
+    std::vector<uint8_t> bytes;
+    bool whole = readDump(file, startMicros, tickShift, bytes);
+    fclose(file);
+    if(!whole){
+        fprintf(stderr, "%s does not hold a whole REC dump\n", argv[optind]);
+        return 2;
+    }
+
+    uint32_t micros = startMicros;
+    SerialChecker checker(settings.msgMaxLen);
+    settings.configure(checker);
+    std::string received;
+    uint32_t messageMicros = micros;
+    bool synced = false; // set at the first recorded event, after which the replay should match the recording
+    int pending = -1; // the event the replay produced and which the recording should log next
+    unsigned chars = 0, events = 0, mismatches = 0;
+    for(size_t i = 0; i < bytes.size();){
+        uint8_t header = bytes[i++];
+        uint32_t ticks = header & 0x3F;
+        if(ticks == 63){
+            ticks = 0;
+            uint8_t shift = 0;
+            uint8_t b;
+            do{
+                b = bytes[i++];
+                ticks |= (uint32_t)(b & 0x7F) << shift;
+                shift += 7;
+            } while(b & 0x80 && i < bytes.size());
+        }
+        if(i >= bytes.size()){
+            break;
+        }
+        uint8_t data = bytes[i++];
+        if(chars + events){
+            micros += ticks << tickShift; // the first entry's time is the one in the REC line
+        }
+
+        if((recorderEntryEnum)(header >> 6) == recorderEntryEnum::ReceivedChar){
+            chars++;
+            if(received.empty()){
+                messageMicros = micros;
+            }
+            printable(received, data);
+            if(pending >= 0 && synced){
+                printf("%10lu  MISMATCH  recording has no event where the replay %s the message\n", (unsigned long)micros, pending ? "rejected" : "accepted");
+                mismatches++;
+            }
+            pending = -1;
+            if(checker.checkChar(data)){
+                pending = (int)recorderEventEnum::Accepted;
+            }
+            else if(checker.getLastError() != frameErrorEnum::None){
+                pending = (int)checker.getLastError();
+                checker.clearLastError();
+            }
+            continue;
+        }
+
+        events++;
+        if(!quiet){
+            printf("%10lu  %-12s  %s\n", (unsigned long)messageMicros, eventName(data), received.c_str());
+        }
+        if(synced && pending != data){
+            printf("%10lu  MISMATCH  arduino: %s, replay: %s\n", (unsigned long)micros, eventName(data), pending < 0 ? "no event" : eventName(pending));
+            mismatches++;
+        }
+        synced = true;
+        pending = -1;
+        received.clear();
+    }
+    printf("\n%u chars, %u events, %u mismatches, %.3f s recorded\n", chars, events, mismatches, (micros - startMicros) / 1e6);
+    return mismatches ? 1 : 0;
+}
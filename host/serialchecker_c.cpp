@@ -0,0 +1,237 @@
+#include "serialchecker_c.h"
+#include "SerialChecker.h"
+#include "ChecksumSIMD.h"
+
+/**
+ * @brief      Longest message the batch number conversions look at. Longer messages are cut short.
+ */
+#define SC_PARSE_MAX_LEN 255
+
+struct sc_framer{
+    SerialChecker checker;
+    uint8_t pendingLen = 0; // a message that didn't fit in the output, still in the checker's buffer
+    sc_framer(int32_t msgMaxLen) : checker(msgMaxLen){}
+};
+
+static char checksumOf(int32_t checksumType, const char* message, int32_t len){
+    if(checksumType == SC_CHECKSUM_SPELLMAN_MPS){
+        return ChecksumSIMD::chksmSpellmanMPS(message, len);
+    }
+    return ChecksumSIMD::chksm8bitAllReadableChars(message, len);
+}
+
+/**
+ * @brief      Version of this interface. It goes up when a function is added or changed so that callers can check they have a library they understand.
+ *
+ * @return     The version.
+ */
+int32_t sc_version(void){
+    return 2;
+}
+
+/**
+ * @brief      Calculates the checksum char of one message. Same as SerialChecker::calcChecksum().
+ *
+ * @param[in]  checksumType  SC_CHECKSUM_SPELLMAN_MPS or SC_CHECKSUM_READABLE_8BIT
+ * @param[in]  message       The message including the address if there is one
+ * @param[in]  len           The length of the message
+ *
+ * @return     The checksum char.
+ */
+char sc_checksum(int32_t checksumType, const char* message, int32_t len){
+    return checksumOf(checksumType, message, len);
+}
+
+/**
+ * @brief      Calculates the checksum chars of a batch of messages that are stored back to back in one buffer.
+ *
+ * @param[in]  checksumType  SC_CHECKSUM_SPELLMAN_MPS or SC_CHECKSUM_READABLE_8BIT
+ * @param[in]  messages      The messages, back to back
+ * @param[in]  lengths       The length of each message
+ * @param[in]  count         The number of messages
+ * @param      checksums     Filled with one checksum char per message
+ *
+ * @return     The number of checksums calculated.
+ */
+int32_t sc_checksum_batch(int32_t checksumType, const char* messages, const int32_t* lengths, int32_t count, char* checksums){
+    if(checksumType == SC_CHECKSUM_SPELLMAN_MPS){
+        ChecksumSIMD::chksmSpellmanMPSBatch(messages, lengths, count, checksums);
+    }
+    else{
+        ChecksumSIMD::chksm8bitAllReadableCharsBatch(messages, lengths, count, checksums);
+    }
+    return count;
+}
+
+/**
+ * @brief      Checks a batch of received messages that each end in their checksum char, stored back to back in one buffer.
+ *
+ * @param[in]  checksumType  SC_CHECKSUM_SPELLMAN_MPS or SC_CHECKSUM_READABLE_8BIT
+ * @param[in]  messages      The messages with their checksum chars but without STX or ETX chars, back to back
+ * @param[in]  lengths       The length of each message including the checksum char
+ * @param[in]  count         The number of messages
+ * @param      valid         Set to 1 for each message whose checksum matches and 0 otherwise
+ *
+ * @return     The number of valid messages.
+ */
+int32_t sc_verify_batch(int32_t checksumType, const char* messages, const int32_t* lengths, int32_t count, uint8_t* valid){
+    int32_t validCount = 0;
+    for(int32_t i = 0; i < count; i++){
+        int32_t len = lengths[i];
+        valid[i] = len > 0 && messages[len - 1] == checksumOf(checksumType, messages, len - 1);
+        validCount += valid[i];
+        messages += len;
+    }
+    return validCount;
+}
+
+/**
+ * @brief      Creates a framer, which splits a stream of received chars in to messages the same way SerialChecker::check() does. It keeps any unfinished message between calls to sc_framer_split(). The defaults are the same as SerialChecker's: no STX, '\n' ETX, no checksum.
+ *
+ * @param[in]  msgMaxLen  The message maximum length, 1 to 255 as SerialChecker keeps lengths in a byte
+ *
+ * @return     The framer, or NULL if msgMaxLen is out of range. Free it with sc_framer_destroy().
+ */
+sc_framer* sc_framer_create(int32_t msgMaxLen){
+    if(msgMaxLen < 1 || msgMaxLen > 255){
+        return NULL;
+    }
+    return new sc_framer(msgMaxLen);
+}
+
+void sc_framer_destroy(sc_framer* framer){
+    delete framer;
+}
+
+/**
+ * @brief      Same as SerialChecker::enableSTX() or, if useSTX is 0, disableSTX().
+ */
+void sc_framer_set_stx(sc_framer* framer, int32_t useSTX, int32_t requireSTX, char STX){
+    if(useSTX){
+        framer->checker.enableSTX(requireSTX, STX);
+    }
+    else{
+        framer->checker.disableSTX();
+    }
+}
+
+/**
+ * @brief      Same as SerialChecker::setETX().
+ */
+void sc_framer_set_etx(sc_framer* framer, char ETX){
+    framer->checker.setETX(ETX);
+}
+
+/**
+ * @brief      Same as SerialChecker::enableChecksum() or, if useChecksum is 0, disableChecksum(), plus setChecksumType().
+ */
+void sc_framer_set_checksum(sc_framer* framer, int32_t useChecksum, int32_t checksumType){
+    if(useChecksum){
+        framer->checker.enableChecksum();
+    }
+    else{
+        framer->checker.disableChecksum();
+    }
+    framer->checker.setChecksumType(checksumType == SC_CHECKSUM_SPELLMAN_MPS ? checksumTypeEnum::SpellmanMPS : checksumTypeEnum::Readable8bitChars);
+}
+
+/**
+ * @brief      Same as SerialChecker::setAllowCR().
+ */
+void sc_framer_set_allow_cr(sc_framer* framer, int32_t allowCR){
+    framer->checker.setAllowCR(allowCR);
+}
+
+/**
+ * @brief      Same as SerialChecker::setMsgMinLen().
+ */
+void sc_framer_set_min_len(sc_framer* framer, int32_t msgMinLen){
+    framer->checker.setMsgMinLen(msgMinLen);
+}
+
+/**
+ * @brief      Splits received chars in to valid messages. Messages that fail the length or checksum checks are dropped, exactly as check() drops them. The valid messages are copied back to back in to the messages buffer without STX, checksum or ETX chars. If the output fills up, the function stops early and consumed says where to carry on from. A message that was complete but didn't fit is kept by the framer and comes out first on the next call. If it is bigger than messagesSize on its own, the next call returns 0 with consumed 0, and the caller needs a bigger messages buffer.
+ *
+ * @param      framer        The framer
+ * @param[in]  buffer        The received chars
+ * @param[in]  len           The number of received chars
+ * @param      messages      Filled with the valid messages, back to back
+ * @param[in]  messagesSize  The size of the messages buffer
+ * @param      lengths       Filled with the length of each message
+ * @param[in]  maxCount      The size of the lengths array
+ * @param      consumed      Set to the number of chars of buffer that were used
+ *
+ * @return     The number of messages found.
+ */
+int32_t sc_framer_split(sc_framer* framer, const char* buffer, int32_t len, char* messages, int32_t messagesSize, int32_t* lengths, int32_t maxCount, int32_t* consumed){
+    int32_t count = 0;
+    int32_t used = 0;
+    int32_t i = 0;
+    if(framer->pendingLen){
+        if(framer->pendingLen > messagesSize || maxCount < 1){
+            *consumed = 0;
+            return 0;
+        }
+        memcpy(messages, framer->checker.getRawMsg(), framer->pendingLen);
+        used = framer->pendingLen;
+        lengths[count++] = framer->pendingLen;
+        framer->pendingLen = 0;
+    }
+    while(i < len && count < maxCount){
+        uint8_t msgLen = framer->checker.checkChar(buffer[i++]);
+        if(msgLen){
+            if(used + msgLen > messagesSize){
+                // Its chars have been used, so it is kept until the next call rather than dropped.
+                framer->pendingLen = msgLen;
+                break;
+            }
+            memcpy(&messages[used], framer->checker.getRawMsg(), msgLen);
+            used += msgLen;
+            lengths[count++] = msgLen;
+        }
+    }
+    *consumed = i;
+    return count;
+}
+
+/**
+ * @brief      Converts each message in a batch to a float with SerialChecker::toFloat().
+ *
+ * @param[in]  messages    The messages, back to back
+ * @param[in]  lengths     The length of each message
+ * @param[in]  count       The number of messages
+ * @param[in]  startIndex  Where the number starts in each message, or -1 to start from the first digit or minus sign as toFloat() does
+ * @param      values      Filled with one value per message
+ *
+ * @return     The number of values converted.
+ */
+int32_t sc_to_float_batch(const char* messages, const int32_t* lengths, int32_t count, int32_t startIndex, float* values){
+    SerialChecker parser(SC_PARSE_MAX_LEN);
+    for(int32_t i = 0; i < count; i++){
+        parser.loadMsg(messages, lengths[i] < SC_PARSE_MAX_LEN ? lengths[i] : SC_PARSE_MAX_LEN);
+        values[i] = startIndex < 0 ? parser.toFloat() : parser.toFloat(startIndex);
+        messages += lengths[i];
+    }
+    return count;
+}
+
+/**
+ * @brief      Converts each message in a batch to an int32_t with SerialChecker::toInt32().
+ *
+ * @param[in]  messages    The messages, back to back
+ * @param[in]  lengths     The length of each message
+ * @param[in]  count       The number of messages
+ * @param[in]  startIndex  Where the number starts in each message, or -1 to start from the first digit or minus sign as toInt32() does
+ * @param      values      Filled with one value per message
+ *
+ * @return     The number of values converted.
+ */
+int32_t sc_to_int32_batch(const char* messages, const int32_t* lengths, int32_t count, int32_t startIndex, int32_t* values){
+    SerialChecker parser(SC_PARSE_MAX_LEN);
+    for(int32_t i = 0; i < count; i++){
+        parser.loadMsg(messages, lengths[i] < SC_PARSE_MAX_LEN ? lengths[i] : SC_PARSE_MAX_LEN);
+        values[i] = startIndex < 0 ? parser.toInt32() : parser.toInt32(startIndex);
+        messages += lengths[i];
+    }
+    return count;
+}
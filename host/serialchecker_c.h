@@ -0,0 +1,49 @@
+#ifndef SERIALCHECKER_C_H
+#define SERIALCHECKER_C_H
+
+/**
+ * @brief      C interface to SerialChecker for LabVIEW's Call Library Function Node, Python ctypes and anything else that can load a shared library. Host software can then use the same checksum, framing and number conversion code as the arduino rather than its own copy, and can work on whole batches of messages in one call.
+ *
+ *              Every function only takes plain ints, floats and char arrays so that no structs need to be set up on the calling side. Batches of messages are passed as one buffer with the messages back to back plus an array of their lengths.
+ *
+ *              Build from this folder with:
+ *              g++ -O2 -shared -fPIC -I.. ../SerialChecker.cpp ../PosixSerial.cpp ChecksumSIMD.cpp serialchecker_c.cpp -o libserialchecker.so
+ */
+
+#include<stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Values for the checksumType arguments. They match checksumTypeEnum.
+ */
+#define SC_CHECKSUM_SPELLMAN_MPS 0
+#define SC_CHECKSUM_READABLE_8BIT 1
+
+typedef struct sc_framer sc_framer;
+
+int32_t sc_version(void);
+
+char sc_checksum(int32_t checksumType, const char* message, int32_t len);
+int32_t sc_checksum_batch(int32_t checksumType, const char* messages, const int32_t* lengths, int32_t count, char* checksums);
+int32_t sc_verify_batch(int32_t checksumType, const char* messages, const int32_t* lengths, int32_t count, uint8_t* valid);
+
+sc_framer* sc_framer_create(int32_t msgMaxLen);
+void sc_framer_destroy(sc_framer* framer);
+void sc_framer_set_stx(sc_framer* framer, int32_t useSTX, int32_t requireSTX, char STX);
+void sc_framer_set_etx(sc_framer* framer, char ETX);
+void sc_framer_set_checksum(sc_framer* framer, int32_t useChecksum, int32_t checksumType);
+void sc_framer_set_allow_cr(sc_framer* framer, int32_t allowCR);
+void sc_framer_set_min_len(sc_framer* framer, int32_t msgMinLen);
+int32_t sc_framer_split(sc_framer* framer, const char* buffer, int32_t len, char* messages, int32_t messagesSize, int32_t* lengths, int32_t maxCount, int32_t* consumed);
+
+int32_t sc_to_float_batch(const char* messages, const int32_t* lengths, int32_t count, int32_t startIndex, float* values);
+int32_t sc_to_int32_batch(const char* messages, const int32_t* lengths, int32_t count, int32_t startIndex, int32_t* values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif